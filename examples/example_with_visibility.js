@@ -47,7 +47,7 @@ function createWindow() {
   streamlabs_overlays.setPosition(overlayid1, 100, 200, Number(win1_rect.width), Number(win1_rect.height));
 
   win1.webContents.on('paint', (event, dirty, image) => {
-    streamlabs_overlays.paintOverlay(overlayid1, image.getSize().width, image.getSize().height, image.getBitmap());
+    streamlabs_overlays.paintOverlay(overlayid1, image.getSize().width, image.getSize().height, image.getBitmap(), dirty);
   })
 
   win1.webContents.setFrameRate(frame_rate);
@@ -76,7 +76,7 @@ function createWindow() {
   streamlabs_overlays.setPosition(overlayid2, 200, 100, Number(win2_rect.width), Number(win2_rect.height));
   
   win2.webContents.on('paint', (event, dirty, image) => {
-    streamlabs_overlays.paintOverlay(overlayid2, image.getSize().width, image.getSize().height, image.getBitmap());
+    streamlabs_overlays.paintOverlay(overlayid2, image.getSize().width, image.getSize().height, image.getBitmap(), dirty);
 
   })
 
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+
+// Debug builds count heap allocations made by this module on each thread,
+// so hot paths like frame ingestion can assert they do not allocate.
+#ifdef _DEBUG
+size_t get_thread_allocations_count();
+#endif
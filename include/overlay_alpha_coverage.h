@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "overlay_dirty_rects.h"
+
+// Bit mask of parts of a frame that are not fully transparent, one bit per 4x4 pixels block.
+// Mouse hook uses it to let clicks on transparent parts of an overlay go to windows under it.
+// Lookup is O(1) and does not allocate, update allocates only when frame size changes.
+class overlay_alpha_coverage
+{
+	int width;
+	int height;
+	int blocks_x;
+	int blocks_y;
+	int words_per_row;
+	std::vector<uint64_t> bits;
+	std::vector<uint8_t> row_blocks; // scratch for one row of blocks
+
+	public:
+	static const int block_size = 4;
+
+	overlay_alpha_coverage();
+
+	// whole frame counts as covered until its pixels are known
+	void reset(int frame_width, int frame_height);
+	// frame has to be valid in whole blocks around dirty rects, frame of other size is checked whole
+	void update(const uint8_t* pixels, size_t pitch, int frame_width, int frame_height, const overlay_dirty_rects& dirty_rects);
+	// true before first frame
+	bool is_covered(int x, int y) const;
+	void swap(overlay_alpha_coverage& other);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+
+// time source of overlay thread deadlines and of overlay timestamps compared with them, in ms.
+// tests can drive deadlines by virtual time
+class overlay_clock
+{
+	public:
+	virtual ~overlay_clock() {}
+	virtual uint64_t now() = 0;
+};
+
+// monotonic ms from steady clock, it does not jump when system time is changed
+class overlay_tick_clock : public overlay_clock
+{
+	public:
+	virtual uint64_t now() override
+	{
+		return ticks();
+	}
+
+	// same time without an instance, for code that can run before or after overlay thread
+	static uint64_t ticks()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+};
+
+// clock shared by overlay thread deadlines, overlays and flight recorder so their times can be compared
+inline std::shared_ptr<overlay_clock> get_overlay_clock()
+{
+	static const std::shared_ptr<overlay_clock> clock = std::make_shared<overlay_tick_clock>();
+	return clock;
+}
+
+// monotonic time in microseconds for measuring short intervals, same source as overlay_tick_clock
+inline uint64_t get_precise_time_us()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
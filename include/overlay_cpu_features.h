@@ -0,0 +1,33 @@
+#pragma once
+
+// Runtime detection of vector instruction sets, so kernels can be built for
+// several instruction sets in one binary and pick the best one at first use.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OVERLAY_ARCH_X86 1
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define OVERLAY_ARCH_NEON 1
+#endif
+
+// msvc allows avx2 intrinsics in any function, gcc and clang need the function to be marked
+#if defined(OVERLAY_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define OVERLAY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OVERLAY_TARGET_AVX2
+#endif
+
+// instruction sets kernels can be built for
+enum class overlay_isa : int
+{
+	scalar = 0,
+	sse2,
+	avx2,
+	neon
+};
+
+bool cpu_has_sse2();
+bool cpu_has_avx2();
+// true if kernels for isa are built for this architecture and cpu can run them
+bool cpu_has_isa(overlay_isa isa);
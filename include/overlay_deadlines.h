@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "overlay_clock.h"
+
+// things overlay thread has to do for an overlay at some time
+enum class overlay_deadline_kind : int
+{
+	frame_update = 0, // upload frames published since last update
+	autohide,         // overlay had no new content for autohide timeout
+	shared_frames,    // poll shared memory ring, producer in other process can't wake overlay thread
+	producer_signal,  // check what frame producer has to be told
+	held_frame,       // publish frame held by frame rate limit
+	count
+};
+
+struct overlay_deadline
+{
+	uint64_t at; // clock time in ms
+	int overlay_id;
+	overlay_deadline_kind kind;
+};
+
+// Hierarchical timer wheel with deadlines of overlay thread. Thread sleeps until the nearest deadline or a message.
+// Each overlay has at most one deadline of each kind, scheduling it again moves it. Schedule and cancel are O(1),
+// so autohide deadline can be moved on every frame. Four levels of 64 slots of 1 ms, 64 ms, 4 s and 4.6 min
+// hold deadlines up to 4.6 hours ahead, later ones wait in the last level and are placed again when they come close.
+// Timers of an overlay are a block of one timer per kind, taken when its first deadline is scheduled and freed by cancel,
+// so moving, expiring and scheduling a deadline again does not allocate. Wheel lists link timers by index in the pool.
+// Used only on overlay thread.
+class overlay_deadlines
+{
+	static const int level_bits = 6;
+	static const int level_slots = 1 << level_bits;
+	static const int levels = 4;
+	static const int kinds = static_cast<int>(overlay_deadline_kind::count);
+	static const int no_timer = -1;
+
+	struct timer
+	{
+		overlay_deadline deadline;
+		bool scheduled;
+		int level; // -1 for expired list
+		int slot;
+		int prev;
+		int next;
+	};
+
+	std::shared_ptr<overlay_clock> clock;
+	uint64_t current; // time wheel was advanced to
+	std::vector<timer> timers;
+	std::vector<int> free_blocks; // index of first timer of each free block
+	std::unordered_map<int, int> overlay_blocks; // overlay id to index of its first timer
+	size_t scheduled_count;
+	int slots[levels][level_slots];
+	uint64_t occupied[levels]; // bit per not empty slot
+	int expired;
+
+	int find_timer(int overlay_id, overlay_deadline_kind kind) const;
+	int* get_list(const timer& entry);
+	void link(int index);
+	void unlink(int index);
+	void cascade(int level, int slot);
+	uint64_t get_next_tick();
+	void advance(uint64_t now);
+
+	public:
+	// get_timeout result when nothing is scheduled, same value as INFINITE of windows waits
+	static constexpr uint32_t no_timeout = 0xFFFFFFFF;
+
+	explicit overlay_deadlines(std::shared_ptr<overlay_clock> deadlines_clock = get_overlay_clock());
+
+	uint64_t now();
+
+	void schedule(int overlay_id, overlay_deadline_kind kind, uint64_t at);
+	bool is_scheduled(int overlay_id, overlay_deadline_kind kind);
+	void cancel(int overlay_id);
+
+	// ms to wait for the nearest deadline, no_timeout if there is none. can be earlier than a deadline
+	// when wheel has to move far deadlines closer
+	uint32_t get_timeout();
+	bool pop_expired(overlay_deadline& expired_deadline);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include "overlay_pixel_rect.h"
+
+const size_t max_dirty_rects = 16;
+
+// Fixed size list of changed parts of a frame, so paint path does not allocate.
+// When it overflows all rects are merged into their bounding box.
+struct overlay_dirty_rects
+{
+	overlay_pixel_rect rects[max_dirty_rects];
+	size_t count = 0;
+
+	void add(const overlay_pixel_rect& rect);
+	void add(const overlay_dirty_rects& other);
+	void set_whole(int width, int height);
+	void clip(int width, int height);
+	void clear();
+
+	size_t size() const
+	{
+		return count;
+	}
+	size_t get_area() const
+	{
+		size_t area = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			area += static_cast<size_t>(rects[i].right - rects[i].left) * (rects[i].bottom - rects[i].top);
+		}
+		return area;
+	}
+	const overlay_pixel_rect* begin() const
+	{
+		return rects;
+	}
+	const overlay_pixel_rect* end() const
+	{
+		return rects + count;
+	}
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// What flight recorder keeps. Meaning of values a and b depends on event
+enum class overlay_flight_event : uint16_t
+{
+	command = 1,      // a is message number relative to WM_USER, b is its wParam
+	frame_applied,    // a, b are frame width and height
+	frame_dropped,    // a, b are frame width and height
+	hook_event,       // a is hook message, b is virtual key code or x of mouse
+	window_created,
+	window_destroyed,
+	thread_started,
+	thread_stopped,
+	input_switched,   // a is 1 when input is intercepted
+	crashed           // a is exception code
+};
+
+const char* get_flight_event_name(overlay_flight_event event);
+
+// Always on ring of the last events of the overlay module. Adding a record is a few
+// stores and one atomic increment on any thread, no locks or allocations.
+// Records are dumped as text on request or, when crash dump is turned on, from unhandled exception filter.
+void record_flight_event(overlay_flight_event event, int overlay_id, int a = 0, int b = 0);
+
+// writes records from oldest to newest, -1 if file can not be written
+int dump_flight_recorder(const std::string& path);
+
+// Dump goes to path when process crashes on unhandled exception. Off until module user asks for it, as it
+// installs process wide unhandled exception filter. Empty path turns it off, -1 if path can not be used
+int set_flight_recorder_crash_dump(const std::string& path);
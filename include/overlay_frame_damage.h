@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "overlay_dirty_rects.h"
+
+// Finds changed parts of frames that come without dirty rects.
+// Keeps a copy of the previous frame and compares new frame with it in square tiles,
+// changed tiles are reported as damage and copied into the retained frame.
+class overlay_frame_damage
+{
+	std::vector<uint8_t> previous;
+	std::vector<uint8_t> tile_changed; // one flag per tile in a row of tiles
+	int width;
+	int height;
+
+	void resize(int new_width, int new_height);
+	void copy_frame(const uint8_t* frame, size_t frame_pitch);
+	void add_damage(overlay_dirty_rects& damage, const overlay_pixel_rect& rect);
+
+	public:
+	static const int tile_size = 64;
+
+	overlay_frame_damage();
+
+	// compare frame with the previous one, add changed tiles to damage
+	void find_damage(const uint8_t* frame, size_t frame_pitch, int frame_width, int frame_height, overlay_dirty_rects& damage);
+	// frame with known dirty rects, only keeps retained copy in sync
+	void update(const uint8_t* frame, size_t frame_pitch, int frame_width, int frame_height, const overlay_dirty_rects& dirty_rects);
+	void reset();
+};
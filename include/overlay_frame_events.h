@@ -0,0 +1,21 @@
+#pragma once
+
+#include <node_api.h>
+
+// Signals to frame producers so they can stop rendering frames nobody will see.
+// Events are sent from overlay thread to a JS callback (overlayId, event, fps) through a threadsafe function.
+enum class overlay_frame_event : int
+{
+	resume = 0, // paint at normal rate again
+	pause,      // overlay is hidden, painting is useless
+	slow_down   // paint at most fps frames per second
+};
+
+const char* get_frame_event_name(overlay_frame_event event);
+
+// called on JS thread, null or undefined callback removes current one
+napi_status set_frame_events_callback(napi_env env, napi_value callback);
+void clear_frame_events_callback();
+
+// called on any thread, never blocks. false if there is no callback or JS side is too far behind
+bool send_frame_event(int overlay_id, overlay_frame_event event, int fps);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "overlay_cpu_features.h"
+
+// Fast 64-bit hash of frame pixels, used to find frames identical to the previous one.
+// Not cryptographic. SSE2 and AVX2 versions give the same result as the portable one.
+uint64_t hash_frame_pixels(const void* data, size_t size, uint64_t seed);
+// same for a frame with padding after rows, padding is not hashed
+uint64_t hash_frame_rows(const void* data, size_t row_size, size_t pitch, int rows, uint64_t seed);
+// hash_frame_pixels with the version built for isa, false if there is none or cpu can not run it. Used by tests
+bool hash_frame_pixels_for_isa(overlay_isa isa, const void* data, size_t size, uint64_t seed, uint64_t& hash);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stddef.h>
+
+// Frame starts at offset in buffer and its rows are stride bytes apart, stride 0 means rows without padding
+// and is replaced by real row size. Without explicit layout buffer has to be exactly one frame.
+// Layout comes from JS, so sizes are checked for overflow and a layout that overflows is rejected.
+bool is_frame_in_buffer(size_t buffer_size, int width, int height, size_t& stride, size_t offset);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include "overlay_alpha_coverage.h"
+#include "overlay_dirty_rects.h"
+
+// monotonic time in us a frame reached each stage, 0 if it did not
+struct overlay_frame_times
+{
+	uint64_t received = 0;  // paintOverlay called
+	uint64_t published = 0; // copied to mailbox
+	uint64_t taken = 0;     // taken by overlay thread
+	uint64_t applied = 0;   // uploaded to window content buffer
+};
+
+// frame copied from a producer. pixels are valid only inside dirty_rects
+struct overlay_frame_slot
+{
+	std::vector<uint8_t> pixels;
+	int width = 0;
+	int height = 0;
+	overlay_dirty_rects dirty_rects;
+	bool reallocated = false; // pixels buffer was reallocated for this frame
+	overlay_alpha_coverage coverage; // of whole frame, not only of dirty rects
+	overlay_frame_times times;
+};
+
+// Triple buffer between the thread calling paintOverlay (producer) and the overlay thread (consumer).
+// Producer always has a free slot to write and never waits for consumer. Consumer takes the newest
+// published frame, older frames it did not take are dropped but their dirty rects are carried to the newer one.
+// Slots keep their pixel buffers between frames, buffers are reallocated only when overlay size changes.
+class overlay_frame_mailbox
+{
+	static const int fresh_frame_flag = 4;
+
+	overlay_frame_slot slots[3];
+	int write_index; // producer only
+	int read_index;  // consumer only
+	std::atomic<int> shared_index;
+	std::atomic<bool> full_frame_requested;
+	std::atomic<size_t> allocated_bytes; // pixel buffers of all slots
+
+	// producer only. what was changed since the last frame consumer took
+	overlay_dirty_rects pending_rects;
+	int pending_width;
+	int pending_height;
+
+	public:
+	overlay_frame_mailbox();
+
+	// producer side
+	overlay_frame_slot& begin_write(int width, int height, const overlay_dirty_rects& dirty_rects);
+	void publish();
+
+	// consumer side
+	overlay_frame_slot* take();
+	void request_full_frame();
+	bool is_full_frame_requested() const;
+
+	// any thread
+	size_t get_allocated_bytes() const;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include "overlay_dirty_rects.h"
+
+// Limits how often frames of an overlay are accepted, frames coming faster are dropped before they are processed.
+// Changed parts of dropped frames are remembered and added to the next accepted frame,
+// so a producer sending only dirty parts does not lose them.
+// Newest dropped frame is held and taken when its time comes, so the last frame of a burst is shown
+// even if producer stops after it. A frame accepted meanwhile replaces it.
+// Pacer only tracks that a frame is held, caller keeps its pixels without copying them.
+class overlay_frame_pacer
+{
+	std::chrono::steady_clock::duration interval; // zero for no limit
+	std::chrono::steady_clock::time_point next_frame_time;
+	overlay_dirty_rects dropped_rects;
+	bool dropped_whole;
+	bool has_dropped;
+
+	bool has_held;
+
+	bool is_early(std::chrono::steady_clock::time_point now);
+	void advance(std::chrono::steady_clock::time_point now);
+
+	std::atomic<uint64_t> accepted_count;
+	std::atomic<uint64_t> dropped_count;
+
+	public:
+	overlay_frame_pacer();
+
+	void set_frame_rate_limit(int fps);
+	int get_frame_rate_limit();
+
+	bool accept_frame(const overlay_dirty_rects& dirty_rects);
+	// adds changed parts of frames dropped since last accepted one
+	void add_dropped_rects(overlay_dirty_rects& dirty_rects, int width, int height);
+
+	// frame dropped by accept_frame is held in place of the held one
+	void hold_frame();
+	bool has_held_frame();
+	// time until held frame can be taken, zero if it can be taken now
+	std::chrono::steady_clock::duration get_held_frame_delay();
+	// accepts held frame if its time came. rects get changed parts of dropped frames, none for whole frame
+	bool take_held_frame(overlay_dirty_rects& dirty_rects);
+
+	uint64_t get_accepted_count();
+	uint64_t get_dropped_count();
+};
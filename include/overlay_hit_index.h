@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include "overlay_alpha_coverage.h"
+#include "overlay_pixel_rect.h"
+
+struct overlay_hit_rect
+{
+	int overlay_id;
+	overlay_pixel_rect rect; // screen coordinates
+	const overlay_alpha_coverage* coverage; // transparent parts are not hit, can be nullptr
+};
+
+struct overlay_hit
+{
+	int overlay_id;
+	int x; // coordinates inside overlay
+	int y;
+};
+
+// Snapshot of visible overlay rects for hit-testing mouse events in the low-level hook.
+// Rects are kept topmost first, screen area they cover is split into a uniform grid and every cell
+// has a bit mask of rects crossing it, so a hit test checks only rects of one cell, from the top.
+// Overlay thread publishes a new snapshot when overlays move, show or hide. Snapshots are double buffered
+// with a sequence number, hit test never locks or allocates and retries if snapshot was replaced while read.
+// Alpha coverage of overlays is not copied into snapshot, hit test has to run on the thread updating it.
+class overlay_hit_index
+{
+	public:
+	static const int max_rects = 64;
+	static const int grid_size = 16;
+
+	private:
+	struct snapshot
+	{
+		std::atomic<uint32_t> sequence; // odd while snapshot is written
+		int rect_count;
+		overlay_hit_rect rects[max_rects];
+		overlay_pixel_rect bounds;
+		int cell_width;
+		int cell_height;
+		uint64_t cells[grid_size * grid_size];
+	};
+
+	snapshot snapshots[2];
+	std::atomic<int> current;
+
+	public:
+	overlay_hit_index();
+
+	// called by one writer. rects go topmost first, rects after max_rects are not indexed
+	void publish(const std::vector<overlay_hit_rect>& rects);
+	// topmost overlay not transparent at the point
+	bool hit_test(int x, int y, overlay_hit& hit) const;
+};
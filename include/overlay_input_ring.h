@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum class overlay_input_type : int32_t
+{
+	unknown = 0,
+	key_down,
+	key_up,
+	key_char,
+	mouse_move,
+	mouse_down,
+	mouse_up,
+	mouse_wheel
+};
+
+enum class overlay_mouse_button : int32_t
+{
+	none = 0,
+	left,
+	right
+};
+
+enum class overlay_mouse_wheel : int32_t
+{
+	vertical = 0,
+	horizontal
+};
+
+// Input event copied from hook data while hook runs. Only int32 fields, so a batch of events
+// is given to JS as Int32Array without conversion
+struct overlay_input_event
+{
+	int32_t type;       // overlay_input_type
+	int32_t code;       // virtual key code for keyboard, overlay_mouse_button or overlay_mouse_wheel for mouse
+	int32_t scan_code;  // keyboard only
+	int32_t flags;      // flags of hook struct
+	int32_t overlay_id; // overlay under mouse, 0 for keyboard
+	int32_t x;          // coordinates inside overlay
+	int32_t y;
+	int32_t wheel_delta; // 120 (WHEEL_DELTA) per wheel notch, positive is forward or right
+	int32_t time;       // hook event time in ms, wraps around
+	int32_t count;      // mouse moves merged into this one
+};
+
+static_assert(sizeof(overlay_input_event) == 10 * sizeof(int32_t), "input event is sent to JS as packed int32 fields");
+
+bool is_mouse_move(const overlay_input_event& event);
+void merge_mouse_move(overlay_input_event& to, const overlay_input_event& from);
+
+// Fixed size lock-free ring between one producer (input hook on overlay thread) and one consumer (JS thread).
+class overlay_input_ring
+{
+	public:
+	static const size_t capacity = 256;
+
+	private:
+	overlay_input_event events[capacity];
+	std::atomic<size_t> write_count;
+	std::atomic<size_t> read_count;
+
+	public:
+	overlay_input_ring();
+
+	// producer side, false if ring is full
+	bool push(const overlay_input_event& event);
+	size_t get_free_space() const;
+
+	// consumer side
+	bool peek(overlay_input_event& event) const;
+	bool pop(overlay_input_event& event);
+	size_t pop_many(overlay_input_event* to, size_t max_count);
+	void clear();
+};
+
+// Producer side of input ring that never waits for consumer. When ring gets full mouse moves are merged
+// into one and other events wait in order in spill. Waiting events go to ring on next push or flush.
+// Buttons, wheel and keys are never dropped: when spill is full mouse moves waiting in it are dropped
+// and counted to make room, and only if there are none spill grows. Spill allocates only when it grows.
+class overlay_input_queue
+{
+	public:
+	// ring slots kept for buttons, wheel and keys. moves coming when ring is that full are merged into one
+	static const size_t reserved_for_clicks = 64;
+	// spill size allocated up front
+	static const size_t spill_capacity = 256;
+
+	private:
+	overlay_input_ring ring;
+	// producer only. spill is used as a ring of spill.size() events
+	std::vector<overlay_input_event> spill;
+	size_t spill_first;
+	size_t spill_size;
+	overlay_input_event pending_move;
+	bool has_pending_move;
+	std::atomic<uint64_t> dropped_count; // mouse moves, merged ones counted by their count
+
+	bool add_to_spill(const overlay_input_event& event);
+	void drop_spilled_moves();
+	void grow_spill();
+
+	public:
+	overlay_input_queue();
+
+	// producer side, false if a mouse move was dropped to make room
+	bool push(const overlay_input_event& event);
+	// true if events still wait for room in ring
+	bool flush();
+	bool has_waiting() const;
+
+	// consumer side
+	bool peek(overlay_input_event& event) const;
+	bool pop(overlay_input_event& event);
+	size_t pop_many(overlay_input_event* to, size_t max_count);
+	void clear();
+
+	// any thread
+	uint64_t get_dropped_count() const;
+	size_t get_spill_capacity() const; // producer only
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <node_api.h>
+
+// JS strings created once and kept alive by references, so callbacks sending the same
+// event names and key names again do not create new strings. Strings belong to one env,
+// cache is emptied when it is used with another one.
+class overlay_js_strings
+{
+	public:
+	static const size_t max_count = 512;
+
+	private:
+	napi_env env;
+	napi_ref refs[max_count];
+
+	public:
+	overlay_js_strings();
+
+	// index is chosen by caller, same index has to come with same text
+	napi_status get(napi_env env, size_t index, const char* text, napi_value* result);
+	void release();
+};
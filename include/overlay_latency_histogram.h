@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Latency histogram with log-linear buckets like HDR histograms: values below 32 us have own buckets,
+// every next power of two range is split in 16 buckets, so a value is known within 1/16 of it.
+// One thread records, any thread reads. Counters are relaxed atomics, reads may miss values recorded meanwhile.
+class overlay_latency_histogram
+{
+	static const int sub_bucket_bits = 4;
+	static const int sub_bucket_count = 1 << sub_bucket_bits;
+	// values below 2^32 us, larger ones go to the last bucket. first 2 * sub_bucket_count buckets hold values
+	// below 2^(sub_bucket_bits + 1), then each of 32 - sub_bucket_bits - 1 power of two ranges has its own buckets
+	static const int bucket_count = (32 - sub_bucket_bits + 1) * sub_bucket_count;
+
+	std::atomic<uint32_t> counts[bucket_count];
+	std::atomic<uint64_t> total_count;
+	std::atomic<uint64_t> max_value;
+
+	static int get_bucket(uint64_t value);
+	static uint64_t get_bucket_value(int bucket); // highest value in bucket
+
+	public:
+	overlay_latency_histogram();
+
+	void record(uint64_t microseconds);
+	void reset();
+
+	uint64_t get_count() const;
+	uint64_t get_max() const;
+	// 0 if nothing was recorded
+	uint64_t get_percentile(double percentile) const;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+
+// "YYYYMMDD:HHMMSS." of second in local time, to has to hold log_time_size bytes. returns length
+static const size_t log_time_size = 20;
+size_t format_log_time(char* to, std::time_t second);
+
+// moves log_file to log_file.1, log_file.1 to log_file.2 and so on, keeps files_kept rotated files
+void rotate_log_files(const std::filesystem::path& log_file, int files_kept);
+
+// Log file appended to by one thread. Its size is counted by writes, when it reaches max_size the file is
+// rotated and a new one is started, so there are at most files_kept rotated files next to the current one.
+class overlay_log_file
+{
+	std::ofstream file;
+	std::filesystem::path path;
+	uintmax_t size;
+	uintmax_t max_size;
+	int files_kept;
+
+	public:
+	overlay_log_file();
+
+	// appends to existing file, size of it counts toward max_size
+	bool open(const std::filesystem::path& file_path, uintmax_t file_max_size, int rotated_files_kept);
+	bool is_open() const;
+	void write(const char* text, size_t length);
+	void flush();
+	void rotate();
+
+	uintmax_t get_size() const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Bounded lock-free ring of formatted log lines. Any thread can push, one writer thread pops.
+// Every cell has a sequence number telling if it is free for the producer which claimed its
+// position or filled for the consumer. Push never waits, when ring is full the line is dropped and counted.
+class overlay_log_ring
+{
+	public:
+	static const size_t capacity = 512;
+	static const size_t record_size = 512;
+
+	private:
+	struct cell
+	{
+		std::atomic<size_t> sequence;
+		size_t length;
+		char text[record_size];
+	};
+
+	cell cells[capacity];
+	std::atomic<size_t> push_position;
+	size_t pop_position; // consumer only
+	std::atomic<size_t> dropped_count;
+
+	public:
+	overlay_log_ring();
+
+	// any thread. text longer than record_size is cut
+	bool push(const char* text, size_t length);
+
+	// consumer side. copies one line to a buffer of record_size, 0 if ring is empty
+	size_t pop(char* to);
+	bool has_line() const;
+	size_t take_dropped_count();
+};
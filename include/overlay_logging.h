@@ -1,18 +1,91 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
-#include <fstream>
+#include <streambuf>
 #include <string>
+#include "overlay_log_ring.h"
 
+// levels are numbers so they can be compared by preprocessor
+#define OVERLAY_LOG_LEVEL_DEBUG 0
+#define OVERLAY_LOG_LEVEL_INFO 1
+#define OVERLAY_LOG_LEVEL_ERROR 2
+#define OVERLAY_LOG_LEVEL_NONE 3
+
+// lines below this level are not compiled in, release builds keep info and errors
+#ifndef OVERLAY_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define OVERLAY_LOG_MIN_LEVEL OVERLAY_LOG_LEVEL_DEBUG
+#else
+#define OVERLAY_LOG_MIN_LEVEL OVERLAY_LOG_LEVEL_INFO
+#endif
+#endif
 
 const std::string getTimeStamp();
 
-extern std::ofstream log_output_file;
-extern bool log_output_disabled;
+extern std::atomic<bool> log_output_disabled;
+extern std::atomic<int> log_output_level; // lines below it are skipped at runtime
+
+// Rate limit of one logging statement. Lines over the limit in a second are counted
+// and the count is written with the next line the statement is allowed to write.
+class overlay_log_site
+{
+	std::atomic<long long> window_second;
+	std::atomic<int> window_count;
+	std::atomic<int> suppressed_count;
+
+	public:
+	static const int max_lines_per_second = 20;
+
+	overlay_log_site();
+
+	// false if the line has to be skipped. suppressed is set to lines skipped before this one
+	bool allow(int& suppressed);
+};
+
+// One log line formatted into a buffer on caller's stack. When the logging statement ends
+// the line is queued for the writer thread, caller never waits for file output.
+class overlay_log_line
+{
+	class line_buffer : public std::streambuf
+	{
+		public:
+		line_buffer(char* begin, size_t size)
+		{
+			setp(begin, begin + size);
+		}
+		size_t get_size() const
+		{
+			return pptr() - pbase();
+		}
+	};
+
+	char text[overlay_log_ring::record_size];
+	line_buffer buffer;
+	std::ostream stream;
+
+	public:
+	overlay_log_line(const char* level, int suppressed);
+	~overlay_log_line();
+	overlay_log_line(const overlay_log_line&) = delete;
+	overlay_log_line& operator=(const overlay_log_line&) = delete;
+
+	std::ostream& get_stream()
+	{
+		return stream;
+	}
+};
+
+// every logging statement gets its own static overlay_log_site from its own lambda
+#define log_at_level(level, level_name) \
+	if (level < OVERLAY_LOG_MIN_LEVEL || log_output_disabled.load(std::memory_order_relaxed) || level < log_output_level.load(std::memory_order_relaxed)) {} \
+	else if (int log_suppressed = 0; !([]() -> overlay_log_site& { static overlay_log_site site; return site; }()).allow(log_suppressed)) {} \
+	else overlay_log_line(level_name, log_suppressed).get_stream()
 
-#define log_info if (log_output_disabled || !log_output_file.is_open()) {} else log_output_file << "INF:" << getTimeStamp() <<  ": " 
-#define log_debug if (log_output_disabled || !log_output_file.is_open()) {} else log_output_file << "DBG:" << getTimeStamp() <<  ": "
-#define log_error if (log_output_disabled || !log_output_file.is_open()) {} else log_output_file << "ERR:" << getTimeStamp() <<  ": "
+#define log_info log_at_level(OVERLAY_LOG_LEVEL_INFO, "INF")
+#define log_debug log_at_level(OVERLAY_LOG_LEVEL_DEBUG, "DBG")
+#define log_error log_at_level(OVERLAY_LOG_LEVEL_ERROR, "ERR")
 
 void logging_start(std::string log_path);
-void logging_end();
\ No newline at end of file
+void logging_end();
+bool logging_set_level(const std::string& level_name);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <node_api.h>
+
+// Buffers given to paintOverlay are not copied during the call. A reference keeps each buffer alive while
+// overlay thread reads it, then overlay thread gives the reference back and it is deleted on JS thread.
+// Buffer must not be changed by JS after it was painted.
+
+// called on JS thread once, when module is loaded
+napi_status init_painted_buffers(napi_env env);
+
+// called on JS thread. keeper is given to release_painted_buffer when buffer is not needed any more
+napi_status keep_painted_buffer(napi_env env, napi_value buffer, void** keeper);
+
+// called on any thread, never blocks. reference is deleted on next turn of JS event loop
+void release_painted_buffer(void* keeper);
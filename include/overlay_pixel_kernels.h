@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "overlay_cpu_features.h"
+
+// Pixel conversions applied to frames before they are handed to a backend.
+// Backends want BGRA with premultiplied alpha, producers may give RGBA or straight alpha.
+struct overlay_pixel_conversion
+{
+	bool swap_red_blue = false; // RGBA <-> BGRA
+	bool premultiply = false;   // source has straight alpha
+	uint8_t global_alpha = 255; // applied to all pixels on top of their own alpha
+
+	bool is_copy() const
+	{
+		return !swap_red_blue && !premultiply && global_alpha == 255;
+	}
+};
+
+// converts count pixels from src to dst, dst may be same as src.
+// all instruction set versions give same result as the portable one
+void convert_pixels(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion);
+
+// sets blocks[i] to 1 if any of 4 pixels of block i has alpha above zero, other blocks are left as they are.
+// pixels are block_count * 4 BGRA pixels in a row
+void mark_alpha_blocks(uint8_t* blocks, const uint8_t* pixels, size_t block_count);
+
+// same with the version built for isa, false if there is none or cpu can not run it. Used by tests
+bool convert_pixels_for_isa(overlay_isa isa, uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion);
+bool mark_alpha_blocks_for_isa(overlay_isa isa, uint8_t* blocks, const uint8_t* pixels, size_t block_count);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// Rect in pixels, right and bottom edges are outside of it. Same layout as windows RECT,
+// so frame code does not depend on windows headers and can be built and tested anywhere.
+struct overlay_pixel_rect
+{
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+
+	bool is_empty() const
+	{
+		return right <= left || bottom <= top;
+	}
+	bool contains(int32_t x, int32_t y) const
+	{
+		return x >= left && x < right && y >= top && y < bottom;
+	}
+};
+
+// rect of position and size given by producer, edges that do not fit in int32 are clamped
+inline overlay_pixel_rect make_pixel_rect(int64_t x, int64_t y, int64_t width, int64_t height)
+{
+	const auto clamp = [](int64_t value) {
+		return static_cast<int32_t>(value < INT32_MIN ? INT32_MIN : value > INT32_MAX ? INT32_MAX : value);
+	};
+	return overlay_pixel_rect {clamp(x), clamp(y), clamp(x + width), clamp(y + height)};
+}
+
+// smallest rect holding both, empty rect is ignored like UnionRect does
+inline overlay_pixel_rect union_pixel_rects(const overlay_pixel_rect& a, const overlay_pixel_rect& b)
+{
+	if (a.is_empty())
+	{
+		return b;
+	}
+	if (b.is_empty())
+	{
+		return a;
+	}
+
+	return overlay_pixel_rect {a.left < b.left ? a.left : b.left, a.top < b.top ? a.top : b.top, a.right > b.right ? a.right : b.right, a.bottom > b.bottom ? a.bottom : b.bottom};
+}
+
+// common part of both, false and empty result if they do not overlap like IntersectRect does
+inline bool intersect_pixel_rects(overlay_pixel_rect& result, const overlay_pixel_rect& a, const overlay_pixel_rect& b)
+{
+	const overlay_pixel_rect common = {a.left > b.left ? a.left : b.left, a.top > b.top ? a.top : b.top, a.right < b.right ? a.right : b.right, a.bottom < b.bottom ? a.bottom : b.bottom};
+	if (common.is_empty())
+	{
+		result = overlay_pixel_rect {0, 0, 0, 0};
+		return false;
+	}
+
+	result = common;
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class overlay_window;
+
+// Slot map of overlays. Overlay id holds index of its slot and generation of the slot, so lookups by id
+// are O(1) and id of a removed overlay is rejected even after its slot is reused by a new overlay.
+// Overlays are kept in a dense array for iteration, removal moves the last one into the freed place.
+// Window handles are HWND of overlay windows, kept as pointers so registry does not depend on windows headers.
+// Not thread safe, smg_overlays guards it with overlays_list_access.
+class overlay_registry
+{
+	static const int slot_bits = 12;
+	static const int max_slots = 1 << slot_bits;
+	static const int max_generation = (1 << (31 - slot_bits)) - 1;
+
+	struct slot
+	{
+		int generation;
+		int dense_index; // -1 for free slot
+		const void* window;
+	};
+
+	std::vector<std::shared_ptr<overlay_window>> dense;
+	std::vector<int> dense_slots; // slot index of each dense entry
+	std::vector<slot> slots;
+	std::vector<int> free_slots;
+	std::unordered_map<const void*, int> window_slots;
+
+	int find_slot(int overlay_id) const;
+
+	public:
+	typedef std::vector<std::shared_ptr<overlay_window>>::iterator iterator;
+
+	// id for overlay, -1 if there are no free slots
+	int add(const std::shared_ptr<overlay_window>& overlay);
+	bool remove(int overlay_id);
+	bool bind_window(int overlay_id, const void* window);
+
+	std::shared_ptr<overlay_window> find(int overlay_id) const;
+	std::shared_ptr<overlay_window> find_by_window(const void* window) const;
+
+	size_t size() const;
+	iterator begin();
+	iterator end();
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Scales 32 bit pixel images. Bilinear filter, or box filter when image is made
+// at least two times smaller, where bilinear would skip source pixels.
+// Coordinate tables are kept between calls and rebuilt only when sizes change.
+struct overlay_resample_tap
+{
+	int first;  // first source pixel
+	int count;  // box filter: number of source pixels
+	int weight; // bilinear: weight of the next source pixel, 0-256
+};
+
+class overlay_resampler
+{
+	std::vector<overlay_resample_tap> columns;
+	std::vector<overlay_resample_tap> rows;
+	std::vector<uint32_t> box_sums; // box filter: channel sums of one destination row
+	int src_width;
+	int src_height;
+	int dst_width;
+	int dst_height;
+	bool use_box;
+
+	void prepare(int new_src_width, int new_src_height, int new_dst_width, int new_dst_height);
+	void scale_bilinear(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch);
+	void scale_box(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch);
+
+	public:
+	overlay_resampler();
+
+	void scale(uint8_t* dst, int dst_w, int dst_h, size_t dst_pitch, const uint8_t* src, int src_w, int src_h, size_t src_pitch);
+};
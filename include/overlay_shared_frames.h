@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Ring of frames in named shared memory, so frames can be produced in another thread or process
+// and uploaded by overlay thread right from the mapping.
+//
+// Mapping starts with shared_frames_header followed by slot_count slots. Each slot is a
+// shared_frame_slot_header and then max_width * max_height * 4 bytes of premultiplied BGRA pixels,
+// rows are width * 4 bytes without padding.
+// Slot is a seqlock: writer moves sequence from even to odd, writes frame and makes it even again.
+// So any number of writers can share a ring, and reader checks after using pixels that slot was not rewritten.
+
+const uint32_t shared_frames_magic = 0x534C4F46;
+const uint32_t shared_frames_version = 1;
+const uint32_t shared_frames_max_rects = 16;
+
+struct shared_frame_rect
+{
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+struct shared_frames_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t max_width;
+	uint32_t max_height;
+	uint32_t reserved;
+	uint64_t slot_size; // bytes from one slot header to the next
+	std::atomic<uint64_t> last_frame_number;
+};
+
+struct shared_frame_slot_header
+{
+	std::atomic<uint32_t> sequence; // odd while frame is written
+	uint32_t width;
+	uint32_t height;
+	uint32_t rect_count; // changed parts since previous frame, 0 means whole frame
+	uint64_t frame_number;
+	shared_frame_rect rects[shared_frames_max_rects];
+};
+
+// frame found by reader, valid until read_end
+struct shared_frame_view
+{
+	const uint8_t* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	bool whole = true; // frames were skipped, rects do not cover all changes
+	uint32_t rect_count = 0;
+	shared_frame_rect rects[shared_frames_max_rects];
+
+	uint32_t slot = 0;
+	uint32_t sequence = 0;
+	uint64_t frame_number = 0;
+};
+
+class overlay_shared_frames
+{
+	void* mapping_handle;
+	int mapping_fd;
+	uint8_t* view;
+	size_t view_size;
+	bool owner;
+	std::string mapping_name;
+
+	uint64_t last_read_frame; // reader only
+	bool whole_frame_needed;  // reader only
+
+	shared_frames_header* header();
+	shared_frame_slot_header* slot(uint32_t index);
+	bool map(const std::string& name, size_t size, bool create);
+
+	public:
+	overlay_shared_frames();
+	~overlay_shared_frames();
+
+	// creates a named ring, it is removed when creator closes it
+	bool create(const std::string& name, uint32_t max_width, uint32_t max_height, uint32_t slot_count = 3);
+	// opens a ring created by other thread or process
+	bool open(const std::string& name);
+	void close();
+	bool is_open();
+
+	// writer side. false if frame is too big or all slots are being written
+	bool write_frame(const uint8_t* pixels, size_t pitch, int width, int height, const shared_frame_rect* rects, uint32_t rect_count);
+
+	// reader side. finds frame newer than the last read one, pixels can be used until read_end.
+	// read_end returns false if slot was rewritten meanwhile, next frame is then read as whole
+	bool read_begin(shared_frame_view& frame);
+	bool read_end(const shared_frame_view& frame);
+	void request_full_frame();
+};
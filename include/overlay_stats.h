@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Counters of one overlay. Hot paths update them without locks, JS thread reads them,
+// so they are relaxed atomics and a read of several counters is not one consistent snapshot.
+struct overlay_stats
+{
+	std::atomic<uint64_t> frames_received {0};      // paintOverlay calls for the overlay
+	std::atomic<uint64_t> frames_applied {0};       // uploaded to window content buffer
+	std::atomic<uint64_t> frames_dropped_hidden {0}; // overlays were hidden
+	std::atomic<uint64_t> frames_dropped_size {0};   // frame size was not overlay size
+	std::atomic<uint64_t> bytes_fitted {0};   // written by scaling or cropping frames to overlay size
+	std::atomic<uint64_t> bytes_copied {0};   // copied from producer to mailbox
+	std::atomic<uint64_t> bytes_uploaded {0}; // copied to window content buffer
+	std::atomic<uint64_t> paint_calls {0};
+	std::atomic<uint64_t> autohide_transitions {0}; // hidden by autohide or shown again
+	std::atomic<uint64_t> content_buffer_bytes {0}; // GDI or D2D bitmap held now
+
+	static void add(std::atomic<uint64_t>& counter, uint64_t value = 1)
+	{
+		counter.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	static uint64_t get(const std::atomic<uint64_t>& counter)
+	{
+		return counter.load(std::memory_order_relaxed);
+	}
+};
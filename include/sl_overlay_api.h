@@ -1,8 +1,12 @@
 #pragma once
 #include "stdafx.h"
 #include <string>
+#include "overlay_hit_index.h"
 
-struct overlay_frame;
+struct overlay_dirty_rects;
+struct overlay_pixel_conversion;
+enum class overlay_frame_fit : int;
+typedef void (*overlay_frame_release)(void* keeper); // same as in sl_overlay_window.h
 class smg_overlays;
 
 // char* params like url - functions get ownership of that pointer and clean memory when finish with it
@@ -20,18 +24,32 @@ int WINAPI get_overlays_count();
 int WINAPI remove_overlay(int id);
 
 int WINAPI set_overlay_position(int id, int x, int y, int width, int height);
-int WINAPI paint_overlay_from_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height);
-int WINAPI paint_overlay_cached_buffer(int overlay_id, std::shared_ptr<overlay_frame>, int width, int height);
+int WINAPI paint_overlay_from_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height); // only frames of overlay size, others get -1
+// with keeper image is not copied during the call, it is read later on overlay thread and release(keeper) is called
+// on some thread when it is not needed any more, also when frame is rejected. without keeper image is copied first
+int WINAPI paint_overlay_cached_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects, size_t stride = 0, size_t offset = 0, void* keeper = nullptr, overlay_frame_release release = nullptr);
 int WINAPI set_overlay_transparency(int id, int transparency);
 int WINAPI set_overlay_visibility(int id, bool visibility);
 int WINAPI set_overlay_autohide(int id, int autohide_timeout, int autohide_transparency);
+int WINAPI set_overlay_pixel_format(int id, const overlay_pixel_conversion& conversion);
+int WINAPI set_overlay_frame_fit(int id, overlay_frame_fit fit);
+int WINAPI set_overlay_frame_rate_limit(int id, int fps);
+int WINAPI attach_overlay_shared_frames(int id, const std::string& name, int max_width, int max_height);
+int WINAPI detach_overlay_shared_frames(int id);
+
+// what mouse hook gives to input callback as lParam, hit test is not repeated there
+struct overlay_mouse_input
+{
+	MSLLHOOKSTRUCT hook;
+	overlay_hit hit;
+};
 
 int WINAPI set_callback_for_keyboard_input(int (*ptr)(WPARAM, LPARAM));
 int WINAPI set_callback_for_mouse_input(int (*ptr)(WPARAM, LPARAM));
 int WINAPI set_callback_for_switching_input(int (*ptr)());
 
 int WINAPI use_callback_for_keyboard_input(WPARAM wParam, LPARAM lParam);
-int WINAPI use_callback_for_mouse_input(WPARAM wParam, LPARAM lParam);
+int WINAPI use_callback_for_mouse_input(WPARAM wParam, LPARAM lParam); // lParam is overlay_mouse_input*
 int WINAPI use_callback_for_switching_input();
 
 int WINAPI switch_overlays_user_input(bool mode_active);
\ No newline at end of file
@@ -1,6 +1,18 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <mutex>
-#include "overlay_paint_frame.h"
+#include "overlay_clock.h"
+#include "overlay_dirty_rects.h"
+#include "overlay_frame_events.h"
+#include "overlay_frame_damage.h"
+#include "overlay_frame_mailbox.h"
+#include "overlay_frame_pacer.h"
+#include "overlay_latency_histogram.h"
+#include "overlay_pixel_kernels.h"
+#include "overlay_resampler.h"
+#include "overlay_shared_frames.h"
+#include "overlay_stats.h"
 #include "stdafx.h"
 
 extern wchar_t const g_szWindowClass[];
@@ -13,6 +25,46 @@ enum class overlay_status : int
 	destroing
 };
 
+// what to do with a frame which size is not the same as overlay size
+enum class overlay_frame_fit : int
+{
+	resize_overlay = 0, // drop frame and resize overlay to frame size
+	scale,              // scale frame to overlay size
+	crop                // use top left part of frame
+};
+
+typedef void (*overlay_frame_release)(void* keeper);
+
+// frame given by producer and not read yet. Pixels stay valid until release is called with keeper,
+// so paintOverlay only hands frame over and overlay thread hashes, compares and copies it
+struct overlay_painted_frame
+{
+	const uint8_t* pixels = nullptr; // first pixel of image, null for no frame
+	size_t pitch = 0;
+	int width = 0;
+	int height = 0;
+	overlay_dirty_rects dirty_rects;
+	uint64_t received_time = 0;
+	void* keeper = nullptr;
+	overlay_frame_release release = nullptr;
+};
+
+// gives pixels back to their keeper, frame is empty after it
+void release_painted_frame(overlay_painted_frame& frame);
+
+// stages of a frame from paintOverlay to window, latencies between them are kept per overlay
+enum class overlay_frame_stage : int
+{
+	copy = 0, // paintOverlay called until overlay thread copied frame to mailbox
+	wake,     // published until overlay thread takes it
+	upload,   // taken until it is in window content buffer
+	present,  // uploaded until window is painted
+	total,    // paintOverlay called until window is painted
+	count
+};
+
+const char* get_frame_stage_name(overlay_frame_stage stage);
+
 class overlay_window
 {
 	protected:
@@ -22,13 +74,62 @@ class overlay_window
 	int overlay_transparency;
 	bool overlay_visibility;
 
-	bool content_updated;
+	std::atomic<bool> content_updated;
 	bool content_set;
-	std::shared_ptr<overlay_frame> frame;
+	bool repaint_whole;
 	std::mutex frame_access;
-
+	overlay_frame_mailbox frames;
+	overlay_painted_frame painted_frame; // guarded by frame_access, newest painted frame overlay thread did not take yet
+
+	// overlay thread only. hash of the last published frame to skip identical frames
+	uint64_t last_frame_hash;
+	int last_frame_width;
+	int last_frame_height;
+	std::atomic<uint64_t> duplicate_frames_skipped;
+	overlay_frame_damage frame_damage; // overlay thread only
+	overlay_frame_pacer frame_pacer;
+	overlay_painted_frame held_frame; // guarded by frame_access, newest frame dropped by frame_pacer until its time comes
+	overlay_pixel_conversion pixel_conversion; // guarded by frame_access, applied while frame is copied to mailbox
+	std::atomic<overlay_frame_fit> frame_fit;
+	overlay_resampler resampler;      // overlay thread only
+	std::vector<uint8_t> fitted_frame; // overlay thread only, frame scaled or cropped to overlay size
+	std::atomic<bool> frame_ready_posted; // overlay thread was woken for painted frames and did not handle it yet
+	std::atomic<bool> frame_held_posted;  // same for frame held by frame_pacer
+	overlay_alpha_coverage frame_coverage;   // overlay thread only, of the last published frame
+	overlay_alpha_coverage display_coverage; // overlay thread only, of the frame in window
+	overlay_alpha_coverage shared_coverage;  // overlay thread only, of shared frame until read_end shows it was not torn
+
+	void take_painted_frame();
+	void apply_painted_frame(const overlay_painted_frame& frame, const overlay_pixel_conversion& conversion);
+	bool push_frame(const uint8_t* frame_pixels, size_t frame_pitch, int width, int height, const overlay_dirty_rects& dirty_rects, uint64_t received_time, const overlay_pixel_conversion& conversion);
+	bool fit_frame(const uint8_t* image, int image_width, int image_height, size_t image_pitch, uint64_t received_time, const overlay_pixel_conversion& conversion);
+	overlay_stats stats;
+
+	// overlay thread only. last uploaded frame until window is painted, frames uploaded before paint are not counted
+	overlay_frame_times unpainted_frame;
+	overlay_latency_histogram frame_latency[static_cast<int>(overlay_frame_stage::count)];
+	void record_frame_latency(overlay_frame_stage stage, uint64_t from, uint64_t to);
+
+	std::unique_ptr<overlay_shared_frames> shared_frames; // overlay thread only
+
+	// what producer of frames was told to do, overlay thread only
+	overlay_frame_event producer_event;
+	int producer_fps;
+	uint64_t producer_event_ticks;
+	// published and used frames counted in windows of a second to find how many frames are wasted
+	std::atomic<uint64_t> frames_published;
+	uint64_t frames_taken; // overlay thread only
+	uint64_t rate_window_start;
+	uint64_t rate_window_published;
+	uint64_t rate_window_taken;
+	int used_frame_rate; // 0 while overlay uses most of published frames
+
+	void request_full_frame();
+
+	// same clock as overlay thread deadlines, so autohide and producer signal times match them
+	std::shared_ptr<overlay_clock> clock;
 	int autohide_after;
-	ULONGLONG last_content_chage_ticks;
+	uint64_t last_content_chage_ticks;
 	bool autohidden;
 	int autohide_by_transparency;
 
@@ -43,12 +144,34 @@ class overlay_window
 
 	bool create_window();
 	bool ready_to_create_overlay();
-	bool set_cached_image(std::shared_ptr<overlay_frame> save_frame);
+	void set_painted_frame(overlay_painted_frame& frame);
+	void set_pixel_conversion(const overlay_pixel_conversion& conversion);
+	void set_frame_fit(overlay_frame_fit fit);
+	void set_frame_rate_limit(int fps);
+	int get_frame_rate_limit();
+	bool accept_frame_by_rate(overlay_painted_frame& frame);
+	void reset_frame_held_post();
+	int get_held_frame_delay();
+	bool publish_held_frame();
+	uint64_t get_frames_accepted();
+	uint64_t get_frames_dropped();
+	overlay_frame_fit get_frame_fit();
 	virtual bool create_window_content_buffer() = 0;
-	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height) = 0;
+	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects) = 0;
 	virtual void paint_to_window(HDC window_hdc) = 0;
 	virtual void create_render_target(ID2D1Factory* m_pDirect2dFactory){};
 	bool is_content_updated();
+	void update_content();
+	void set_shared_frames(overlay_shared_frames* new_shared_frames);
+	void update_shared_content();
+	bool has_shared_frames();
+	void reset_frame_ready_post();
+	uint64_t get_duplicate_frames_skipped();
+	const overlay_alpha_coverage* get_alpha_coverage();
+	void on_frame_painted();
+	overlay_stats& get_stats();
+	size_t get_frame_buffers_bytes();
+	const overlay_latency_histogram& get_frame_latency(overlay_frame_stage stage);
 	void set_transparency(int transparency, bool save_as_normal = true);
 	int get_transparency();
 	void set_visibility(bool visibility, bool overlays_shown);
@@ -60,7 +183,9 @@ class overlay_window
 
 	virtual std::string get_status() = 0;
 
-	void check_autohide();
+	void check_autohide(uint64_t current_ticks);
+	uint64_t get_autohide_deadline();
+	void check_producer_signal(bool overlays_shown);
 	void reset_autohide_timer();
 
 	virtual ~overlay_window();
@@ -81,7 +206,7 @@ class overlay_window_gdi : public overlay_window
 	overlay_window_gdi();
 	virtual void clean_resources() override;
 
-	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height) override;
+	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects) override;
 	virtual bool create_window_content_buffer() override;
 	virtual void paint_to_window(HDC window_hdc) override;
 	void set_dbl_buffering(bool enable);
@@ -98,7 +223,7 @@ class overlay_window_direct2d : public overlay_window
 	overlay_window_direct2d();
 	virtual void clean_resources() override;
 
-	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height) override;
+	virtual bool apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects) override;
 	virtual bool create_window_content_buffer() override;
 	virtual void paint_to_window(HDC window_hdc) override;
 	virtual void create_render_target(ID2D1Factory* m_pDirect2dFactory) override;
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <shared_mutex>
+#include "overlay_deadlines.h"
+#include "overlay_hit_index.h"
+#include "overlay_registry.h"
 #include "stdafx.h"
 
 DWORD WINAPI overlay_thread_func(void* data);
@@ -16,6 +19,24 @@ class smg_overlays
 	void showup_overlays();
 	void apply_interactive_mode_view();
 
+	// overlay thread only
+	overlay_deadlines deadlines;
+	std::vector<overlay_deadline> due_deadlines;
+
+	overlay_hit_index hit_index;
+	// overlay thread only
+	bool hit_index_dirty;
+	std::vector<overlay_hit_rect> hit_rects;
+	std::vector<std::shared_ptr<overlay_window>> hit_overlays;
+	bool add_hit_rect(HWND window);
+
+	// windows calls can send messages to WndProc that need the list again, so they are made on a copy
+	void copy_overlays(std::vector<std::shared_ptr<overlay_window>>& to);
+	void schedule_autohide(std::shared_ptr<overlay_window>& overlay);
+	void schedule_held_frame(std::shared_ptr<overlay_window>& overlay);
+	void on_deadline(std::shared_ptr<overlay_window>& overlay, overlay_deadline_kind kind, uint64_t now);
+	void reschedule_overlays();
+
 	public:
 	mutable std::shared_mutex overlays_list_access;
 	bool showing_overlays;
@@ -23,7 +44,7 @@ class smg_overlays
 	static std::shared_ptr<smg_overlays> get_instance();
 
 	public:
-	std::list<std::shared_ptr<overlay_window>> showing_windows;
+	overlay_registry showing_windows;
 
 	smg_overlays();
 	virtual ~smg_overlays();
@@ -41,8 +62,12 @@ class smg_overlays
 	std::shared_ptr<overlay_window> get_overlay_by_window(HWND overlay_window);
 	std::vector<int> get_ids();
 	bool is_inside_overlay(int x , int y);
+	bool hit_test_overlays(int x, int y, overlay_hit& hit);
+	void invalidate_hit_index();
+	void update_hit_index();
 
 	bool remove_overlay(std::shared_ptr<overlay_window> overlay);
+	void on_window_create(HWND window, int overlay_id);
 	bool on_window_destroy(HWND window);
 	bool on_overlay_destroy(std::shared_ptr<overlay_window> overlay);
 
@@ -57,7 +82,11 @@ class smg_overlays
 	bool process_commands(MSG& msg);
 
 	//events
-	void on_update_timer();
+	void on_frame_ready(int overlay_id);
+	void on_frame_held(int overlay_id);
+	void on_deadlines();
+	DWORD get_wait_timeout();
+	void reschedule_overlay(std::shared_ptr<overlay_window>& overlay);
 
 	void draw_overlay(HWND& hWnd);
 
@@ -12,7 +12,9 @@ class smg_settings
 
 	int transparency; // o - 255
 	bool use_color_key;
-	int redraw_timeout; //ms
+	int frame_coalesce_timeout; //ms new frames wait before upload, frames coming meanwhile are uploaded together
+	int shared_frames_poll_timeout; //ms
+	bool detect_frame_damage; // compare frames without dirty rects with previous frame to find changed parts
 
 	void default_init();
 
@@ -96,6 +96,19 @@ const int COMMAND_RELEASE_INPUT = 8;
 //signal for overlay thread that it can create window for new overlay
 #define WM_SLO_OVERLAY_COMMAND (WM_USER + 44)
 
+//command for overlay thread to read frames of overlay from shared memory ring
+//wParam id
+//lParam overlay_shared_frames*, overlay takes ownership of it. nullptr to stop using ring
+#define WM_SLO_OVERLAY_SHARED_FRAMES (WM_USER + 45)
+
+//signal for overlay thread that new frame was published for overlay. posted once until overlay thread handles it
+//wParam id
+#define WM_SLO_OVERLAY_FRAME_READY (WM_USER + 46)
+
+//signal for overlay thread that frame rate limit holds a frame to publish later. posted once until overlay thread handles it
+//wParam id
+#define WM_SLO_OVERLAY_FRAME_HELD (WM_USER + 47)
+
 
 bool set_dpi_awareness();
 
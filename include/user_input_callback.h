@@ -1,21 +1,23 @@
 #pragma once
 
 #include <memory>
-#include <mutex>
-#include <queue>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 
+#include "overlay_hit_index.h"
+#include "overlay_input_ring.h"
+#include "overlay_js_strings.h"
 #include "sl_overlay_api.h"
 
 #include <node_api.h>
 #include <uv.h>
 
-struct wm_event_t;
+enum input_js_string : size_t;
 
 napi_status napi_create_and_set_named_property(napi_env& env, napi_value& obj, const char* value_name, const int value) noexcept;
+napi_status napi_create_and_set_named_property(napi_env& env, napi_value& obj, const char* value_name, const int64_t value) noexcept;
 
 struct callback_method_t
 {
@@ -45,6 +47,7 @@ struct callback_method_t
 	int use_callback(WPARAM wParam, LPARAM lParam);
 
 	bool ready;
+	bool batched; // one call per wake up with all events in Int32Array
 	static bool set_intercept_active(bool) noexcept;
 
 	static bool get_intercept_active() noexcept;
@@ -52,11 +55,19 @@ struct callback_method_t
 	static void static_async_callback(uv_async_t* handle);
 	void async_callback();
 
-	std::mutex send_queue_mutex;
-	std::queue<std::shared_ptr<wm_event_t>> to_send;
+	overlay_input_queue to_send;
+	overlay_js_strings js_strings; // JS thread only
+	napi_status get_js_string(napi_env env, input_js_string index, napi_value* result);
+	napi_status get_js_key_name(napi_env env, int key_code, napi_value* result);
+	// hook thread only. timer flushing events that wait for room in ring, 0 if none wait
+	static const UINT flush_waiting_ms = 10;
+	UINT_PTR flush_timer;
+	void flush_waiting();
+	napi_status set_batch_args_values(napi_env env, napi_value* batch, size_t& count);
+	virtual overlay_input_event capture_event(WPARAM wParam, LPARAM lParam) = 0;
 	virtual size_t get_argc_to_cb() = 0;
 	virtual napi_value* get_argv_to_cb() = 0;
-	virtual napi_status set_callback_args_values(napi_env env) 
+	virtual napi_status set_callback_args_values(napi_env env, const overlay_input_event& event) 
 	{
 		return napi_ok;
 	};
@@ -84,13 +95,14 @@ struct callback_keyboard_method_t : callback_method_t
 		return argv_to_cb;
 	};
 
-	napi_status set_callback_args_values(napi_env env)  override;
+	overlay_input_event capture_event(WPARAM wParam, LPARAM lParam) override;
+	napi_status set_callback_args_values(napi_env env, const overlay_input_event& event)  override;
 	void set_callback() override;
 };
 
 struct callback_mouse_method_t : callback_method_t
 {
-	const static size_t argc_to_cb = 4;
+	const static size_t argc_to_cb = 5;
 	napi_value argv_to_cb[argc_to_cb];
 
 	size_t get_argc_to_cb() noexcept override 
@@ -102,7 +114,8 @@ struct callback_mouse_method_t : callback_method_t
 		return argv_to_cb;
 	};
 
-	napi_status set_callback_args_values(napi_env env)  override;
+	overlay_input_event capture_event(WPARAM wParam, LPARAM lParam) override;
+	napi_status set_callback_args_values(napi_env env, const overlay_input_event& event)  override;
 	void set_callback() override;
 };
 
@@ -16,6 +16,93 @@ export type OverlayInfo = {
   y: number;
   /** Status of overlay, "ok" if everything went fine with that overlay */
   status: String;
+  /** Number of painted frames skipped because they were identical to the previous frame */
+  duplicateFramesSkipped: number;
+  /** Frame rate limit set by setFrameRateLimit, 0 if not limited */
+  frameRateLimit: number;
+  /** Number of painted frames accepted by frame rate limit */
+  framesAccepted: number;
+  /** Number of painted frames dropped by frame rate limit */
+  framesDropped: number;
+};
+
+/** Latencies of one stage of frames in microseconds, percentiles are exact within 1/16 of their value */
+export type LatencyStats = {
+  /** Number of frames measured */
+  count: number;
+  p50: number;
+  p95: number;
+  p99: number;
+  max: number;
+};
+
+/** Latencies of frames from paintOverlay until overlay window is painted, since overlay was created */
+export type FrameStats = {
+  /** paintOverlay called until overlay thread copied frame for upload */
+  copy: LatencyStats;
+  /** frame copied until overlay thread takes it for upload */
+  wake: LatencyStats;
+  /** frame taken until it is uploaded to window content */
+  upload: LatencyStats;
+  /** frame uploaded until window is painted */
+  present: LatencyStats;
+  /** paintOverlay called until window is painted */
+  total: LatencyStats;
+};
+
+/** Counters of an overlay since it was created */
+export type OverlayStats = {
+  id: OverlayId;
+  /** paintOverlay calls for the overlay */
+  framesReceived: number;
+  /** Frames uploaded to overlay window */
+  framesApplied: number;
+  framesDropped: {
+    /** overlays were hidden */
+    hidden: number;
+    /** frame size was not overlay size */
+    sizeMismatch: number;
+    /** over frame rate limit */
+    pacing: number;
+    /** identical to the previous frame */
+    duplicate: number;
+  };
+  /** Bytes written by each copy of frames */
+  bytes: {
+    /** scaling or cropping to overlay size */
+    fit: number;
+    /** copy of changed parts from paintOverlay buffer */
+    copy: number;
+    /** upload of changed parts to window */
+    upload: number;
+  };
+  /** Times overlay window was painted */
+  paintCalls: number;
+  /** Times overlay was hidden by autohide or shown again */
+  autohideTransitions: number;
+  /** Bytes held now */
+  memory: {
+    /** GDI or Direct2D bitmap of window */
+    contentBuffer: number;
+    /** buffers of frames passed to overlay thread */
+    frameBuffers: number;
+  };
+};
+
+/** Part of an image that was changed, in pixels of that image. Same shape as electron's Rectangle */
+export type DirtyRect = {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+};
+
+/** Where image is in the buffer given to paintOverlay, in bytes */
+export type FrameLayout = {
+  /** distance between starts of rows, width * 4 if omitted */
+  stride?: number;
+  /** start of first row */
+  offset?: number;
 };
 
 /** Native windows handle (WinAPI), encoded as a Node Buffer **/
@@ -40,6 +127,8 @@ export const enum OverlayThreadStatus {
  * can be performed (aside from `getStatus`). 
  * Can work again only when getStatus returns `destroyed`. 
  * 
+ * Log file is rotated at 10 MB, 4 older files are kept as logPath.1 to logPath.4
+ *
  * Return: 1 if everything went fine. 
  */
 export function start(logPath: String): number;
@@ -52,6 +141,35 @@ export function start(logPath: String): number;
  */
 export function stop(): number;
 
+/**
+ * Lowest level of lines written to the log. Lines of levels not compiled in (debug in release builds) are never written.
+ * Each logging statement writes at most 20 lines per second, skipped lines are counted in its next line
+ */
+export type LogLevel = 'debug' | 'info' | 'error' | 'none';
+
+/**
+ * Set lowest level of lines written to the log
+ *
+ * Return: 0 if level is known, -1 otherwise
+ */
+export function setLogLevel(level: LogLevel): number;
+
+/**
+ * Write the last 4096 events of the module (commands, frames, hook events, windows created and destroyed)
+ * to a text file. Events are recorded even when logging is off
+ *
+ * Return: 0 if file was written, -1 otherwise
+ */
+export function dumpFlightRecorder(path: string): number;
+
+/**
+ * Write flight recorder events to path when the process crashes on an unhandled exception.
+ * Off by default, as it installs a process wide unhandled exception filter. Empty path turns it off
+ *
+ * Return: 0 if it was set, -1 if path can not be used
+ */
+export function setFlightRecorderCrashDump(path: string): number;
+
 /**
  * Returns the number of overlays currently active
  */
@@ -72,6 +190,25 @@ export function getIds(): OverlayId[];
  */
 export function getInfo(id: OverlayId): OverlayInfo;
 
+/**
+ * Get latencies of frames of a specific overlay. Frames of shared frames have only upload and present stages
+ *
+ * @param id ID of the overlay
+ * @see {FrameStats}
+ */
+export function getFrameStats(id: OverlayId): FrameStats;
+
+/**
+ * Get counters of a specific overlay
+ *
+ * @param id ID of the overlay
+ * @see {OverlayStats}
+ */
+export function getStats(id: OverlayId): OverlayStats;
+
+/** Get counters of all overlays */
+export function getAllStats(): OverlayStats[];
+
 /** Show overlays */
 export function show(): void;
 
@@ -134,6 +271,85 @@ export function setVisibility(overlayId: OverlayId, transparency: boolean): void
  */
 export function setAutohide(overlayId: OverlayId, autohideTimeout: number, autohideTransparency: number): void;
 
+/**
+ * Pixel layout of images given to paintOverlay.
+ * "bgra" and "rgba" have straight alpha, "-premultiplied" ones have color already multiplied by alpha
+ */
+export type PixelFormat = 'bgra-premultiplied' | 'bgra' | 'rgba-premultiplied' | 'rgba';
+
+/**
+ * Set format of images given to paintOverlay, they are converted to premultiplied BGRA while copied.
+ * Applied from the next painted image
+ *
+ * @param overlayId ID of the overlay
+ * @param format pixel format of images, "bgra-premultiplied" by default
+ * @param globalAlpha optional 0-255 alpha multiplied into every pixel, 255 by default
+ * @returns overlay id or -1 if it fails
+ */
+export function setPixelFormat(overlayId: OverlayId, format: PixelFormat, globalAlpha?: number): number;
+
+/**
+ * What to do with images given to paintOverlay when their size is not the overlay size.
+ * "resize" drops image and resizes overlay to it, "scale" scales image to overlay size, "crop" uses top left part of image
+ */
+export type FrameFit = 'resize' | 'scale' | 'crop';
+
+/**
+ * Set how images of other size than the overlay are painted. With "scale" and "crop" overlay keeps its size and no frames are dropped
+ *
+ * @param overlayId ID of the overlay
+ * @param fit "resize" by default
+ * @returns overlay id or -1 if it fails
+ */
+export function setFrameFit(overlayId: OverlayId, fit: FrameFit): number;
+
+/**
+ * Limit how often images given to paintOverlay are accepted. Images coming faster are dropped before they are processed,
+ * only the newest dropped image is kept and painted when the limit allows it if no newer image came by then.
+ *
+ * @param overlayId ID of the overlay
+ * @param fps max frames per second, 0 to remove the limit
+ * @returns overlay id or -1 if it fails
+ */
+export function setFrameRateLimit(overlayId: OverlayId, fps: number): number;
+
+/**
+ * Create a named shared memory ring of frames for an overlay. A producer in another thread or
+ * process opens the ring by name and writes premultiplied BGRA frames into it, see include/overlay_shared_frames.h
+ * for its layout. Overlay thread uploads frames right from the ring, no paintOverlay calls are needed.
+ * Ring is removed when it is detached or overlay is removed
+ *
+ * @param overlayId ID of the overlay
+ * @param name name of shared memory
+ * @param maxWidth biggest frame width the ring can hold
+ * @param maxHeight biggest frame height the ring can hold
+ * @returns overlay id or -1 if it fails
+ */
+export function attachSharedFrames(overlayId: OverlayId, name: string, maxWidth: number, maxHeight: number): number;
+
+/**
+ * Stop reading frames from shared memory ring and remove it
+ *
+ * @param overlayId ID of the overlay
+ * @returns overlay id or -1 if it fails
+ */
+export function detachSharedFrames(overlayId: OverlayId): number;
+
+/**
+ * Event sent to frame producers. "pause" while overlay can not be seen, "slowDown" while overlay
+ * uses fewer frames than it gets or is autohidden, "resume" when frames are needed at full rate again
+ */
+export type FrameEvent = 'pause' | 'resume' | 'slowDown';
+
+/**
+ * Set callback to tell frame producers when to stop painting or paint slower.
+ * Events are sent only when state of an overlay changes. Callback does not keep node process running
+ *
+ * @param callback called with overlay id, event and suggested frames per second for "slowDown", 0 for other events.
+ * Call without callback to remove it
+ */
+export function setFrameEventsCallback(callback?: (overlayId: OverlayId, event: FrameEvent, fps: number) => void): void;
+
 /**
  * Send image from electron window to be painted on overlay 
  *
@@ -141,19 +357,23 @@ export function setAutohide(overlayId: OverlayId, autohideTimeout: number, autoh
  * @param width width of image in buffer 
  * @param height height of image in buffer 
  * @param image buffer with native image what electron gives
+ * @param dirtyRects optional rect or list of rects what changed since previous image. Only these parts are copied and repainted. Whole image if omitted
+ * @param layout optional stride and offset, to paint padded rows or a part of a bigger buffer without repacking it
  * @returns a number :
  *   1 if it fails
- *   0 if overlay expected other image size, it will try to resize to it( should be painted again later) 
+ *   0 if overlay expected other image size, it will try to resize to it( should be painted again later). Only with "resize" frame fit 
+ *   2 if image came faster than frame rate limit and was dropped, its dirty rects are added to the next painted image.
+ *     The newest such image is painted later if no other image is accepted before
  *   1 for success 
  * @example
  *   win.webContents.on('paint', (event, dirty, image) => {
- *     if ( streamlabs_overlays.paintOverlay(overlayid, image.getSize().width, image.getSize().height, image.getBitmap()) == 0 )
+ *     if ( streamlabs_overlays.paintOverlay(overlayid, image.getSize().width, image.getSize().height, image.getBitmap(), dirty) == 0 )
  *     {
  *       win.webContents.invalidate();
  *     }
  *   })
  */
-export function paintOverlay(overlayId: OverlayId, width: number, height: number, image: Buffer): number;
+export function paintOverlay(overlayId: OverlayId, width: number, height: number, image: Buffer, dirtyRects?: DirtyRect | DirtyRect[], layout?: FrameLayout): number;
 
 /**
  * Remove an overlay
@@ -169,19 +389,50 @@ export function remove(id: OverlayId): void;
  */
 export function getStatus(): OverlayThreadStatus;
 
+/**
+ * Input event types in batches of events
+ */
+export const enum InputEventType {
+  Unknown = 0,
+  KeyDown,
+  KeyUp,
+  Char,
+  MouseMove,
+  MouseDown,
+  MouseUp,
+  MouseWheel,
+}
+
+/**
+ * Callback for batched input. Every event is 10 numbers in order:
+ * type (InputEventType), code (virtual key code, mouse button 1 left and 2 right, or wheel 0 vertical and 1 horizontal),
+ * scan code, hook flags, overlay id (0 for keyboard), x, y (inside overlay), wheel delta (120 per notch),
+ * time of event in ms, count of mouse moves merged into this event
+ */
+export type InputBatchCallback = (events: Int32Array) => void;
+
 /**
  * Set callback for mouse events 
- * setMouseCallback( (eventType, x, y, modifier) => {
+ * setMouseCallback( (eventType, x, y, modifier, overlayId) => {
+ * x, y are coordinates inside overlay
  * 
+ * @param batched callback is called once per wake up with all events waiting, see InputBatchCallback
  */
-export function setMouseCallback(callback: Function): void;
+export function setMouseCallback(callback: Function, batched?: boolean): void;
 
 /**
  * Set callback for keyboard events 
  * setKeyboardCallback( (eventType, keyCode) => {
  * 
+ * @param batched callback is called once per wake up with all events waiting, see InputBatchCallback
+ */
+export function setKeyboardCallback(callback: Function, batched?: boolean): void;
+
+/**
+ * Returns the number of mouse moves dropped because JS was too far behind.
+ * Buttons, wheel and keys are never dropped
  */
-export function setKeyboardCallback(callback: Function): void;
+export function getInputDroppedCount(): number;
 
 /**
  * Switch on/off interactive mode for overlays
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <iostream>
 
+#include "overlay_flight_recorder.h"
 #include "overlay_logging.h"
 #include "sl_overlay_window.h"
 #include "sl_overlays_settings.h"
@@ -29,8 +30,145 @@ DWORD overlays_thread_id = 0;
 sl_overlay_thread_state thread_state = sl_overlay_thread_state::destoyed;
 std::mutex thread_state_mutex;
 
-UINT_PTR OVERLAY_UPDATE_TIMER = 0;
+static void process_thread_message(std::shared_ptr<smg_overlays>& app, MSG& msg)
+{
+	bool catched = false;
+
+	if (msg.message >= WM_USER)
+	{
+		record_flight_event(overlay_flight_event::command, 0, static_cast<int>(msg.message - WM_USER), static_cast<int>(msg.wParam));
+	}
+
+	switch (msg.message)
+	{
+	case WM_SLO_OVERLAY_CLOSE:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_CLOSE " << (int)msg.wParam << std::endl;
+		auto closed = app->get_overlay_by_id((int)msg.wParam);
+		app->remove_overlay(closed);
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_POSITION:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_POSITION " << (int)msg.wParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+		RECT* new_rect = reinterpret_cast<RECT*>(msg.lParam);
+		if (new_rect != nullptr)
+		{
+			if (overlay != nullptr)
+			{
+				log_debug << "APP: WM_SLO_OVERLAY_POSITION " << new_rect->left << " " << new_rect->top << std::endl;
+				overlay->apply_new_rect(*new_rect);
+			}
+			delete new_rect;
+		}
+		catched = true;
+	}
+	break;
 
+	case WM_SLO_OVERLAY_TRANSPARENCY:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_TRANSPARENCY " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+
+		if (overlay != nullptr)
+		{
+			overlay->set_transparency((int)msg.lParam);
+		}
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_VISIBILITY:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_VISIBILITY " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+
+		if (overlay != nullptr)
+		{
+
+			overlay->set_visibility((bool)msg.lParam, app->showing_overlays);
+			app->reschedule_overlay(overlay);
+			app->invalidate_hit_index();
+		}
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_SET_AUTOHIDE:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_SET_AUTOHIDE " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+
+		if (overlay != nullptr)
+		{
+			const int autohide_timeout = (int)msg.lParam >> 10;
+			const int autohide_transparency = (int)msg.lParam % 512;
+			overlay->set_autohide(autohide_timeout, autohide_transparency);
+			app->reschedule_overlay(overlay);
+		}
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_SHARED_FRAMES:
+	{
+		log_info << "APP: WM_SLO_OVERLAY_SHARED_FRAMES " << (int)msg.wParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+		overlay_shared_frames* shared_frames = reinterpret_cast<overlay_shared_frames*>(msg.lParam);
+
+		if (overlay != nullptr)
+		{
+			overlay->set_shared_frames(shared_frames);
+			app->reschedule_overlay(overlay);
+		} else
+		{
+			delete shared_frames;
+		}
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_WINDOW_DESTOYED:
+	{
+		log_info << "APP: WM_OVERLAY_WINDOW_DESTOYED " << (int)msg.wParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+		app->on_overlay_destroy(overlay);
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_COMMAND:
+	{
+		catched = app->process_commands(msg);
+	}
+	break;
+	case WM_SLO_HWND_SOURCE_READY:
+	{
+		log_info << "APP: WM_SLO_HWND_SOURCE_READY " << (int)msg.wParam << std::endl;
+		std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+		app->create_window_for_overlay(overlay);
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_FRAME_READY:
+	{
+		app->on_frame_ready((int)msg.wParam);
+		catched = true;
+	}
+	break;
+	case WM_SLO_OVERLAY_FRAME_HELD:
+	{
+		app->on_frame_held((int)msg.wParam);
+		catched = true;
+	}
+	break;
+	default:
+		break;
+	};
+
+	if (!catched)
+	{
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+}
 
 DWORD WINAPI overlay_thread_func(void* data)
 {
@@ -47,132 +185,37 @@ DWORD WINAPI overlay_thread_func(void* data)
 	{
 		app->init();
 
-		OVERLAY_UPDATE_TIMER = SetTimer(0, 0, app_settings->redraw_timeout, (TIMERPROC) nullptr);
-
 		thread_state_mutex.lock();
 		thread_state = sl_overlay_thread_state::runing;
 		thread_state_mutex.unlock();
+		record_flight_event(overlay_flight_event::thread_started, 0);
 
-		// Main message loop
+		// Main message loop. thread sleeps until a message comes or the nearest deadline of overlays
 		MSG msg;
-		while (GetMessage(&msg, nullptr, 0, 0))
+		bool quit = false;
+		while (!quit)
 		{
-			//log_debug << "APP: wnd proc msg id " << msg.message << " for hwnd " << msg.hwnd << std::endl;
-			bool catched = false;
-
-			switch (msg.message)
-			{
-			case WM_SLO_OVERLAY_CLOSE:
-			{
-				log_info << "APP: WM_SLO_OVERLAY_CLOSE " << (int)msg.wParam << std::endl;
-				auto closed = app->get_overlay_by_id((int)msg.wParam);
-				app->remove_overlay(closed);
-				catched = true;
-			}
-			break;
-			case WM_SLO_OVERLAY_POSITION:
-			{
-				log_info << "APP: WM_SLO_OVERLAY_POSITION " << (int)msg.wParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
-				RECT* new_rect = reinterpret_cast<RECT*>(msg.lParam);
-				if (new_rect != nullptr)
-				{
-					if (overlay != nullptr)
-					{
-						log_debug << "APP: WM_SLO_OVERLAY_POSITION " << new_rect->left << " " << new_rect->top << std::endl;
-						overlay->apply_new_rect(*new_rect);
-					}
-					delete new_rect;
-				}
-				catched = true;
-			}
-			break;
-
-			case WM_SLO_OVERLAY_TRANSPARENCY:
-			{
-				log_info << "APP: WM_SLO_OVERLAY_TRANSPARENCY " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
-
-				if (overlay != nullptr)
-				{
-					overlay->set_transparency((int)msg.lParam);
-				}
-				catched = true;
-			}
-			break;
-			case WM_SLO_OVERLAY_VISIBILITY:
-			{
-				log_info << "APP: WM_SLO_OVERLAY_VISIBILITY " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
+			MsgWaitForMultipleObjectsEx(0, nullptr, app->get_wait_timeout(), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
 
-				if (overlay != nullptr)
-				{
-
-					overlay->set_visibility((bool)msg.lParam, app->showing_overlays);
-				}
-				catched = true;
-			}
-			break;
-			case WM_SLO_OVERLAY_SET_AUTOHIDE:
+			while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
 			{
-				log_info << "APP: WM_SLO_OVERLAY_SET_AUTOHIDE " << (int)msg.wParam << ", " << (int)msg.lParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
-
-				if (overlay != nullptr)
+				if (msg.message == WM_QUIT)
 				{
-					const int autohide_timeout = (int)msg.lParam >> 10;
-					const int autohide_transparency = (int)msg.lParam % 512;
-					overlay->set_autohide(autohide_timeout, autohide_transparency);
+					quit = true;
+					break;
 				}
-				catched = true;
-			}
-			break;
-			case WM_SLO_OVERLAY_WINDOW_DESTOYED:
-			{
-				log_info << "APP: WM_OVERLAY_WINDOW_DESTOYED " << (int)msg.wParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
-				app->on_overlay_destroy(overlay);
-				catched = true;
+				process_thread_message(app, msg);
 			}
-			break;
-			case WM_SLO_OVERLAY_COMMAND:
-			{
-				catched = app->process_commands(msg);
-			}
-			break;
-			case WM_SLO_HWND_SOURCE_READY:
-			{
-				log_info << "APP: WM_SLO_HWND_SOURCE_READY " << (int)msg.wParam << std::endl;
-				std::shared_ptr<overlay_window> overlay = app->get_overlay_by_id((int)msg.wParam);
-				app->create_window_for_overlay(overlay);
-				catched = true;
-			}
-			break;
-			case WM_TIMER:
-				if (static_cast<int>(msg.wParam) == OVERLAY_UPDATE_TIMER)
-				{
-					app->on_update_timer();
-					catched = true;
-				}
-				break;
-			default:
-				break;
-			};
 
-			if (!catched)
-			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
-			}
+			app->on_deadlines();
+			app->update_hit_index();
 		}
 
-		KillTimer(0, OVERLAY_UPDATE_TIMER);
-		OVERLAY_UPDATE_TIMER = 0;
-
 		CoUninitialize();
 	}
 
 	app->deinit(); //todo clean singleton in case some one start thread another time after stop
+	record_flight_event(overlay_flight_event::thread_stopped, 0);
 
 	log_info << "APP: exit from thread " << std::endl;
 
@@ -193,6 +236,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
 	switch (message)
 	{
+	case WM_NCCREATE:
+	{
+		const CREATESTRUCT* create_params = reinterpret_cast<CREATESTRUCT*>(lParam);
+		smg_overlays::get_instance()->on_window_create(hWnd, static_cast<int>(reinterpret_cast<INT_PTR>(create_params->lpCreateParams)));
+	}
+	break;
 	case WM_CREATE:
 	{}
 	break;
@@ -220,6 +269,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 		return 0;
 	}
 	break;
+	case WM_WINDOWPOSCHANGED:
+	{
+		smg_overlays::get_instance()->invalidate_hit_index();
+	}
+	break;
 	case WM_ERASEBKGND:
 	{
 		// Don't do any erasing here.  It's done in WM_PAINT to avoid flicker.
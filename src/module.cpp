@@ -22,10 +22,12 @@
 #include <vector>
 
 #include <node_api.h>
+#include "overlay_dirty_rects.h"
+#include "overlay_flight_recorder.h"
+#include "overlay_frame_events.h"
 #include "overlay_logging.h"
-
-#include "overlay_paint_frame.h"
-#include "overlay_paint_frame_js.h"
+#include "overlay_painted_buffers.h"
+#include "overlay_pixel_kernels.h"
 
 const napi_value failed_ret = nullptr;
 napi_value Start(napi_env env, napi_callback_info args)
@@ -236,11 +238,12 @@ napi_value SetKeyboardCallback(napi_env env, napi_callback_info args)
 		napi_delete_reference(env, user_keyboard_callback_info->js_this);
 	}  
 
-	size_t argc = 1;
-	napi_value argv[1];
+	size_t argc = 2;
+	napi_value argv[2];
 	napi_value js_this;
 	napi_value js_callback;
 	napi_valuetype is_function = napi_undefined;
+	bool batched = false;
 
 	if (napi_get_cb_info(env, args, &argc, argv, &js_this, 0) != napi_ok)
 		return failed_ret;
@@ -252,12 +255,20 @@ napi_value SetKeyboardCallback(napi_env env, napi_callback_info args)
 	if (napi_typeof(env, js_callback, &is_function) != napi_ok)
 		return failed_ret;
 
+	if (argc > 1)
+	{
+		if (napi_get_value_bool(env, argv[1], &batched) != napi_ok)
+			return failed_ret;
+	}
+
 	if (is_function == napi_function)
 	{
 		//save reference and go to creating threadsafe function
 		if (napi_create_reference(env, argv[0], 1, &user_keyboard_callback_info->js_this) != napi_ok)
 			return failed_ret;
 
+		user_keyboard_callback_info->batched = batched;
+
 		user_keyboard_callback_info->callback_init(env, args, "func_keyboard");
 	}
 
@@ -273,11 +284,12 @@ napi_value SetMouseCallback(napi_env env, napi_callback_info args)
 		napi_delete_reference(env, user_mouse_callback_info->js_this);
 	}  
 
-	size_t argc = 1;
-	napi_value argv[1];
+	size_t argc = 2;
+	napi_value argv[2];
 	napi_value js_this;
 	napi_value js_callback;
 	napi_valuetype is_function = napi_undefined;
+	bool batched = false;
 
 	if (napi_get_cb_info(env, args, &argc, argv, &js_this, 0) != napi_ok)
 		return failed_ret;
@@ -289,18 +301,42 @@ napi_value SetMouseCallback(napi_env env, napi_callback_info args)
 	if (napi_typeof(env, js_callback, &is_function) != napi_ok)
 		return failed_ret;
 
+	if (argc > 1)
+	{
+		if (napi_get_value_bool(env, argv[1], &batched) != napi_ok)
+			return failed_ret;
+	}
+
 	if (is_function == napi_function)
 	{
 		//save reference and go to creating threadsafe function
 		if (napi_create_reference(env, argv[0], 1, &user_mouse_callback_info->js_this) != napi_ok)
 			return failed_ret;
 
+		user_mouse_callback_info->batched = batched;
+
 		user_mouse_callback_info->callback_init(env, args, "func_mouse");
 	}
 
 	return nullptr;
 }
 
+// mouse moves dropped while JS was behind, buttons, wheel and keys are never dropped
+napi_value GetInputDroppedCount(napi_env env, napi_callback_info args)
+{
+	uint64_t dropped = 0;
+	if (user_keyboard_callback_info != nullptr)
+		dropped += user_keyboard_callback_info->to_send.get_dropped_count();
+	if (user_mouse_callback_info != nullptr)
+		dropped += user_mouse_callback_info->to_send.get_dropped_count();
+
+	napi_value ret = nullptr;
+	if (napi_create_int64(env, static_cast<int64_t>(dropped), &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
 napi_value GetOverlayInfo(napi_env env, napi_callback_info args)
 {
 	size_t argc = 1;
@@ -338,6 +374,18 @@ napi_value GetOverlayInfo(napi_env env, napi_callback_info args)
 		if (napi_create_and_set_named_property(env, ret, "y", overlay_rect.top) != napi_ok)
 			return failed_ret;
 
+		if (napi_create_and_set_named_property(env, ret, "duplicateFramesSkipped", static_cast<int64_t>(requested_overlay->get_duplicate_frames_skipped())) != napi_ok)
+			return failed_ret;
+
+		if (napi_create_and_set_named_property(env, ret, "frameRateLimit", requested_overlay->get_frame_rate_limit()) != napi_ok)
+			return failed_ret;
+
+		if (napi_create_and_set_named_property(env, ret, "framesAccepted", static_cast<int64_t>(requested_overlay->get_frames_accepted())) != napi_ok)
+			return failed_ret;
+
+		if (napi_create_and_set_named_property(env, ret, "framesDropped", static_cast<int64_t>(requested_overlay->get_frames_dropped())) != napi_ok)
+			return failed_ret;
+
 		std::string overlay_status = requested_overlay->get_status();
 		napi_value overlay_status_value;
 		if (napi_create_string_utf8(env, overlay_status.c_str(), overlay_status.size(), &overlay_status_value) == napi_ok)
@@ -350,6 +398,171 @@ napi_value GetOverlayInfo(napi_env env, napi_callback_info args)
 	return failed_ret;
 }
 
+static napi_status create_latency_stats(napi_env env, const overlay_latency_histogram& histogram, napi_value& stats)
+{
+	napi_status status = napi_create_object(env, &stats);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, stats, "count", static_cast<int64_t>(histogram.get_count()));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, stats, "p50", static_cast<int64_t>(histogram.get_percentile(50)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, stats, "p95", static_cast<int64_t>(histogram.get_percentile(95)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, stats, "p99", static_cast<int64_t>(histogram.get_percentile(99)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, stats, "max", static_cast<int64_t>(histogram.get_max()));
+	return status;
+}
+
+napi_value GetFrameStats(napi_env env, napi_callback_info args)
+{
+	size_t argc = 1;
+	napi_value argv[1];
+	int32_t overlay_id;
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+		return failed_ret;
+
+	// overlays are gone when thread is not running
+	std::shared_ptr<smg_overlays> overlays = get_overlays();
+	if (!overlays)
+		return failed_ret;
+
+	std::shared_ptr<overlay_window> requested_overlay = overlays->get_overlay_by_id(overlay_id);
+	if (!requested_overlay)
+		return failed_ret;
+
+	napi_value ret;
+	if (napi_create_object(env, &ret) != napi_ok)
+		return failed_ret;
+
+	for (int i = 0; i < static_cast<int>(overlay_frame_stage::count); i++)
+	{
+		const overlay_frame_stage stage = static_cast<overlay_frame_stage>(i);
+		napi_value stats;
+		if (create_latency_stats(env, requested_overlay->get_frame_latency(stage), stats) != napi_ok)
+			return failed_ret;
+		if (napi_set_named_property(env, ret, get_frame_stage_name(stage), stats) != napi_ok)
+			return failed_ret;
+	}
+
+	return ret;
+}
+
+static napi_status create_overlay_stats(napi_env env, const std::shared_ptr<overlay_window>& overlay, napi_value& ret)
+{
+	overlay_stats& stats = overlay->get_stats();
+	napi_value dropped;
+	napi_value bytes;
+	napi_value memory;
+
+	napi_status status = napi_create_object(env, &ret);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, ret, "id", overlay->id);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, ret, "framesReceived", static_cast<int64_t>(overlay_stats::get(stats.frames_received)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, ret, "framesApplied", static_cast<int64_t>(overlay_stats::get(stats.frames_applied)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, ret, "paintCalls", static_cast<int64_t>(overlay_stats::get(stats.paint_calls)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, ret, "autohideTransitions", static_cast<int64_t>(overlay_stats::get(stats.autohide_transitions)));
+
+	if (status == napi_ok)
+		status = napi_create_object(env, &dropped);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, dropped, "hidden", static_cast<int64_t>(overlay_stats::get(stats.frames_dropped_hidden)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, dropped, "sizeMismatch", static_cast<int64_t>(overlay_stats::get(stats.frames_dropped_size)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, dropped, "pacing", static_cast<int64_t>(overlay->get_frames_dropped()));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, dropped, "duplicate", static_cast<int64_t>(overlay->get_duplicate_frames_skipped()));
+	if (status == napi_ok)
+		status = napi_set_named_property(env, ret, "framesDropped", dropped);
+
+	if (status == napi_ok)
+		status = napi_create_object(env, &bytes);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, bytes, "fit", static_cast<int64_t>(overlay_stats::get(stats.bytes_fitted)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, bytes, "copy", static_cast<int64_t>(overlay_stats::get(stats.bytes_copied)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, bytes, "upload", static_cast<int64_t>(overlay_stats::get(stats.bytes_uploaded)));
+	if (status == napi_ok)
+		status = napi_set_named_property(env, ret, "bytes", bytes);
+
+	if (status == napi_ok)
+		status = napi_create_object(env, &memory);
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, memory, "contentBuffer", static_cast<int64_t>(overlay_stats::get(stats.content_buffer_bytes)));
+	if (status == napi_ok)
+		status = napi_create_and_set_named_property(env, memory, "frameBuffers", static_cast<int64_t>(overlay->get_frame_buffers_bytes()));
+	if (status == napi_ok)
+		status = napi_set_named_property(env, ret, "memory", memory);
+
+	return status;
+}
+
+napi_value GetOverlayStats(napi_env env, napi_callback_info args)
+{
+	size_t argc = 1;
+	napi_value argv[1];
+	int32_t overlay_id;
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+		return failed_ret;
+
+	std::shared_ptr<smg_overlays> overlays = get_overlays();
+	if (!overlays)
+		return failed_ret;
+
+	std::shared_ptr<overlay_window> requested_overlay = overlays->get_overlay_by_id(overlay_id);
+	if (!requested_overlay)
+		return failed_ret;
+
+	napi_value ret;
+	if (create_overlay_stats(env, requested_overlay, ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value GetAllOverlaysStats(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+	if (napi_create_array(env, &ret) != napi_ok)
+		return failed_ret;
+
+	// empty list when thread is not running
+	std::shared_ptr<smg_overlays> overlays = get_overlays();
+	if (!overlays)
+		return ret;
+
+	std::vector<int> ids = overlays->get_ids();
+	uint32_t index = 0;
+	for (int overlay_id : ids)
+	{
+		// overlay could be removed after ids were taken
+		std::shared_ptr<overlay_window> overlay = overlays->get_overlay_by_id(overlay_id);
+		if (!overlay)
+			continue;
+
+		napi_value stats;
+		if (create_overlay_stats(env, overlay, stats) != napi_ok)
+			return failed_ret;
+
+		if (napi_set_element(env, ret, index++, stats) != napi_ok)
+			return failed_ret;
+	}
+
+	return ret;
+}
+
 napi_value GetOverlaysIDs(napi_env env, napi_callback_info args)
 {
 	std::vector<int> ids = get_overlays()->get_ids();
@@ -411,21 +624,120 @@ napi_value SetOverlayPosition(napi_env env, napi_callback_info args)
 	return ret;
 }
 
+static bool get_dirty_rect(napi_env env, napi_value js_rect, overlay_pixel_rect& rect)
+{
+	const char* names[4] = {"x", "y", "width", "height"};
+	int values[4] = {0};
+
+	for (int i = 0; i < 4; i++)
+	{
+		napi_value value;
+		if (napi_get_named_property(env, js_rect, names[i], &value) != napi_ok)
+			return false;
+		if (napi_get_value_int32(env, value, &values[i]) != napi_ok)
+			return false;
+	}
+
+	// int32 edges of a rect far from frame could overflow, it is clipped to frame later
+	rect = make_pixel_rect(values[0], values[1], values[2], values[3]);
+
+	return true;
+}
+
+// accepts one electron Rectangle or an array of them
+static bool get_dirty_rects(napi_env env, napi_value js_rects, overlay_dirty_rects& rects)
+{
+	napi_valuetype rects_type = napi_undefined;
+	if (napi_typeof(env, js_rects, &rects_type) != napi_ok)
+		return false;
+
+	if (rects_type == napi_undefined || rects_type == napi_null)
+		return true;
+
+	bool is_array = false;
+	if (napi_is_array(env, js_rects, &is_array) != napi_ok)
+		return false;
+
+	if (!is_array)
+	{
+		overlay_pixel_rect rect;
+		if (!get_dirty_rect(env, js_rects, rect))
+			return false;
+		rects.add(rect);
+		return true;
+	}
+
+	uint32_t rects_count = 0;
+	if (napi_get_array_length(env, js_rects, &rects_count) != napi_ok)
+		return false;
+
+	for (uint32_t i = 0; i < rects_count; i++)
+	{
+		napi_value js_rect;
+		overlay_pixel_rect rect;
+		if (napi_get_element(env, js_rects, i, &js_rect) != napi_ok)
+			return false;
+		if (!get_dirty_rect(env, js_rect, rect))
+			return false;
+		rects.add(rect);
+	}
+
+	return true;
+}
+
+// { stride, offset } in bytes, both optional
+static bool get_frame_layout(napi_env env, napi_value js_layout, size_t& stride, size_t& offset)
+{
+	napi_valuetype layout_type = napi_undefined;
+	if (napi_typeof(env, js_layout, &layout_type) != napi_ok)
+		return false;
+
+	if (layout_type == napi_undefined || layout_type == napi_null)
+		return true;
+
+	const char* names[2] = {"stride", "offset"};
+	size_t* values[2] = {&stride, &offset};
+	for (int i = 0; i < 2; i++)
+	{
+		bool has_value = false;
+		if (napi_has_named_property(env, js_layout, names[i], &has_value) != napi_ok)
+			return false;
+		if (!has_value)
+			continue;
+
+		napi_value value;
+		int64_t number = 0;
+		if (napi_get_named_property(env, js_layout, names[i], &value) != napi_ok)
+			return false;
+		if (napi_get_value_int64(env, value, &number) != napi_ok || number < 0 || static_cast<uint64_t>(number) > SIZE_MAX)
+			return false;
+
+		*values[i] = static_cast<size_t>(number);
+	}
+
+	return true;
+}
+
 napi_value PaintOverlay(napi_env env, napi_callback_info args)
 {
 	napi_value ret = nullptr;
 
-	size_t argc = 4;
-	napi_value argv[4];
+	size_t argc = 6;
+	napi_value argv[6];
 	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
 		return failed_ret;
 
 	int painted = -1;
-	if (argc == 4)
+	if (argc >= 4 && argc <= 6)
 	{
 		int overlay_id = -1;
 		int width = 0;
 		int height = 0;
+		overlay_dirty_rects dirty_rects;
+		void* image_array = nullptr;
+		size_t image_array_size = 0;
+		size_t stride = 0;
+		size_t offset = 0;
 
 		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
 			return failed_ret;
@@ -433,12 +745,27 @@ napi_value PaintOverlay(napi_env env, napi_callback_info args)
 			return failed_ret;
 		if (napi_get_value_int32(env, argv[2], &height) != napi_ok)
 			return failed_ret;
-		
+		if (napi_get_buffer_info(env, argv[3], &image_array, &image_array_size) != napi_ok)
+			return failed_ret;
 
-		overlay_frame_js * for_caching_js = new overlay_frame_js(env, argv[3]);
-		std::shared_ptr<overlay_frame> for_caching = std::make_shared<overlay_frame>(for_caching_js);
-		
-		painted = paint_overlay_cached_buffer(overlay_id, for_caching, width, height);
+		if (argc >= 5 && !get_dirty_rects(env, argv[4], dirty_rects))
+		{
+			log_error << "APP: PaintOverlay failed to read dirty rects, will paint whole frame" << std::endl;
+			dirty_rects.clear();
+		}
+
+		if (argc == 6 && !get_frame_layout(env, argv[5], stride, offset))
+		{
+			log_error << "APP: PaintOverlay failed to read frame layout" << std::endl;
+			return failed_ret;
+		}
+
+		// image is read later on overlay thread, reference keeps buffer alive until then
+		void* keeper = nullptr;
+		if (keep_painted_buffer(env, argv[3], &keeper) != napi_ok)
+			return failed_ret;
+
+		painted = paint_overlay_cached_buffer(overlay_id, image_array, image_array_size, width, height, dirty_rects, stride, offset, keeper, &release_painted_buffer);
 	}
 
 	if (napi_create_int32(env, painted, &ret) != napi_ok)
@@ -550,10 +877,321 @@ napi_value SetOverlayAutohide(napi_env env, napi_callback_info args)
 	return ret;
 }
 
+napi_value SetOverlayPixelFormat(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 3;
+	napi_value argv[3];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int set_pixel_format_result = -1;
+	if (argc == 2 || argc == 3)
+	{
+		int overlay_id = -1;
+		char format_name[32];
+		size_t format_name_size = 0;
+		int global_alpha = 255;
+
+		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_string_utf8(env, argv[1], format_name, sizeof(format_name), &format_name_size) != napi_ok)
+			return failed_ret;
+
+		if (argc == 3)
+		{
+			if (napi_get_value_int32(env, argv[2], &global_alpha) != napi_ok)
+				return failed_ret;
+		}
+
+		const std::string format(format_name, format_name_size);
+		const bool known_format = format == "bgra-premultiplied" || format == "bgra" || format == "rgba-premultiplied" || format == "rgba";
+
+		overlay_pixel_conversion conversion;
+		conversion.swap_red_blue = format == "rgba" || format == "rgba-premultiplied";
+		conversion.premultiply = format == "bgra" || format == "rgba";
+		conversion.global_alpha = static_cast<uint8_t>(global_alpha < 0 ? 0 : (global_alpha > 255 ? 255 : global_alpha));
+
+		log_info << "APP: SetOverlayPixelFormat " << format << ", " << global_alpha << std::endl;
+		if (known_format)
+		{
+			set_pixel_format_result = set_overlay_pixel_format(overlay_id, conversion);
+		}
+	}
+
+	if (napi_create_int32(env, set_pixel_format_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value SetOverlayFrameFit(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 2;
+	napi_value argv[2];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int set_frame_fit_result = -1;
+	if (argc == 2)
+	{
+		int overlay_id = -1;
+		char fit_name[32];
+		size_t fit_name_size = 0;
+
+		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_string_utf8(env, argv[1], fit_name, sizeof(fit_name), &fit_name_size) != napi_ok)
+			return failed_ret;
+
+		const std::string fit(fit_name, fit_name_size);
+		log_info << "APP: SetOverlayFrameFit " << fit << std::endl;
+		if (fit == "resize")
+		{
+			set_frame_fit_result = set_overlay_frame_fit(overlay_id, overlay_frame_fit::resize_overlay);
+		} else if (fit == "scale")
+		{
+			set_frame_fit_result = set_overlay_frame_fit(overlay_id, overlay_frame_fit::scale);
+		} else if (fit == "crop")
+		{
+			set_frame_fit_result = set_overlay_frame_fit(overlay_id, overlay_frame_fit::crop);
+		}
+	}
+
+	if (napi_create_int32(env, set_frame_fit_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value SetLogLevel(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 1;
+	napi_value argv[1];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int set_level_result = -1;
+	if (argc == 1)
+	{
+		char level_name[16];
+		size_t level_name_size = 0;
+
+		if (napi_get_value_string_utf8(env, argv[0], level_name, sizeof(level_name), &level_name_size) != napi_ok)
+			return failed_ret;
+
+		const std::string level(level_name, level_name_size);
+		if (logging_set_level(level))
+		{
+			set_level_result = 0;
+		}
+		log_info << "APP: SetLogLevel " << level << ", result " << set_level_result << std::endl;
+	}
+
+	if (napi_create_int32(env, set_level_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value DumpFlightRecorder(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 1;
+	napi_value argv[1];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int dump_result = -1;
+	if (argc == 1)
+	{
+		char path_name[1024];
+		size_t path_name_size = 0;
+
+		if (napi_get_value_string_utf8(env, argv[0], path_name, sizeof(path_name), &path_name_size) != napi_ok)
+			return failed_ret;
+
+		dump_result = dump_flight_recorder(std::string(path_name, path_name_size));
+		log_info << "APP: DumpFlightRecorder result " << dump_result << std::endl;
+	}
+
+	if (napi_create_int32(env, dump_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value SetFlightRecorderCrashDump(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 1;
+	napi_value argv[1];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int set_result = -1;
+	if (argc == 1)
+	{
+		char path_name[1024];
+		size_t path_name_size = 0;
+
+		if (napi_get_value_string_utf8(env, argv[0], path_name, sizeof(path_name), &path_name_size) != napi_ok)
+			return failed_ret;
+
+		set_result = set_flight_recorder_crash_dump(std::string(path_name, path_name_size));
+		log_info << "APP: SetFlightRecorderCrashDump result " << set_result << std::endl;
+	}
+
+	if (napi_create_int32(env, set_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value AttachSharedFrames(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 4;
+	napi_value argv[4];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int attach_result = -1;
+	if (argc == 4)
+	{
+		int overlay_id = -1;
+		char ring_name[256];
+		size_t ring_name_size = 0;
+		int max_width = 0;
+		int max_height = 0;
+
+		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_string_utf8(env, argv[1], ring_name, sizeof(ring_name), &ring_name_size) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_int32(env, argv[2], &max_width) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_int32(env, argv[3], &max_height) != napi_ok)
+			return failed_ret;
+
+		const std::string name(ring_name, ring_name_size);
+		log_info << "APP: AttachSharedFrames " << overlay_id << ", " << name << ", " << max_width << "x" << max_height << std::endl;
+		attach_result = attach_overlay_shared_frames(overlay_id, name, max_width, max_height);
+	}
+
+	if (napi_create_int32(env, attach_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value DetachSharedFrames(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 1;
+	napi_value argv[1];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int detach_result = -1;
+	if (argc == 1)
+	{
+		int overlay_id = -1;
+
+		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+			return failed_ret;
+
+		log_info << "APP: DetachSharedFrames " << overlay_id << std::endl;
+		detach_result = detach_overlay_shared_frames(overlay_id);
+	}
+
+	if (napi_create_int32(env, detach_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value SetOverlayFrameRateLimit(napi_env env, napi_callback_info args)
+{
+	napi_value ret = nullptr;
+
+	size_t argc = 2;
+	napi_value argv[2];
+
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	int set_frame_rate_result = -1;
+	if (argc == 2)
+	{
+		int overlay_id = -1;
+		int fps = 0;
+
+		if (napi_get_value_int32(env, argv[0], &overlay_id) != napi_ok)
+			return failed_ret;
+
+		if (napi_get_value_int32(env, argv[1], &fps) != napi_ok)
+			return failed_ret;
+
+		log_info << "APP: SetOverlayFrameRateLimit " << overlay_id << ", " << fps << std::endl;
+		set_frame_rate_result = set_overlay_frame_rate_limit(overlay_id, fps);
+	}
+
+	if (napi_create_int32(env, set_frame_rate_result, &ret) != napi_ok)
+		return failed_ret;
+
+	return ret;
+}
+
+napi_value SetFrameEventsCallback(napi_env env, napi_callback_info args)
+{
+	log_info << "APP: SetFrameEventsCallback " << std::endl;
+
+	size_t argc = 1;
+	napi_value argv[1];
+	if (napi_get_cb_info(env, args, &argc, argv, NULL, NULL) != napi_ok)
+		return failed_ret;
+
+	if (argc == 1)
+	{
+		if (set_frame_events_callback(env, argv[0]) != napi_ok)
+			return failed_ret;
+	} else
+	{
+		clear_frame_events_callback();
+	}
+
+	return nullptr;
+}
+
 napi_value init(napi_env env, napi_value exports)
 {
 	napi_value fn;
 
+	if (init_painted_buffers(env) != napi_ok)
+		return failed_ret;
+
 	if (napi_create_function(env, nullptr, 0, Start, nullptr, &fn) != napi_ok)
 		return failed_ret;
 	if (napi_set_named_property(env, exports, "start", fn) != napi_ok)
@@ -564,6 +1202,21 @@ napi_value init(napi_env env, napi_value exports)
 	if (napi_set_named_property(env, exports, "stop", fn) != napi_ok)
 		return failed_ret;
 
+	if (napi_create_function(env, nullptr, 0, SetLogLevel, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setLogLevel", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, DumpFlightRecorder, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "dumpFlightRecorder", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, SetFlightRecorderCrashDump, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setFlightRecorderCrashDump", fn) != napi_ok)
+		return failed_ret;
+
 	if (napi_create_function(env, nullptr, 0, GetStatus, nullptr, &fn) != napi_ok)
 		return failed_ret;
 	if (napi_set_named_property(env, exports, "getStatus", fn) != napi_ok)
@@ -584,6 +1237,21 @@ napi_value init(napi_env env, napi_value exports)
 	if (napi_set_named_property(env, exports, "getInfo", fn) != napi_ok)
 		return failed_ret;
 
+	if (napi_create_function(env, nullptr, 0, GetFrameStats, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "getFrameStats", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, GetOverlayStats, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "getStats", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, GetAllOverlaysStats, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "getAllStats", fn) != napi_ok)
+		return failed_ret;
+
 	if (napi_create_function(env, nullptr, 0, ShowOverlays, nullptr, &fn) != napi_ok)
 		return failed_ret;
 	if (napi_set_named_property(env, exports, "show", fn) != napi_ok)
@@ -624,6 +1292,36 @@ napi_value init(napi_env env, napi_value exports)
 	if (napi_set_named_property(env, exports, "setAutohide", fn) != napi_ok)
 		return failed_ret;
 
+	if (napi_create_function(env, nullptr, 0, SetOverlayPixelFormat, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setPixelFormat", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, SetOverlayFrameFit, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setFrameFit", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, SetFrameEventsCallback, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setFrameEventsCallback", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, SetOverlayFrameRateLimit, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "setFrameRateLimit", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, AttachSharedFrames, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "attachSharedFrames", fn) != napi_ok)
+		return failed_ret;
+
+	if (napi_create_function(env, nullptr, 0, DetachSharedFrames, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "detachSharedFrames", fn) != napi_ok)
+		return failed_ret;
+
 	if (napi_create_function(env, nullptr, 0, RemoveOverlay, nullptr, &fn) != napi_ok)
 		return failed_ret;
 	if (napi_set_named_property(env, exports, "remove", fn) != napi_ok)
@@ -644,6 +1342,11 @@ napi_value init(napi_env env, napi_value exports)
 	if (napi_set_named_property(env, exports, "setMouseCallback", fn) != napi_ok)
 		return failed_ret;
 
+	if (napi_create_function(env, nullptr, 0, GetInputDroppedCount, nullptr, &fn) != napi_ok)
+		return failed_ret;
+	if (napi_set_named_property(env, exports, "getInputDroppedCount", fn) != napi_ok)
+		return failed_ret;
+
 	return exports;
 }
 
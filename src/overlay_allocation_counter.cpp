@@ -12,27 +12,39 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
-#include "overlay_paint_frame.h"
-#include "overlay_paint_frame_js.h"
-#include "overlay_logging.h"
+#include "overlay_allocation_counter.h"
 
-#include <node_api.h>
+#ifdef _DEBUG
+#include <cstdlib>
+#include <new>
 
-overlay_frame::overlay_frame(overlay_frame_js * set_data) :data( set_data)
-{
-}
+static thread_local size_t thread_allocations_count = 0;
 
-overlay_frame::~overlay_frame()
+size_t get_thread_allocations_count()
 {
-	data->clean();
-	delete data;
-	data = nullptr;
+	return thread_allocations_count;
 }
 
-void overlay_frame::get_array( void ** array_ref, size_t * array_size)
+// array and nothrow forms of new and delete forward to these
+void* operator new(size_t size)
 {
-	if(data != nullptr)
+	thread_allocations_count++;
+
+	void* ptr = std::malloc(size != 0 ? size : 1);
+	if (ptr == nullptr)
 	{
-		data->get_array(array_ref, array_size);
+		throw std::bad_alloc();
 	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
 }
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_alpha_coverage.h"
+#include "overlay_pixel_kernels.h"
+
+#include <algorithm>
+
+overlay_alpha_coverage::overlay_alpha_coverage()
+{
+	width = 0;
+	height = 0;
+	blocks_x = 0;
+	blocks_y = 0;
+	words_per_row = 0;
+}
+
+void overlay_alpha_coverage::reset(int frame_width, int frame_height)
+{
+	width = frame_width;
+	height = frame_height;
+	blocks_x = (frame_width + block_size - 1) / block_size;
+	blocks_y = (frame_height + block_size - 1) / block_size;
+	words_per_row = (blocks_x + 63) / 64;
+	bits.assign(static_cast<size_t>(words_per_row) * blocks_y, ~0ULL);
+	row_blocks.resize(blocks_x);
+}
+
+void overlay_alpha_coverage::update(const uint8_t* pixels, size_t pitch, int frame_width, int frame_height, const overlay_dirty_rects& dirty_rects)
+{
+	overlay_dirty_rects whole_frame;
+	const overlay_dirty_rects* rects = &dirty_rects;
+	if (frame_width != width || frame_height != height)
+	{
+		reset(frame_width, frame_height);
+		whole_frame.set_whole(frame_width, frame_height);
+		rects = &whole_frame;
+	}
+
+	// last block of a row can be cut by frame edge, its pixels are checked one by one
+	const int whole_blocks_x = width / block_size;
+
+	for (const overlay_pixel_rect& rect : *rects)
+	{
+		const int first_block_x = rect.left / block_size;
+		const int last_block_x = std::min(blocks_x, static_cast<int>((rect.right + block_size - 1) / block_size));
+		const int first_block_y = rect.top / block_size;
+		const int last_block_y = std::min(blocks_y, static_cast<int>((rect.bottom + block_size - 1) / block_size));
+		const int whole_last_block_x = std::min(last_block_x, whole_blocks_x);
+
+		for (int block_y = first_block_y; block_y < last_block_y; block_y++)
+		{
+			uint8_t* blocks = row_blocks.data();
+			std::fill(blocks + first_block_x, blocks + last_block_x, 0);
+
+			const int last_y = std::min(height, (block_y + 1) * block_size);
+			for (int y = block_y * block_size; y < last_y; y++)
+			{
+				const uint8_t* row = pixels + y * pitch;
+				if (whole_last_block_x > first_block_x)
+				{
+					mark_alpha_blocks(blocks + first_block_x, row + first_block_x * block_size * 4, whole_last_block_x - first_block_x);
+				}
+				for (int x = std::max(first_block_x, whole_last_block_x) * block_size; x < std::min(width, last_block_x * block_size); x++)
+				{
+					blocks[x / block_size] |= row[x * 4 + 3] != 0;
+				}
+			}
+
+			uint64_t* words = bits.data() + static_cast<size_t>(block_y) * words_per_row;
+			for (int block_x = first_block_x; block_x < last_block_x; block_x++)
+			{
+				const uint64_t bit = 1ULL << (block_x & 63);
+				if (blocks[block_x])
+				{
+					words[block_x >> 6] |= bit;
+				} else
+				{
+					words[block_x >> 6] &= ~bit;
+				}
+			}
+		}
+	}
+}
+
+bool overlay_alpha_coverage::is_covered(int x, int y) const
+{
+	if (bits.empty())
+	{
+		return true;
+	}
+	if (x < 0 || y < 0 || x >= width || y >= height)
+	{
+		return false;
+	}
+
+	const int block_x = x / block_size;
+	const int block_y = y / block_size;
+	return (bits[static_cast<size_t>(block_y) * words_per_row + (block_x >> 6)] >> (block_x & 63)) & 1;
+}
+
+void overlay_alpha_coverage::swap(overlay_alpha_coverage& other)
+{
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	std::swap(blocks_x, other.blocks_x);
+	std::swap(blocks_y, other.blocks_y);
+	std::swap(words_per_row, other.words_per_row);
+	bits.swap(other.bits);
+	row_blocks.swap(other.row_blocks);
+}
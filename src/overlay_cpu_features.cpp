@@ -0,0 +1,112 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_cpu_features.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void read_cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; i++)
+	{
+		regs[i] = static_cast<unsigned int>(info[i]);
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long read_xcr0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+static bool detect_avx2()
+{
+	unsigned int regs[4];
+	read_cpuid(0, 0, regs);
+	if (regs[0] < 7)
+	{
+		return false;
+	}
+
+	read_cpuid(1, 0, regs);
+	const bool os_saves_ymm = (regs[2] & (1u << 27)) != 0; // osxsave
+	const bool has_avx = (regs[2] & (1u << 28)) != 0;
+	if (!os_saves_ymm || !has_avx || (read_xcr0() & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	read_cpuid(7, 0, regs);
+	return (regs[1] & (1u << 5)) != 0;
+}
+
+bool cpu_has_sse2()
+{
+	// part of x86-64, windows 8 and later require it on x86 too
+	return true;
+}
+
+bool cpu_has_avx2()
+{
+	static const bool has_avx2 = detect_avx2();
+	return has_avx2;
+}
+#else
+bool cpu_has_sse2()
+{
+	return false;
+}
+
+bool cpu_has_avx2()
+{
+	return false;
+}
+#endif
+
+bool cpu_has_isa(overlay_isa isa)
+{
+	switch (isa)
+	{
+	case overlay_isa::scalar:
+		return true;
+	case overlay_isa::sse2:
+		return cpu_has_sse2();
+	case overlay_isa::avx2:
+		return cpu_has_avx2();
+	case overlay_isa::neon:
+#if defined(OVERLAY_ARCH_NEON)
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
@@ -0,0 +1,289 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_deadlines.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int count_trailing_zeros(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+overlay_deadlines::overlay_deadlines(std::shared_ptr<overlay_clock> deadlines_clock) : clock(deadlines_clock)
+{
+	current = clock->now();
+	for (int level = 0; level < levels; level++)
+	{
+		for (int slot = 0; slot < level_slots; slot++)
+		{
+			slots[level][slot] = no_timer;
+		}
+		occupied[level] = 0;
+	}
+	expired = no_timer;
+	scheduled_count = 0;
+}
+
+uint64_t overlay_deadlines::now()
+{
+	return clock->now();
+}
+
+int overlay_deadlines::find_timer(int overlay_id, overlay_deadline_kind kind) const
+{
+	auto found = overlay_blocks.find(overlay_id);
+	return found == overlay_blocks.end() ? no_timer : found->second + static_cast<int>(kind);
+}
+
+int* overlay_deadlines::get_list(const timer& entry)
+{
+	return entry.level < 0 ? &expired : &slots[entry.level][entry.slot];
+}
+
+// puts timer to the level where slot is reached before the deadline and not more than one turn of the level ahead
+void overlay_deadlines::link(int index)
+{
+	timer& entry = timers[index];
+	entry.level = -1;
+	entry.slot = 0;
+
+	if (entry.deadline.at > current)
+	{
+		const uint64_t max_delta = (1ULL << (level_bits * levels)) - 1;
+		const uint64_t delta = entry.deadline.at - current;
+		// far deadline is parked in the last level and placed again when that slot is cascaded
+		const uint64_t position = delta > max_delta ? current + max_delta : entry.deadline.at;
+
+		int level = 0;
+		while (level < levels - 1 && (delta >> (level_bits * (level + 1))) != 0)
+		{
+			level++;
+		}
+
+		entry.level = level;
+		entry.slot = static_cast<int>((position >> (level_bits * level)) & (level_slots - 1));
+		occupied[level] |= 1ULL << entry.slot;
+	}
+
+	int* list = get_list(entry);
+	entry.prev = no_timer;
+	entry.next = *list;
+	if (*list != no_timer)
+	{
+		timers[*list].prev = index;
+	}
+	*list = index;
+}
+
+void overlay_deadlines::unlink(int index)
+{
+	timer& entry = timers[index];
+	int* list = get_list(entry);
+
+	if (entry.prev != no_timer)
+	{
+		timers[entry.prev].next = entry.next;
+	} else
+	{
+		*list = entry.next;
+	}
+	if (entry.next != no_timer)
+	{
+		timers[entry.next].prev = entry.prev;
+	}
+
+	if (entry.level >= 0 && *list == no_timer)
+	{
+		occupied[entry.level] &= ~(1ULL << entry.slot);
+	}
+}
+
+// moves timers of a slot to lower levels or to expired list
+void overlay_deadlines::cascade(int level, int slot)
+{
+	int index = slots[level][slot];
+	slots[level][slot] = no_timer;
+	occupied[level] &= ~(1ULL << slot);
+
+	while (index != no_timer)
+	{
+		const int next = timers[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+// nearest tick after current when some not empty slot is reached. slot of level is reached
+// when lower bits of time turn to zero and level bits are equal to slot index
+uint64_t overlay_deadlines::get_next_tick()
+{
+	uint64_t next_tick = ~0ULL;
+	for (int level = 0; level < levels; level++)
+	{
+		if (occupied[level] == 0)
+		{
+			continue;
+		}
+
+		const int shift = level_bits * level;
+		const uint64_t base = current >> shift;
+		const int rotate = static_cast<int>((base + 1) & (level_slots - 1));
+		const uint64_t rotated = rotate == 0 ? occupied[level] : (occupied[level] >> rotate) | (occupied[level] << (level_slots - rotate));
+		const uint64_t tick = (base + 1 + count_trailing_zeros(rotated)) << shift;
+		if (tick < next_tick)
+		{
+			next_tick = tick;
+		}
+	}
+	return next_tick;
+}
+
+// jumps over empty slots, so cost depends on number of timers and not on time passed
+void overlay_deadlines::advance(uint64_t now)
+{
+	while (current < now)
+	{
+		const uint64_t tick = get_next_tick();
+		if (tick > now)
+		{
+			current = now;
+			break;
+		}
+
+		current = tick;
+		// higher levels first, their timers can fall into lower level slots reached at the same tick
+		for (int level = levels - 1; level > 0; level--)
+		{
+			const int shift = level_bits * level;
+			if ((current & ((1ULL << shift) - 1)) == 0)
+			{
+				cascade(level, static_cast<int>((current >> shift) & (level_slots - 1)));
+			}
+		}
+		cascade(0, static_cast<int>(current & (level_slots - 1)));
+	}
+}
+
+void overlay_deadlines::schedule(int overlay_id, overlay_deadline_kind kind, uint64_t at)
+{
+	advance(clock->now());
+
+	int index = find_timer(overlay_id, kind);
+	if (index == no_timer)
+	{
+		int block = 0;
+		if (!free_blocks.empty())
+		{
+			block = free_blocks.back();
+			free_blocks.pop_back();
+		} else
+		{
+			block = static_cast<int>(timers.size());
+			timers.resize(timers.size() + kinds);
+		}
+		for (int i = 0; i < kinds; i++)
+		{
+			timers[block + i].scheduled = false;
+		}
+		overlay_blocks.emplace(overlay_id, block);
+		index = block + static_cast<int>(kind);
+	}
+
+	timer& entry = timers[index];
+	if (entry.scheduled)
+	{
+		unlink(index);
+	} else
+	{
+		entry.scheduled = true;
+		scheduled_count++;
+	}
+
+	entry.deadline = overlay_deadline {at, overlay_id, kind};
+	link(index);
+}
+
+bool overlay_deadlines::is_scheduled(int overlay_id, overlay_deadline_kind kind)
+{
+	const int index = find_timer(overlay_id, kind);
+	return index != no_timer && timers[index].scheduled;
+}
+
+void overlay_deadlines::cancel(int overlay_id)
+{
+	auto found = overlay_blocks.find(overlay_id);
+	if (found == overlay_blocks.end())
+	{
+		return;
+	}
+
+	const int block = found->second;
+	for (int i = 0; i < kinds; i++)
+	{
+		if (timers[block + i].scheduled)
+		{
+			unlink(block + i);
+			timers[block + i].scheduled = false;
+			scheduled_count--;
+		}
+	}
+	free_blocks.push_back(block);
+	overlay_blocks.erase(found);
+}
+
+uint32_t overlay_deadlines::get_timeout()
+{
+	const uint64_t now = clock->now();
+	advance(now);
+
+	if (expired != no_timer)
+	{
+		return 0;
+	}
+	if (scheduled_count == 0)
+	{
+		return no_timeout;
+	}
+
+	const uint64_t next_tick = get_next_tick();
+	return static_cast<uint32_t>(next_tick - now < no_timeout ? next_tick - now : no_timeout - 1);
+}
+
+bool overlay_deadlines::pop_expired(overlay_deadline& expired_deadline)
+{
+	if (expired == no_timer)
+	{
+		advance(clock->now());
+		if (expired == no_timer)
+		{
+			return false;
+		}
+	}
+
+	const int index = expired;
+	unlink(index);
+	timers[index].scheduled = false;
+	scheduled_count--;
+	expired_deadline = timers[index].deadline;
+	return true;
+}
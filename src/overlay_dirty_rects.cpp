@@ -0,0 +1,73 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_dirty_rects.h"
+
+void overlay_dirty_rects::add(const overlay_pixel_rect& rect)
+{
+	if (rect.is_empty())
+	{
+		return;
+	}
+
+	if (count < max_dirty_rects)
+	{
+		rects[count] = rect;
+		count++;
+	} else
+	{
+		overlay_pixel_rect bounds = rect;
+		for (size_t i = 0; i < count; i++)
+		{
+			bounds = union_pixel_rects(bounds, rects[i]);
+		}
+		rects[0] = bounds;
+		count = 1;
+	}
+}
+
+void overlay_dirty_rects::add(const overlay_dirty_rects& other)
+{
+	for (const overlay_pixel_rect& rect : other)
+	{
+		add(rect);
+	}
+}
+
+void overlay_dirty_rects::set_whole(int width, int height)
+{
+	rects[0] = {0, 0, width, height};
+	count = 1;
+}
+
+void overlay_dirty_rects::clip(int width, int height)
+{
+	const overlay_pixel_rect frame_rect = {0, 0, width, height};
+	size_t visible_count = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (intersect_pixel_rects(rects[visible_count], rects[i], frame_rect))
+		{
+			visible_count++;
+		}
+	}
+
+	count = visible_count;
+}
+
+void overlay_dirty_rects::clear()
+{
+	count = 0;
+}
@@ -0,0 +1,264 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_flight_recorder.h"
+#include <atomic>
+#include <stdio.h>
+#include "overlay_clock.h"
+
+#ifdef _WIN32
+#include <filesystem>
+#include <windows.h>
+typedef HANDLE flight_dump_file;
+#else
+#include <fcntl.h>
+#include <unistd.h>
+typedef int flight_dump_file;
+#endif
+
+struct overlay_flight_record
+{
+	std::atomic<uint64_t> sequence; // index + 1 of record, 0 while it is written
+	uint64_t time;                  // overlay_tick_clock ms, records are ordered by sequence
+	uint32_t thread_id;
+	uint16_t event;
+	uint16_t reserved;
+	int32_t overlay_id;
+	int32_t a;
+	int32_t b;
+};
+
+static const size_t flight_records_count = 4096;
+static overlay_flight_record flight_records[flight_records_count];
+static std::atomic<uint64_t> flight_records_written(0);
+
+#ifdef _WIN32
+// crash dump path is prepared before crash, filter must not allocate
+static wchar_t crash_dump_path[MAX_PATH] = {0};
+static LPTOP_LEVEL_EXCEPTION_FILTER previous_exception_filter = nullptr;
+static bool exception_filter_set = false;
+#endif
+
+const char* get_flight_event_name(overlay_flight_event event)
+{
+	switch (event)
+	{
+	case overlay_flight_event::command:
+		return "command";
+	case overlay_flight_event::frame_applied:
+		return "frame_applied";
+	case overlay_flight_event::frame_dropped:
+		return "frame_dropped";
+	case overlay_flight_event::hook_event:
+		return "hook_event";
+	case overlay_flight_event::window_created:
+		return "window_created";
+	case overlay_flight_event::window_destroyed:
+		return "window_destroyed";
+	case overlay_flight_event::thread_started:
+		return "thread_started";
+	case overlay_flight_event::thread_stopped:
+		return "thread_stopped";
+	case overlay_flight_event::input_switched:
+		return "input_switched";
+	case overlay_flight_event::crashed:
+		return "crashed";
+	default:
+		return "unknown";
+	}
+}
+
+static uint32_t get_thread_id()
+{
+#ifdef _WIN32
+	return GetCurrentThreadId();
+#else
+	// numbered in order threads record their first event
+	static std::atomic<uint32_t> threads_count(0);
+	thread_local const uint32_t thread_id = threads_count.fetch_add(1, std::memory_order_relaxed) + 1;
+	return thread_id;
+#endif
+}
+
+void record_flight_event(overlay_flight_event event, int overlay_id, int a, int b)
+{
+	const uint64_t index = flight_records_written.fetch_add(1, std::memory_order_relaxed);
+	overlay_flight_record& record = flight_records[index % flight_records_count];
+
+	record.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	record.time = overlay_tick_clock::ticks();
+	record.thread_id = get_thread_id();
+	record.event = static_cast<uint16_t>(event);
+	record.overlay_id = overlay_id;
+	record.a = a;
+	record.b = b;
+	record.sequence.store(index + 1, std::memory_order_release);
+}
+
+static bool write_to_file(flight_dump_file file, const char* data, int length)
+{
+#ifdef _WIN32
+	DWORD written = 0;
+	return WriteFile(file, data, static_cast<DWORD>(length), &written, nullptr) && written == static_cast<DWORD>(length);
+#else
+	return write(file, data, static_cast<size_t>(length)) == static_cast<ssize_t>(length);
+#endif
+}
+
+// no allocations, also used from exception filter
+static bool write_flight_records(flight_dump_file file)
+{
+	char line[160];
+	const uint64_t end = flight_records_written.load(std::memory_order_acquire);
+	const uint64_t begin = end > flight_records_count ? end - flight_records_count : 0;
+
+	int length = snprintf(line, sizeof(line), "flight recorder, %llu records, last %llu kept\r\n", static_cast<unsigned long long>(end), static_cast<unsigned long long>(end - begin));
+	if (!write_to_file(file, line, length))
+	{
+		return false;
+	}
+
+	for (uint64_t index = begin; index < end; index++)
+	{
+		const overlay_flight_record& record = flight_records[index % flight_records_count];
+		if (record.sequence.load(std::memory_order_acquire) != index + 1)
+		{
+			// being written or already replaced by a newer one
+			continue;
+		}
+
+		const uint64_t time = record.time;
+		const uint32_t thread_id = record.thread_id;
+		const uint16_t event = record.event;
+		const int32_t overlay_id = record.overlay_id;
+		const int32_t a = record.a;
+		const int32_t b = record.b;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (record.sequence.load(std::memory_order_relaxed) != index + 1)
+		{
+			continue;
+		}
+
+		length = snprintf(line, sizeof(line), "%llu %llu.%03llu thread %lu %s overlay %d %d %d\r\n", static_cast<unsigned long long>(index),
+		    static_cast<unsigned long long>(time / 1000), static_cast<unsigned long long>(time % 1000), static_cast<unsigned long>(thread_id),
+		    get_flight_event_name(static_cast<overlay_flight_event>(event)), overlay_id, a, b);
+		if (length > 0 && !write_to_file(file, line, length))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+#ifdef _WIN32
+static bool write_flight_records_to(const wchar_t* path)
+{
+	HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	const bool written = write_flight_records(file);
+	CloseHandle(file);
+	return written;
+}
+
+int dump_flight_recorder(const std::string& path)
+{
+	const std::wstring wide_path = std::filesystem::u8path(path).wstring();
+	return write_flight_records_to(wide_path.c_str()) ? 0 : -1;
+}
+
+static LONG WINAPI flight_recorder_exception_filter(EXCEPTION_POINTERS* exception)
+{
+	if (crash_dump_path[0] != 0)
+	{
+		record_flight_event(overlay_flight_event::crashed, 0, static_cast<int>(exception->ExceptionRecord->ExceptionCode), 0);
+		write_flight_records_to(crash_dump_path);
+	}
+
+	if (previous_exception_filter != nullptr)
+	{
+		return previous_exception_filter(exception);
+	}
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+// filter set after ours by someone else stays in place, ours only stops writing and passes exceptions on
+static void remove_exception_filter()
+{
+	crash_dump_path[0] = 0;
+	if (!exception_filter_set)
+	{
+		return;
+	}
+
+	const LPTOP_LEVEL_EXCEPTION_FILTER current = SetUnhandledExceptionFilter(previous_exception_filter);
+	if (current == flight_recorder_exception_filter)
+	{
+		exception_filter_set = false;
+		previous_exception_filter = nullptr;
+	} else
+	{
+		SetUnhandledExceptionFilter(current);
+	}
+}
+
+int set_flight_recorder_crash_dump(const std::string& path)
+{
+	if (path.empty())
+	{
+		remove_exception_filter();
+		return 0;
+	}
+
+	const std::wstring wide_path = std::filesystem::u8path(path).wstring();
+	if (wide_path.size() >= MAX_PATH)
+	{
+		remove_exception_filter();
+		return -1;
+	}
+
+	wide_path.copy(crash_dump_path, wide_path.size());
+	crash_dump_path[wide_path.size()] = 0;
+
+	if (!exception_filter_set)
+	{
+		exception_filter_set = true;
+		previous_exception_filter = SetUnhandledExceptionFilter(flight_recorder_exception_filter);
+	}
+	return 0;
+}
+#else
+int dump_flight_recorder(const std::string& path)
+{
+	const int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+	{
+		return -1;
+	}
+
+	const bool written = write_flight_records(file);
+	close(file);
+	return written ? 0 : -1;
+}
+
+// unhandled exception filter is windows only
+int set_flight_recorder_crash_dump(const std::string& path)
+{
+	return path.empty() ? 0 : -1;
+}
+#endif
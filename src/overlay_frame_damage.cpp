@@ -0,0 +1,222 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_damage.h"
+#include "overlay_cpu_features.h"
+
+#include <string.h>
+
+#if defined(OVERLAY_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+typedef bool (*spans_equal_fn)(const uint8_t* a, const uint8_t* b, size_t size);
+
+static bool spans_equal_scalar(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	return memcmp(a, b, size) == 0;
+}
+
+#if defined(OVERLAY_ARCH_X86)
+static bool spans_equal_sse2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64)
+	{
+		const __m128i* pa = reinterpret_cast<const __m128i*>(a + i);
+		const __m128i* pb = reinterpret_cast<const __m128i*>(b + i);
+		__m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(pa), _mm_loadu_si128(pb));
+		equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128(pa + 1), _mm_loadu_si128(pb + 1)));
+		equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128(pa + 2), _mm_loadu_si128(pb + 2)));
+		equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128(pa + 3), _mm_loadu_si128(pb + 3)));
+		if (_mm_movemask_epi8(equal) != 0xFFFF)
+		{
+			return false;
+		}
+	}
+
+	return memcmp(a + i, b + i, size - i) == 0;
+}
+
+OVERLAY_TARGET_AVX2 static bool spans_equal_avx2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64)
+	{
+		const __m256i* pa = reinterpret_cast<const __m256i*>(a + i);
+		const __m256i* pb = reinterpret_cast<const __m256i*>(b + i);
+		__m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256(pa), _mm256_loadu_si256(pb));
+		equal = _mm256_and_si256(equal, _mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 1), _mm256_loadu_si256(pb + 1)));
+		if (_mm256_movemask_epi8(equal) != -1)
+		{
+			return false;
+		}
+	}
+
+	return memcmp(a + i, b + i, size - i) == 0;
+}
+#endif
+
+static spans_equal_fn select_spans_equal()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_avx2())
+	{
+		return spans_equal_avx2;
+	}
+	if (cpu_has_sse2())
+	{
+		return spans_equal_sse2;
+	}
+#endif
+	return spans_equal_scalar;
+}
+
+overlay_frame_damage::overlay_frame_damage()
+{
+	width = 0;
+	height = 0;
+}
+
+void overlay_frame_damage::resize(int new_width, int new_height)
+{
+	width = new_width;
+	height = new_height;
+	previous.assign(static_cast<size_t>(width) * height * 4, 0);
+	tile_changed.assign((width + tile_size - 1) / tile_size, 0);
+}
+
+void overlay_frame_damage::copy_frame(const uint8_t* frame, size_t frame_pitch)
+{
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	for (int y = 0; y < height; y++)
+	{
+		memcpy(previous.data() + y * pitch, frame + y * frame_pitch, pitch);
+	}
+}
+
+// tiles are found band by band, so a run of tiles continuing a rect from the band above extends it.
+// it keeps damage of a moving or growing area in few rects
+void overlay_frame_damage::add_damage(overlay_dirty_rects& damage, const overlay_pixel_rect& rect)
+{
+	for (size_t i = 0; i < damage.count; i++)
+	{
+		overlay_pixel_rect& existing = damage.rects[i];
+		if (existing.left == rect.left && existing.right == rect.right && existing.bottom == rect.top)
+		{
+			existing.bottom = rect.bottom;
+			return;
+		}
+	}
+
+	damage.add(rect);
+}
+
+void overlay_frame_damage::find_damage(const uint8_t* frame, size_t frame_pitch, int frame_width, int frame_height, overlay_dirty_rects& damage)
+{
+	static const spans_equal_fn spans_equal = select_spans_equal();
+
+	if (frame_width != width || frame_height != height || previous.empty())
+	{
+		resize(frame_width, frame_height);
+		copy_frame(frame, frame_pitch);
+		damage.add(overlay_pixel_rect {0, 0, width, height});
+		return;
+	}
+
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	const int tiles_x = static_cast<int>(tile_changed.size());
+
+	for (int band_top = 0; band_top < height; band_top += tile_size)
+	{
+		const int band_bottom = band_top + tile_size < height ? band_top + tile_size : height;
+		memset(tile_changed.data(), 0, tile_changed.size());
+
+		// go row by row to read memory in order, tile already known as changed is not compared again
+		for (int y = band_top; y < band_bottom; y++)
+		{
+			const uint8_t* new_row = frame + y * frame_pitch;
+			const uint8_t* old_row = previous.data() + y * pitch;
+			for (int tx = 0; tx < tiles_x; tx++)
+			{
+				if (tile_changed[tx])
+				{
+					continue;
+				}
+
+				const size_t offset = static_cast<size_t>(tx) * tile_size * 4;
+				const size_t span = offset + tile_size * 4 <= pitch ? tile_size * 4 : pitch - offset;
+				if (!spans_equal(new_row + offset, old_row + offset, span))
+				{
+					tile_changed[tx] = 1;
+				}
+			}
+		}
+
+		// runs of changed tiles become rects
+		for (int tx = 0; tx < tiles_x;)
+		{
+			if (!tile_changed[tx])
+			{
+				tx++;
+				continue;
+			}
+
+			const int run_start = tx;
+			while (tx < tiles_x && tile_changed[tx])
+			{
+				tx++;
+			}
+
+			const int left = run_start * tile_size;
+			const int right = tx * tile_size < width ? tx * tile_size : width;
+			const size_t row_offset = static_cast<size_t>(left) * 4;
+			const size_t row_size = static_cast<size_t>(right - left) * 4;
+			for (int y = band_top; y < band_bottom; y++)
+			{
+				memcpy(previous.data() + y * pitch + row_offset, frame + y * frame_pitch + row_offset, row_size);
+			}
+
+			add_damage(damage, overlay_pixel_rect {left, band_top, right, band_bottom});
+		}
+	}
+}
+
+void overlay_frame_damage::update(const uint8_t* frame, size_t frame_pitch, int frame_width, int frame_height, const overlay_dirty_rects& dirty_rects)
+{
+	if (frame_width != width || frame_height != height || previous.empty())
+	{
+		resize(frame_width, frame_height);
+		copy_frame(frame, frame_pitch);
+		return;
+	}
+
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	for (const overlay_pixel_rect& rect : dirty_rects)
+	{
+		const size_t row_offset = static_cast<size_t>(rect.left) * 4;
+		const size_t row_size = static_cast<size_t>(rect.right - rect.left) * 4;
+		for (int y = rect.top; y < rect.bottom; y++)
+		{
+			memcpy(previous.data() + y * pitch + row_offset, frame + y * frame_pitch + row_offset, row_size);
+		}
+	}
+}
+
+void overlay_frame_damage::reset()
+{
+	std::vector<uint8_t>().swap(previous);
+	width = 0;
+	height = 0;
+}
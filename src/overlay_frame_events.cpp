@@ -0,0 +1,127 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_events.h"
+
+#include <mutex>
+#include "overlay_logging.h"
+
+struct frame_event_data
+{
+	int overlay_id;
+	overlay_frame_event event;
+	int fps;
+};
+
+static std::mutex frame_events_access;
+static napi_threadsafe_function frame_events_function = nullptr;
+
+const char* get_frame_event_name(overlay_frame_event event)
+{
+	switch (event)
+	{
+	case overlay_frame_event::pause:
+		return "pause";
+	case overlay_frame_event::slow_down:
+		return "slowDown";
+	default:
+		return "resume";
+	}
+}
+
+// env is null when threadsafe function is released with events still in queue
+static void call_frame_events_callback(napi_env env, napi_value js_callback, void* context, void* data)
+{
+	frame_event_data* event_data = static_cast<frame_event_data*>(data);
+
+	if (env != nullptr && js_callback != nullptr)
+	{
+		napi_value argv[3];
+		napi_value global;
+		napi_value result;
+		const char* event_name = get_frame_event_name(event_data->event);
+
+		if (napi_create_int32(env, event_data->overlay_id, &argv[0]) == napi_ok &&
+		    napi_create_string_utf8(env, event_name, NAPI_AUTO_LENGTH, &argv[1]) == napi_ok &&
+		    napi_create_int32(env, event_data->fps, &argv[2]) == napi_ok && napi_get_global(env, &global) == napi_ok)
+		{
+			napi_call_function(env, global, js_callback, 3, argv, &result);
+		}
+	}
+
+	delete event_data;
+}
+
+napi_status set_frame_events_callback(napi_env env, napi_value callback)
+{
+	clear_frame_events_callback();
+
+	napi_valuetype callback_type = napi_undefined;
+	napi_status status = napi_typeof(env, callback, &callback_type);
+	if (status != napi_ok || callback_type != napi_function)
+	{
+		return status;
+	}
+
+	napi_value resource_name;
+	status = napi_create_string_utf8(env, "func_frame_events", NAPI_AUTO_LENGTH, &resource_name);
+	if (status != napi_ok)
+	{
+		return status;
+	}
+
+	napi_threadsafe_function created = nullptr;
+	status = napi_create_threadsafe_function(env, callback, nullptr, resource_name, 64, 1, nullptr, nullptr, nullptr, call_frame_events_callback, &created);
+	if (status != napi_ok)
+	{
+		log_error << "APP: set_frame_events_callback failed to create threadsafe function " << status << std::endl;
+		return status;
+	}
+
+	// callback alone should not keep node event loop alive
+	napi_unref_threadsafe_function(env, created);
+
+	std::lock_guard<std::mutex> lock(frame_events_access);
+	frame_events_function = created;
+	return napi_ok;
+}
+
+void clear_frame_events_callback()
+{
+	std::lock_guard<std::mutex> lock(frame_events_access);
+	if (frame_events_function != nullptr)
+	{
+		napi_release_threadsafe_function(frame_events_function, napi_tsfn_release);
+		frame_events_function = nullptr;
+	}
+}
+
+bool send_frame_event(int overlay_id, overlay_frame_event event, int fps)
+{
+	std::lock_guard<std::mutex> lock(frame_events_access);
+	if (frame_events_function == nullptr)
+	{
+		return false;
+	}
+
+	frame_event_data* event_data = new frame_event_data {overlay_id, event, fps};
+	if (napi_call_threadsafe_function(frame_events_function, event_data, napi_tsfn_nonblocking) != napi_ok)
+	{
+		log_debug << "APP: frame event " << get_frame_event_name(event) << " for overlay " << overlay_id << " dropped" << std::endl;
+		delete event_data;
+		return false;
+	}
+
+	return true;
+}
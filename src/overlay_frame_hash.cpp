@@ -0,0 +1,255 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_hash.h"
+#include "overlay_cpu_features.h"
+
+#include <string.h>
+
+#if defined(OVERLAY_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+// Input is read in 64 byte stripes, each of 8 lanes accumulates
+// lo32 * hi32 of (data ^ key) plus the neighbour lane data.
+// Key changes with every stripe so moved blocks of pixels change the hash.
+
+const size_t stripe_size = 64;
+const size_t stripe_lanes = 8;
+
+const uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+const uint64_t key_step = 0x9E3779B97F4A7C15ULL;
+
+const uint64_t base_keys[stripe_lanes] = {
+    0xBE4BA423396CFEB8ULL,
+    0x1CAD21F72C81017CULL,
+    0xDB979083E96DD4DEULL,
+    0x1F67B3B7A4A44072ULL,
+    0x78E5C0CC4EE679CBULL,
+    0x2172FFCC7DD05A82ULL,
+    0x8E2443F7744608B8ULL,
+    0x4C263A81E69035E0ULL,
+};
+
+struct hash_state
+{
+	uint64_t acc[stripe_lanes];
+	uint64_t keys[stripe_lanes];
+};
+
+typedef void (*hash_stripes_fn)(hash_state& state, const uint8_t* data, size_t stripes);
+
+static inline uint64_t read64(const uint8_t* p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t mix64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= prime64_2;
+	h ^= h >> 29;
+	h *= prime64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static void hash_stripes_scalar(hash_state& state, const uint8_t* data, size_t stripes)
+{
+	for (size_t s = 0; s < stripes; s++, data += stripe_size)
+	{
+		for (size_t i = 0; i < stripe_lanes; i++)
+		{
+			const uint64_t value = read64(data + i * 8);
+			const uint64_t keyed = value ^ state.keys[i];
+			state.acc[i] += read64(data + (i ^ 1) * 8);
+			state.acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+			state.keys[i] += key_step;
+		}
+	}
+}
+
+#if defined(OVERLAY_ARCH_X86)
+static void hash_stripes_sse2(hash_state& state, const uint8_t* data, size_t stripes)
+{
+	__m128i acc[4];
+	__m128i keys[4];
+	const __m128i step = _mm_set1_epi64x(static_cast<long long>(key_step));
+
+	for (int i = 0; i < 4; i++)
+	{
+		acc[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.acc) + i);
+		keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.keys) + i);
+	}
+
+	for (size_t s = 0; s < stripes; s++, data += stripe_size)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+			const __m128i keyed = _mm_xor_si128(value, keys[i]);
+			const __m128i keyed_hi = _mm_shuffle_epi32(keyed, _MM_SHUFFLE(3, 3, 1, 1));
+			const __m128i product = _mm_mul_epu32(keyed, keyed_hi);
+			const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+			acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(swapped, product));
+			keys[i] = _mm_add_epi64(keys[i], step);
+		}
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state.acc) + i, acc[i]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state.keys) + i, keys[i]);
+	}
+}
+
+OVERLAY_TARGET_AVX2 static void hash_stripes_avx2(hash_state& state, const uint8_t* data, size_t stripes)
+{
+	__m256i acc[2];
+	__m256i keys[2];
+	const __m256i step = _mm256_set1_epi64x(static_cast<long long>(key_step));
+
+	for (int i = 0; i < 2; i++)
+	{
+		acc[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state.acc) + i);
+		keys[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state.keys) + i);
+	}
+
+	for (size_t s = 0; s < stripes; s++, data += stripe_size)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+			const __m256i keyed = _mm256_xor_si256(value, keys[i]);
+			const __m256i keyed_hi = _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(3, 3, 1, 1));
+			const __m256i product = _mm256_mul_epu32(keyed, keyed_hi);
+			const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+			acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(swapped, product));
+			keys[i] = _mm256_add_epi64(keys[i], step);
+		}
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(state.acc) + i, acc[i]);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(state.keys) + i, keys[i]);
+	}
+}
+#endif
+
+static hash_stripes_fn get_hash_stripes(overlay_isa isa)
+{
+	if (!cpu_has_isa(isa))
+	{
+		return nullptr;
+	}
+
+	switch (isa)
+	{
+	case overlay_isa::scalar:
+		return hash_stripes_scalar;
+#if defined(OVERLAY_ARCH_X86)
+	case overlay_isa::sse2:
+		return hash_stripes_sse2;
+	case overlay_isa::avx2:
+		return hash_stripes_avx2;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+static hash_stripes_fn select_hash_stripes()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_avx2())
+	{
+		return hash_stripes_avx2;
+	}
+	if (cpu_has_sse2())
+	{
+		return hash_stripes_sse2;
+	}
+#endif
+	return hash_stripes_scalar;
+}
+
+static uint64_t hash_pixels(hash_stripes_fn hash_stripes, const void* data, size_t size, uint64_t seed)
+{
+	hash_state state;
+	for (size_t i = 0; i < stripe_lanes; i++)
+	{
+		state.acc[i] = seed + base_keys[i] * prime64_1;
+		state.keys[i] = base_keys[i];
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	const size_t stripes = size / stripe_size;
+	hash_stripes(state, bytes, stripes);
+
+	const size_t tail_size = size - stripes * stripe_size;
+	if (tail_size != 0)
+	{
+		uint8_t tail[stripe_size] = {0};
+		memcpy(tail, bytes + stripes * stripe_size, tail_size);
+		hash_stripes_scalar(state, tail, 1);
+	}
+
+	uint64_t hash = seed ^ (static_cast<uint64_t>(size) * prime64_1);
+	for (size_t i = 0; i < stripe_lanes; i++)
+	{
+		hash = (hash ^ mix64(state.acc[i])) * prime64_1 + prime64_3;
+	}
+
+	return mix64(hash);
+}
+
+uint64_t hash_frame_pixels(const void* data, size_t size, uint64_t seed)
+{
+	static const hash_stripes_fn hash_stripes = select_hash_stripes();
+
+	return hash_pixels(hash_stripes, data, size, seed);
+}
+
+bool hash_frame_pixels_for_isa(overlay_isa isa, const void* data, size_t size, uint64_t seed, uint64_t& hash)
+{
+	const hash_stripes_fn hash_stripes = get_hash_stripes(isa);
+	if (hash_stripes == nullptr)
+	{
+		return false;
+	}
+
+	hash = hash_pixels(hash_stripes, data, size, seed);
+	return true;
+}
+
+uint64_t hash_frame_rows(const void* data, size_t row_size, size_t pitch, int rows, uint64_t seed)
+{
+	if (pitch == row_size)
+	{
+		return hash_frame_pixels(data, row_size * rows, seed);
+	}
+
+	const uint8_t* row = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (int y = 0; y < rows; y++, row += pitch)
+	{
+		hash = hash_frame_pixels(row, row_size, hash);
+	}
+	return hash;
+}
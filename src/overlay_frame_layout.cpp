@@ -0,0 +1,53 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_layout.h"
+
+#include <stdint.h>
+
+bool is_frame_in_buffer(size_t buffer_size, int width, int height, size_t& stride, size_t offset)
+{
+	if (width <= 0 || height <= 0 || static_cast<size_t>(width) > SIZE_MAX / 4)
+	{
+		return false;
+	}
+
+	const size_t row_size = static_cast<size_t>(width) * 4;
+	const bool explicit_layout = stride != 0 || offset != 0;
+	if (stride == 0)
+	{
+		stride = row_size;
+	}
+
+	if (stride < row_size)
+	{
+		return false;
+	}
+
+	// offset + stride * (height - 1) + row_size, any step of it can wrap around
+	const size_t last_row = static_cast<size_t>(height) - 1;
+	if (last_row != 0 && stride > (SIZE_MAX - row_size) / last_row)
+	{
+		return false;
+	}
+
+	const size_t frame_size = stride * last_row + row_size;
+	if (offset > SIZE_MAX - frame_size)
+	{
+		return false;
+	}
+
+	const size_t frame_end = offset + frame_size;
+	return explicit_layout ? frame_end <= buffer_size : frame_end == buffer_size;
+}
@@ -0,0 +1,109 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_mailbox.h"
+
+// grow buffer to fit the frame, give memory back if overlay became much smaller
+static bool fit_frame_buffer(std::vector<uint8_t>& pixels, size_t frame_size)
+{
+	if (frame_size > pixels.capacity() || frame_size < pixels.capacity() / 2)
+	{
+		std::vector<uint8_t> resized(frame_size);
+		pixels.swap(resized);
+		return true;
+	}
+
+	pixels.resize(frame_size);
+	return false;
+}
+
+overlay_frame_mailbox::overlay_frame_mailbox()
+{
+	write_index = 0;
+	read_index = 1;
+	shared_index = 2;
+	full_frame_requested = false;
+	allocated_bytes = 0;
+	pending_width = 0;
+	pending_height = 0;
+}
+
+overlay_frame_slot& overlay_frame_mailbox::begin_write(int width, int height, const overlay_dirty_rects& dirty_rects)
+{
+	// flag is cleared by consumer when it takes a frame. it is fine to see it a bit late,
+	// we just copy a little more than needed
+	if ((shared_index.load(std::memory_order_acquire) & fresh_frame_flag) == 0)
+	{
+		pending_rects.clear();
+	}
+
+	const bool full_frame = full_frame_requested.exchange(false) || width != pending_width || height != pending_height;
+	pending_width = width;
+	pending_height = height;
+
+	if (full_frame)
+	{
+		pending_rects.set_whole(width, height);
+	} else
+	{
+		pending_rects.add(dirty_rects);
+	}
+
+	overlay_frame_slot& slot = slots[write_index];
+	slot.reallocated = fit_frame_buffer(slot.pixels, static_cast<size_t>(width) * height * 4);
+	if (slot.reallocated)
+	{
+		// only producer resizes buffers, so their capacity can be read here
+		allocated_bytes.store(slots[0].pixels.capacity() + slots[1].pixels.capacity() + slots[2].pixels.capacity(), std::memory_order_relaxed);
+	}
+	slot.width = width;
+	slot.height = height;
+	slot.dirty_rects = pending_rects;
+
+	return slot;
+}
+
+void overlay_frame_mailbox::publish()
+{
+	const int previous = shared_index.exchange(write_index | fresh_frame_flag, std::memory_order_acq_rel);
+	write_index = previous & ~fresh_frame_flag;
+}
+
+overlay_frame_slot* overlay_frame_mailbox::take()
+{
+	if ((shared_index.load(std::memory_order_relaxed) & fresh_frame_flag) == 0)
+	{
+		return nullptr;
+	}
+
+	const int previous = shared_index.exchange(read_index, std::memory_order_acq_rel);
+	read_index = previous & ~fresh_frame_flag;
+
+	return &slots[read_index];
+}
+
+void overlay_frame_mailbox::request_full_frame()
+{
+	full_frame_requested = true;
+}
+
+bool overlay_frame_mailbox::is_full_frame_requested() const
+{
+	return full_frame_requested.load();
+}
+
+size_t overlay_frame_mailbox::get_allocated_bytes() const
+{
+	return allocated_bytes.load(std::memory_order_relaxed);
+}
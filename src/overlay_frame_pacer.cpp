@@ -0,0 +1,164 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_pacer.h"
+
+overlay_frame_pacer::overlay_frame_pacer()
+{
+	interval = std::chrono::steady_clock::duration::zero();
+	dropped_whole = false;
+	has_dropped = false;
+	has_held = false;
+	accepted_count = 0;
+	dropped_count = 0;
+}
+
+void overlay_frame_pacer::set_frame_rate_limit(int fps)
+{
+	if (fps > 0)
+	{
+		interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fps));
+	} else
+	{
+		interval = std::chrono::steady_clock::duration::zero();
+	}
+	next_frame_time = std::chrono::steady_clock::time_point();
+}
+
+int overlay_frame_pacer::get_frame_rate_limit()
+{
+	if (interval == std::chrono::steady_clock::duration::zero())
+	{
+		return 0;
+	}
+	return static_cast<int>(1.0 / std::chrono::duration<double>(interval).count() + 0.5);
+}
+
+// a little early frame is still accepted, producer running at the limit rate has some jitter
+bool overlay_frame_pacer::is_early(std::chrono::steady_clock::time_point now)
+{
+	const std::chrono::steady_clock::duration slack = interval / 4;
+	return interval != std::chrono::steady_clock::duration::zero() && now + slack < next_frame_time;
+}
+
+// frames are accepted on a steady grid, after a pause grid starts again from now
+void overlay_frame_pacer::advance(std::chrono::steady_clock::time_point now)
+{
+	next_frame_time += interval;
+	if (next_frame_time <= now)
+	{
+		next_frame_time = now + interval;
+	}
+	accepted_count++;
+}
+
+bool overlay_frame_pacer::accept_frame(const overlay_dirty_rects& dirty_rects)
+{
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (is_early(now))
+	{
+		if (dirty_rects.size() == 0)
+		{
+			dropped_whole = true;
+		} else
+		{
+			dropped_rects.add(dirty_rects);
+		}
+		has_dropped = true;
+		dropped_count++;
+		return false;
+	}
+
+	// accepted frame is newer than the held one
+	has_held = false;
+	advance(now);
+	return true;
+}
+
+void overlay_frame_pacer::add_dropped_rects(overlay_dirty_rects& dirty_rects, int width, int height)
+{
+	if (!has_dropped)
+	{
+		return;
+	}
+
+	// frame without rects is taken as whole anyway
+	if (dirty_rects.size() != 0)
+	{
+		if (dropped_whole)
+		{
+			dirty_rects.set_whole(width, height);
+		} else
+		{
+			dirty_rects.add(dropped_rects);
+		}
+	}
+
+	dropped_rects.clear();
+	dropped_whole = false;
+	has_dropped = false;
+}
+
+void overlay_frame_pacer::hold_frame()
+{
+	has_held = true;
+}
+
+bool overlay_frame_pacer::has_held_frame()
+{
+	return has_held;
+}
+
+std::chrono::steady_clock::duration overlay_frame_pacer::get_held_frame_delay()
+{
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (!is_early(now))
+	{
+		return std::chrono::steady_clock::duration::zero();
+	}
+	return next_frame_time - now;
+}
+
+bool overlay_frame_pacer::take_held_frame(overlay_dirty_rects& dirty_rects)
+{
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (!has_held || is_early(now))
+	{
+		return false;
+	}
+
+	// held frame is the newest dropped one, so rects of dropped frames are all it needs
+	dirty_rects.clear();
+	if (!dropped_whole)
+	{
+		dirty_rects.add(dropped_rects);
+	}
+	dropped_rects.clear();
+	dropped_whole = false;
+	has_dropped = false;
+	has_held = false;
+
+	advance(now);
+	return true;
+}
+
+uint64_t overlay_frame_pacer::get_accepted_count()
+{
+	return accepted_count.load(std::memory_order_relaxed);
+}
+
+uint64_t overlay_frame_pacer::get_dropped_count()
+{
+	return dropped_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,140 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_hit_index.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int count_trailing_zeros(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+overlay_hit_index::overlay_hit_index()
+{
+	for (snapshot& n : snapshots)
+	{
+		n.sequence = 0;
+		n.rect_count = 0;
+		n.bounds = {0, 0, 0, 0};
+		n.cell_width = 1;
+		n.cell_height = 1;
+		std::fill(std::begin(n.cells), std::end(n.cells), 0);
+	}
+	current = 0;
+}
+
+void overlay_hit_index::publish(const std::vector<overlay_hit_rect>& rects)
+{
+	const int next = 1 - current.load(std::memory_order_relaxed);
+	snapshot& written = snapshots[next];
+
+	written.sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	written.rect_count = 0;
+	written.bounds = {0, 0, 0, 0};
+	for (const overlay_hit_rect& n : rects)
+	{
+		if (written.rect_count == max_rects)
+		{
+			break;
+		}
+		if (n.rect.is_empty())
+		{
+			continue;
+		}
+
+		written.bounds = union_pixel_rects(written.bounds, n.rect);
+		written.rects[written.rect_count++] = n;
+	}
+
+	// in 64-bit, bounds of rects far apart can be wider than int range
+	const int64_t bounds_width = static_cast<int64_t>(written.bounds.right) - written.bounds.left;
+	const int64_t bounds_height = static_cast<int64_t>(written.bounds.bottom) - written.bounds.top;
+	written.cell_width = static_cast<int>(std::max<int64_t>(1, (bounds_width + grid_size - 1) / grid_size));
+	written.cell_height = static_cast<int>(std::max<int64_t>(1, (bounds_height + grid_size - 1) / grid_size));
+	std::fill(std::begin(written.cells), std::end(written.cells), 0);
+
+	for (int i = 0; i < written.rect_count; i++)
+	{
+		const overlay_pixel_rect& rect = written.rects[i].rect;
+		const int first_column = static_cast<int>((static_cast<int64_t>(rect.left) - written.bounds.left) / written.cell_width);
+		const int last_column = std::min(grid_size - 1, static_cast<int>((static_cast<int64_t>(rect.right) - 1 - written.bounds.left) / written.cell_width));
+		const int first_row = static_cast<int>((static_cast<int64_t>(rect.top) - written.bounds.top) / written.cell_height);
+		const int last_row = std::min(grid_size - 1, static_cast<int>((static_cast<int64_t>(rect.bottom) - 1 - written.bounds.top) / written.cell_height));
+
+		for (int row = first_row; row <= last_row; row++)
+		{
+			for (int column = first_column; column <= last_column; column++)
+			{
+				written.cells[row * grid_size + column] |= 1ULL << i;
+			}
+		}
+	}
+
+	written.sequence.fetch_add(1, std::memory_order_release);
+	current.store(next, std::memory_order_release);
+}
+
+bool overlay_hit_index::hit_test(int x, int y, overlay_hit& hit) const
+{
+	while (true)
+	{
+		const snapshot& read = snapshots[current.load(std::memory_order_acquire)];
+		const uint32_t sequence = read.sequence.load(std::memory_order_acquire);
+		if (sequence & 1)
+		{
+			continue;
+		}
+
+		bool found = false;
+		if (read.rect_count != 0 && read.bounds.contains(x, y))
+		{
+			const int column = std::min(grid_size - 1, static_cast<int>((static_cast<int64_t>(x) - read.bounds.left) / read.cell_width));
+			const int row = std::min(grid_size - 1, static_cast<int>((static_cast<int64_t>(y) - read.bounds.top) / read.cell_height));
+			// lower bits are upper overlays
+			uint64_t candidates = read.cells[row * grid_size + column];
+			while (candidates != 0)
+			{
+				const int i = count_trailing_zeros(candidates);
+				candidates &= candidates - 1;
+
+				const overlay_hit_rect& n = read.rects[i];
+				if (n.rect.contains(x, y) && (n.coverage == nullptr || n.coverage->is_covered(x - n.rect.left, y - n.rect.top)))
+				{
+					hit = overlay_hit {n.overlay_id, x - n.rect.left, y - n.rect.top};
+					found = true;
+					break;
+				}
+			}
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (read.sequence.load(std::memory_order_relaxed) == sequence)
+		{
+			return found;
+		}
+	}
+}
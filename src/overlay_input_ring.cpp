@@ -0,0 +1,246 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_input_ring.h"
+
+overlay_input_ring::overlay_input_ring()
+{
+	write_count = 0;
+	read_count = 0;
+}
+
+bool overlay_input_ring::push(const overlay_input_event& event)
+{
+	const size_t written = write_count.load(std::memory_order_relaxed);
+	if (written - read_count.load(std::memory_order_acquire) == capacity)
+	{
+		return false;
+	}
+
+	events[written % capacity] = event;
+	write_count.store(written + 1, std::memory_order_release);
+	return true;
+}
+
+size_t overlay_input_ring::get_free_space() const
+{
+	return capacity - (write_count.load(std::memory_order_relaxed) - read_count.load(std::memory_order_acquire));
+}
+
+bool overlay_input_ring::peek(overlay_input_event& event) const
+{
+	const size_t read = read_count.load(std::memory_order_relaxed);
+	if (write_count.load(std::memory_order_acquire) == read)
+	{
+		return false;
+	}
+
+	event = events[read % capacity];
+	return true;
+}
+
+bool overlay_input_ring::pop(overlay_input_event& event)
+{
+	return pop_many(&event, 1) == 1;
+}
+
+size_t overlay_input_ring::pop_many(overlay_input_event* to, size_t max_count)
+{
+	const size_t read = read_count.load(std::memory_order_relaxed);
+	const size_t available = write_count.load(std::memory_order_acquire) - read;
+	const size_t count = available < max_count ? available : max_count;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		to[i] = events[(read + i) % capacity];
+	}
+
+	read_count.store(read + count, std::memory_order_release);
+	return count;
+}
+
+void overlay_input_ring::clear()
+{
+	read_count.store(write_count.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+bool is_mouse_move(const overlay_input_event& event)
+{
+	return event.type == static_cast<int32_t>(overlay_input_type::mouse_move);
+}
+
+// later move replaces position, time and overlay of earlier one
+void merge_mouse_move(overlay_input_event& to, const overlay_input_event& from)
+{
+	const int32_t count = to.count + from.count;
+	to = from;
+	to.count = count;
+}
+
+overlay_input_queue::overlay_input_queue() : spill(spill_capacity)
+{
+	spill_first = 0;
+	spill_size = 0;
+	has_pending_move = false;
+	dropped_count = 0;
+}
+
+static uint64_t get_moves_count(const overlay_input_event& event)
+{
+	return event.count > 0 ? static_cast<uint64_t>(event.count) : 1;
+}
+
+// clicks keep their own position, so moves between them can go when room is needed
+void overlay_input_queue::drop_spilled_moves()
+{
+	const size_t capacity = spill.size();
+	size_t kept = 0;
+	for (size_t i = 0; i < spill_size; i++)
+	{
+		const overlay_input_event& event = spill[(spill_first + i) % capacity];
+		if (is_mouse_move(event))
+		{
+			dropped_count.fetch_add(get_moves_count(event), std::memory_order_relaxed);
+		} else
+		{
+			spill[(spill_first + kept) % capacity] = event;
+			kept++;
+		}
+	}
+	spill_size = kept;
+}
+
+void overlay_input_queue::grow_spill()
+{
+	std::vector<overlay_input_event> grown(spill.size() * 2);
+	for (size_t i = 0; i < spill_size; i++)
+	{
+		grown[i] = spill[(spill_first + i) % spill.size()];
+	}
+	spill.swap(grown);
+	spill_first = 0;
+}
+
+// false if a move was dropped
+bool overlay_input_queue::add_to_spill(const overlay_input_event& event)
+{
+	bool dropped = false;
+	if (spill_size == spill.size())
+	{
+		if (is_mouse_move(event))
+		{
+			dropped_count.fetch_add(get_moves_count(event), std::memory_order_relaxed);
+			return false;
+		}
+
+		const size_t was_size = spill_size;
+		drop_spilled_moves();
+		dropped = spill_size != was_size;
+		if (spill_size == spill.size())
+		{
+			grow_spill();
+		}
+	}
+
+	spill[(spill_first + spill_size) % spill.size()] = event;
+	spill_size++;
+	return !dropped;
+}
+
+// spilled events go first, merged move goes after them as it came later
+bool overlay_input_queue::flush()
+{
+	while (spill_size != 0 && ring.push(spill[spill_first]))
+	{
+		spill_first = (spill_first + 1) % spill.size();
+		spill_size--;
+	}
+
+	if (spill_size == 0 && has_pending_move && ring.get_free_space() > reserved_for_clicks)
+	{
+		ring.push(pending_move);
+		has_pending_move = false;
+	}
+
+	return has_waiting();
+}
+
+bool overlay_input_queue::has_waiting() const
+{
+	return spill_size != 0 || has_pending_move;
+}
+
+bool overlay_input_queue::push(const overlay_input_event& event)
+{
+	flush();
+
+	if (is_mouse_move(event))
+	{
+		if (has_pending_move)
+		{
+			merge_mouse_move(pending_move, event);
+		} else if (spill_size != 0 || ring.get_free_space() <= reserved_for_clicks || !ring.push(event))
+		{
+			pending_move = event;
+			has_pending_move = true;
+		}
+		return true;
+	}
+
+	bool kept = true;
+	if (has_pending_move)
+	{
+		if (spill_size != 0 || !ring.push(pending_move))
+		{
+			kept = add_to_spill(pending_move);
+		}
+		has_pending_move = false;
+	}
+
+	if (spill_size == 0 && ring.push(event))
+	{
+		return kept;
+	}
+	return add_to_spill(event) && kept;
+}
+
+bool overlay_input_queue::peek(overlay_input_event& event) const
+{
+	return ring.peek(event);
+}
+
+bool overlay_input_queue::pop(overlay_input_event& event)
+{
+	return ring.pop(event);
+}
+
+size_t overlay_input_queue::pop_many(overlay_input_event* to, size_t max_count)
+{
+	return ring.pop_many(to, max_count);
+}
+
+void overlay_input_queue::clear()
+{
+	ring.clear();
+}
+
+uint64_t overlay_input_queue::get_dropped_count() const
+{
+	return dropped_count.load(std::memory_order_relaxed);
+}
+
+size_t overlay_input_queue::get_spill_capacity() const
+{
+	return spill.size();
+}
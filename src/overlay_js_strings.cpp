@@ -0,0 +1,70 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_js_strings.h"
+#include <string.h>
+
+overlay_js_strings::overlay_js_strings()
+{
+	env = nullptr;
+	for (size_t i = 0; i < max_count; i++)
+	{
+		refs[i] = nullptr;
+	}
+}
+
+napi_status overlay_js_strings::get(napi_env to_env, size_t index, const char* text, napi_value* result)
+{
+	if (index >= max_count)
+	{
+		return napi_create_string_utf8(to_env, text, strlen(text), result);
+	}
+
+	if (env != to_env)
+	{
+		release();
+		env = to_env;
+	}
+
+	if (refs[index] != nullptr)
+	{
+		napi_status status = napi_get_reference_value(env, refs[index], result);
+		if (status == napi_ok && *result != nullptr)
+		{
+			return status;
+		}
+		napi_delete_reference(env, refs[index]);
+		refs[index] = nullptr;
+	}
+
+	napi_status status = napi_create_string_utf8(env, text, strlen(text), result);
+	if (status == napi_ok)
+	{
+		status = napi_create_reference(env, *result, 1, &refs[index]);
+	}
+	return status;
+}
+
+void overlay_js_strings::release()
+{
+	for (size_t i = 0; i < max_count; i++)
+	{
+		if (refs[i] != nullptr)
+		{
+			napi_delete_reference(env, refs[i]);
+			refs[i] = nullptr;
+		}
+	}
+	env = nullptr;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_latency_histogram.h"
+
+overlay_latency_histogram::overlay_latency_histogram()
+{
+	reset();
+}
+
+int overlay_latency_histogram::get_bucket(uint64_t value)
+{
+	if (value >= (1ull << 32))
+	{
+		value = (1ull << 32) - 1;
+	}
+
+	if (value < 2 * sub_bucket_count)
+	{
+		return static_cast<int>(value);
+	}
+
+	int bits = 0;
+	for (uint64_t rest = value; rest != 0; rest >>= 1)
+	{
+		bits++;
+	}
+	const int shift = bits - sub_bucket_bits - 1;
+	return (shift + 1) * sub_bucket_count + static_cast<int>((value >> shift) - sub_bucket_count);
+}
+
+uint64_t overlay_latency_histogram::get_bucket_value(int bucket)
+{
+	if (bucket < 2 * sub_bucket_count)
+	{
+		return static_cast<uint64_t>(bucket);
+	}
+
+	const int shift = bucket / sub_bucket_count - 1;
+	const uint64_t lowest = static_cast<uint64_t>(sub_bucket_count + bucket % sub_bucket_count) << shift;
+	return lowest + (1ull << shift) - 1;
+}
+
+void overlay_latency_histogram::record(uint64_t microseconds)
+{
+	counts[get_bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+	total_count.fetch_add(1, std::memory_order_relaxed);
+	if (microseconds > max_value.load(std::memory_order_relaxed))
+	{
+		max_value.store(microseconds, std::memory_order_relaxed);
+	}
+}
+
+void overlay_latency_histogram::reset()
+{
+	for (int i = 0; i < bucket_count; i++)
+	{
+		counts[i].store(0, std::memory_order_relaxed);
+	}
+	total_count.store(0, std::memory_order_relaxed);
+	max_value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t overlay_latency_histogram::get_count() const
+{
+	return total_count.load(std::memory_order_relaxed);
+}
+
+uint64_t overlay_latency_histogram::get_max() const
+{
+	return max_value.load(std::memory_order_relaxed);
+}
+
+uint64_t overlay_latency_histogram::get_percentile(double percentile) const
+{
+	const uint64_t count = get_count();
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	uint64_t wanted = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+	if (wanted == 0)
+	{
+		wanted = 1;
+	}
+
+	const uint64_t max = get_max();
+	uint64_t seen = 0;
+	for (int i = 0; i < bucket_count; i++)
+	{
+		seen += counts[i].load(std::memory_order_relaxed);
+		if (seen >= wanted)
+		{
+			const uint64_t value = get_bucket_value(i);
+			return value < max ? value : max;
+		}
+	}
+	return max;
+}
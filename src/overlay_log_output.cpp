@@ -0,0 +1,115 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_log_output.h"
+
+#include <string>
+#include <time.h>
+
+namespace fs = std::filesystem;
+
+size_t format_log_time(char* to, std::time_t second)
+{
+	struct tm local;
+#ifdef _WIN32
+	localtime_s(&local, &second);
+#else
+	localtime_r(&second, &local);
+#endif
+	return std::strftime(to, log_time_size, "%Y%m%d:%H%M%S.", &local);
+}
+
+static fs::path get_rotated_log_path(const fs::path& log_file, int index)
+{
+	fs::path rotated = log_file;
+	rotated += "." + std::to_string(index);
+	return rotated;
+}
+
+// does not throw, file which can not be moved is left in place and appended to
+void rotate_log_files(const fs::path& log_file, int files_kept)
+{
+	std::error_code ec;
+	fs::remove(get_rotated_log_path(log_file, files_kept), ec);
+	for (int i = files_kept - 1; i >= 1; i--)
+	{
+		fs::rename(get_rotated_log_path(log_file, i), get_rotated_log_path(log_file, i + 1), ec);
+	}
+	if (files_kept > 0)
+	{
+		fs::rename(log_file, get_rotated_log_path(log_file, 1), ec);
+	}
+	fs::remove(log_file, ec);
+}
+
+overlay_log_file::overlay_log_file()
+{
+	size = 0;
+	max_size = 0;
+	files_kept = 0;
+}
+
+bool overlay_log_file::open(const fs::path& file_path, uintmax_t file_max_size, int rotated_files_kept)
+{
+	path = file_path;
+	max_size = file_max_size;
+	files_kept = rotated_files_kept;
+
+	try {
+		file.open(path, std::ios_base::out | std::ios_base::app);
+	} catch (...) {
+	}
+
+	std::error_code ec;
+	size = fs::file_size(path, ec);
+	if (ec)
+	{
+		size = 0;
+	}
+	return file.is_open();
+}
+
+bool overlay_log_file::is_open() const
+{
+	return file.is_open();
+}
+
+// line is never split between files, file is rotated after the line which reached max size
+void overlay_log_file::write(const char* text, size_t length)
+{
+	file.write(text, length);
+	size += length;
+
+	if (size >= max_size)
+	{
+		rotate();
+	}
+}
+
+void overlay_log_file::flush()
+{
+	file.flush();
+}
+
+void overlay_log_file::rotate()
+{
+	file.close();
+	rotate_log_files(path, files_kept);
+	open(path, max_size, files_kept);
+}
+
+uintmax_t overlay_log_file::get_size() const
+{
+	return size;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_log_ring.h"
+#include <string.h>
+
+overlay_log_ring::overlay_log_ring()
+{
+	for (size_t i = 0; i < capacity; i++)
+	{
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+		cells[i].length = 0;
+	}
+	push_position = 0;
+	pop_position = 0;
+	dropped_count = 0;
+}
+
+bool overlay_log_ring::push(const char* text, size_t length)
+{
+	size_t position = push_position.load(std::memory_order_relaxed);
+	cell* target = nullptr;
+
+	while (target == nullptr)
+	{
+		cell& candidate = cells[position % capacity];
+		const size_t sequence = candidate.sequence.load(std::memory_order_acquire);
+		const ptrdiff_t difference = static_cast<ptrdiff_t>(sequence - position);
+
+		if (difference == 0)
+		{
+			// cell is free for this position, claim it
+			if (push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				target = &candidate;
+			}
+		} else if (difference < 0)
+		{
+			// writer did not take the line pushed one lap ago
+			dropped_count.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else
+		{
+			position = push_position.load(std::memory_order_relaxed);
+		}
+	}
+
+	target->length = length < record_size ? length : record_size;
+	memcpy(target->text, text, target->length);
+	target->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+size_t overlay_log_ring::pop(char* to)
+{
+	cell& source = cells[pop_position % capacity];
+	if (source.sequence.load(std::memory_order_acquire) != pop_position + 1)
+	{
+		return 0;
+	}
+
+	const size_t length = source.length;
+	memcpy(to, source.text, length);
+	source.sequence.store(pop_position + capacity, std::memory_order_release);
+	pop_position++;
+	return length;
+}
+
+bool overlay_log_ring::has_line() const
+{
+	return cells[pop_position % capacity].sequence.load(std::memory_order_acquire) == pop_position + 1;
+}
+
+size_t overlay_log_ring::take_dropped_count()
+{
+	return dropped_count.exchange(0, std::memory_order_relaxed);
+}
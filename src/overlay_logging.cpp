@@ -13,64 +13,265 @@
 ******************************************************************************/
 
 #include "overlay_logging.h"
+#include "overlay_log_output.h"
 
 #include <ctime>
-#include <time.h>
 #include <chrono>
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <thread>
 
-bool log_output_disabled = true;
+std::atomic<bool> log_output_disabled(true);
+std::atomic<int> log_output_level(OVERLAY_LOG_MIN_LEVEL);
 bool log_output_old_stored = false;
 
-namespace fs = std::filesystem;
-std::ofstream log_output_file;
+static overlay_log_file log_output_file; // writer thread only while it runs
+static overlay_log_ring log_ring;
+
+// current file is moved to ".1" when it grows over max size, ".1" to ".2" and so on, oldest is removed
+static const uintmax_t log_file_max_size = 10 * 1024 * 1024;
+static const int log_files_kept = 5; // current file and rotated ones
+
+// lines being formatted, stop waits for them so no line is left in ring after logging is disabled
+static std::atomic<int> log_lines_in_flight(0);
+
+// background thread draining log ring to the file. it sleeps while ring is empty and is woken by
+// the thread which pushed a line. producer takes the mutex only when writer is going to sleep or sleeps
+struct overlay_log_writer
+{
+	std::thread thread;
+	std::mutex control; // start and stop
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::atomic<bool> sleeping;
+	bool running; // under wake_mutex
+
+	overlay_log_writer() : sleeping(false), running(false) {}
+	~overlay_log_writer()
+	{
+		// at process exit thread may be gone already, do not wait for it
+		if (thread.joinable())
+		{
+			thread.detach();
+		}
+	}
+
+	void start();
+	void stop();
+	void run();
+	void wake_up();
+	bool wait_for_lines();
+};
+
+static overlay_log_writer log_writer;
+
+// "YYYYMMDD:HHMMSS.mmm", date and time part is formatted once per second on each thread
+static size_t format_time_stamp(char* to)
+{
+	thread_local std::time_t cached_second = -1;
+	thread_local char cached_prefix[log_time_size] = {0};
+	thread_local size_t cached_length = 0;
+
+	const long long now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const std::time_t second = static_cast<std::time_t>(now / 1000);
+	if (second != cached_second)
+	{
+		cached_length = format_log_time(cached_prefix, second);
+		cached_second = second;
+	}
+
+	memcpy(to, cached_prefix, cached_length);
+	const int milliseconds = static_cast<int>(now % 1000);
+	to[cached_length] = static_cast<char>('0' + milliseconds / 100);
+	to[cached_length + 1] = static_cast<char>('0' + milliseconds / 10 % 10);
+	to[cached_length + 2] = static_cast<char>('0' + milliseconds % 10);
+	return cached_length + 3;
+}
 
 const std::string getTimeStamp() 
 {
-	const std::time_t t = std::time(nullptr);
+	char time_stamp[log_time_size + 3];
+	const size_t length = format_time_stamp(time_stamp);
+	return std::string(time_stamp, length);
+}
+
+overlay_log_site::overlay_log_site() : window_second(-1), window_count(0), suppressed_count(0) {}
+
+bool overlay_log_site::allow(int& suppressed)
+{
+	const long long second = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 
-	struct tm buf;
-	localtime_s(&buf, &t);
+	suppressed = 0;
+	long long current = window_second.load(std::memory_order_relaxed);
+	if (current != second && window_second.compare_exchange_strong(current, second, std::memory_order_relaxed))
+	{
+		// thread starting a new second reports what was skipped in the previous one
+		window_count.store(0, std::memory_order_relaxed);
+		suppressed = suppressed_count.exchange(0, std::memory_order_relaxed);
+	}
 
-	char mbstr[128]={0};
-	std::strftime(mbstr, sizeof(mbstr), "%Y%m%d:%H%M%S.", &buf);
-	unsigned __int64 now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	if (window_count.fetch_add(1, std::memory_order_relaxed) < max_lines_per_second)
+	{
+		return true;
+	}
 
-	std::ostringstream ss;
-	ss << mbstr << std::setw(3) << std::setfill('0') << now%1000;
-	return ss.str();
+	suppressed_count.fetch_add(suppressed + 1, std::memory_order_relaxed);
+	suppressed = 0;
+	return false;
+}
+
+overlay_log_line::overlay_log_line(const char* level, int suppressed) : buffer(text, sizeof(text) - 1), stream(&buffer)
+{
+	log_lines_in_flight.fetch_add(1);
+
+	char prefix[32];
+	size_t length = strlen(level);
+	memcpy(prefix, level, length);
+	prefix[length++] = ':';
+	length += format_time_stamp(prefix + length);
+	prefix[length++] = ':';
+	prefix[length++] = ' ';
+	stream.write(prefix, length);
+
+	if (suppressed != 0)
+	{
+		stream << "(suppressed " << suppressed << " messages) ";
+	}
+}
+
+// line which did not fit is cut, last byte of text is kept for line end.
+// line finished after logging was disabled is skipped
+overlay_log_line::~overlay_log_line()
+{
+	size_t length = buffer.get_size();
+	if (length == 0 || text[length - 1] != '\n')
+	{
+		text[length++] = '\n';
+	}
+	if (!log_output_disabled.load())
+	{
+		log_ring.push(text, length);
+		log_writer.wake_up();
+	}
+	log_lines_in_flight.fetch_sub(1);
+}
+
+void overlay_log_writer::start()
+{
+	std::lock_guard<std::mutex> control_lock(control);
+	if (thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		running = true;
+	}
+	thread = std::thread(&overlay_log_writer::run, this);
+}
+
+// writes all lines queued before stop. logging has to be disabled already
+void overlay_log_writer::stop()
+{
+	std::lock_guard<std::mutex> control_lock(control);
+	if (!thread.joinable())
+	{
+		return;
+	}
+	while (log_lines_in_flight.load() != 0)
+	{
+		std::this_thread::yield();
+	}
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		running = false;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+// any thread, after push. fences pair with the ones in wait_for_lines, so either writer sees
+// the line before it sleeps or this thread sees it sleeping
+void overlay_log_writer::wake_up()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		wake.notify_one();
+	}
+}
+
+// writer thread, false when it has to stop after the last drain
+bool overlay_log_writer::wait_for_lines()
+{
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	sleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	wake.wait(lock, [this]() { return !running || log_ring.has_line(); });
+	sleeping.store(false, std::memory_order_relaxed);
+	return running;
+}
+
+void overlay_log_writer::run()
+{
+	char record[overlay_log_ring::record_size];
+
+	bool keep_running = true;
+	while (true)
+	{
+		size_t written = 0;
+		size_t length = 0;
+		while ((length = log_ring.pop(record)) != 0)
+		{
+			log_output_file.write(record, length);
+			written++;
+		}
+
+		const size_t dropped = log_ring.take_dropped_count();
+		if (dropped != 0)
+		{
+			const std::string line = "ERR:" + getTimeStamp() + ": APP: " + std::to_string(dropped) + " log lines dropped, writer is behind\n";
+			log_output_file.write(line.data(), line.size());
+		}
+
+		if (written != 0 || dropped != 0)
+		{
+			log_output_file.flush();
+		}
+
+		if (!keep_running)
+		{
+			break;
+		}
+
+		keep_running = wait_for_lines();
+	}
 }
 
 void logging_start(std::string log_path)
 {
     if (log_output_file.is_open())
     {
+        log_writer.start();
         log_output_disabled = false;
         return;
     }
 
     if( log_path.size() != 0)
     {
-        std::error_code ec;
         if( !log_output_old_stored )
         {
+            // log of previous session becomes the first rotated file
             log_output_old_stored = true;
-            try {
-                fs::path log_file = log_path;
-                fs::path log_file_old = log_file;
-                log_file_old.replace_extension("log.old");
-                fs::remove(log_file_old, ec);
-                fs::rename(log_file, log_file_old, ec); 
-                fs::remove(log_file, ec);
-            } catch (...) {
-            }   
+            rotate_log_files(log_path, log_files_kept - 1);
         }   
-        try {
-            log_output_file.open( log_path, std::ios_base::out | std::ios_base::app);
+        if (log_output_file.open(log_path, log_file_max_size, log_files_kept - 1))
+        {
+            log_writer.start();
             log_output_disabled = false;
-        } catch (...) {
+        } else {
             log_output_disabled = true;
         }
     } else {
@@ -78,11 +279,33 @@ void logging_start(std::string log_path)
     }
 }
 
+bool logging_set_level(const std::string& level_name)
+{
+	int level = OVERLAY_LOG_LEVEL_NONE;
+	if (level_name == "debug")
+	{
+		level = OVERLAY_LOG_LEVEL_DEBUG;
+	} else if (level_name == "info")
+	{
+		level = OVERLAY_LOG_LEVEL_INFO;
+	} else if (level_name == "error")
+	{
+		level = OVERLAY_LOG_LEVEL_ERROR;
+	} else if (level_name != "none")
+	{
+		return false;
+	}
+
+	log_output_level = level;
+	return true;
+}
+
 void logging_end()
 {
     if( log_output_file.is_open() ) 
     {
-        log_output_file.flush();
         log_output_disabled = true;
+        log_writer.stop();
+        log_output_file.flush();
     }
 }
@@ -0,0 +1,92 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_painted_buffers.h"
+
+#include <mutex>
+#include <uv.h>
+#include <vector>
+#include "overlay_logging.h"
+
+static std::mutex painted_buffers_access;
+static std::vector<napi_ref> released_buffers; // guarded by painted_buffers_access
+static std::vector<napi_ref> deleted_buffers;  // JS thread only, swapped with released ones
+static napi_env painted_buffers_env = nullptr;
+static uv_async_t painted_buffers_async;
+
+// JS thread. one wake up deletes all references released since previous one
+static void delete_released_buffers(uv_async_t* handle)
+{
+	{
+		std::lock_guard<std::mutex> lock(painted_buffers_access);
+		deleted_buffers.swap(released_buffers);
+	}
+
+	for (napi_ref buffer : deleted_buffers)
+	{
+		napi_delete_reference(painted_buffers_env, buffer);
+	}
+	deleted_buffers.clear();
+}
+
+napi_status init_painted_buffers(napi_env env)
+{
+	if (painted_buffers_env != nullptr)
+	{
+		return napi_ok;
+	}
+
+	uv_loop_t* loop = nullptr;
+	napi_status status = napi_get_uv_event_loop(env, &loop);
+	if (status != napi_ok)
+	{
+		return status;
+	}
+
+	if (uv_async_init(loop, &painted_buffers_async, &delete_released_buffers) != 0)
+	{
+		log_error << "APP: init_painted_buffers failed to init async handle" << std::endl;
+		return napi_generic_failure;
+	}
+	// released buffers alone should not keep node event loop alive
+	uv_unref(reinterpret_cast<uv_handle_t*>(&painted_buffers_async));
+
+	// references of a few frames in flight are released at once, vectors grow only past that
+	released_buffers.reserve(64);
+	deleted_buffers.reserve(64);
+	painted_buffers_env = env;
+	return napi_ok;
+}
+
+napi_status keep_painted_buffer(napi_env env, napi_value buffer, void** keeper)
+{
+	napi_ref reference = nullptr;
+	napi_status status = napi_create_reference(env, buffer, 1, &reference);
+	*keeper = status == napi_ok ? reference : nullptr;
+	return status;
+}
+
+void release_painted_buffer(void* keeper)
+{
+	if (keeper == nullptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(painted_buffers_access);
+		released_buffers.push_back(static_cast<napi_ref>(keeper));
+	}
+	uv_async_send(&painted_buffers_async);
+}
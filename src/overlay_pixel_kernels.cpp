@@ -0,0 +1,392 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_pixel_kernels.h"
+#include "overlay_cpu_features.h"
+
+#include <string.h>
+
+#if defined(OVERLAY_ARCH_X86)
+#include <immintrin.h>
+#elif defined(OVERLAY_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+// Straight alpha source: alpha' = alpha * global / 255, color' = color * alpha' / 255.
+// Premultiplied source: every channel is scaled by global / 255.
+// Division by 255 is rounded the same way in all versions: t = x * y + 128, (t + (t >> 8)) >> 8
+
+typedef void (*convert_pixels_fn)(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion);
+
+static inline uint8_t mul_div255(unsigned int x, unsigned int y)
+{
+	const unsigned int t = x * y + 128;
+	return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+static void convert_pixels_scalar(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	const unsigned int global_alpha = conversion.global_alpha;
+	for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+	{
+		uint8_t c0 = src[0];
+		const uint8_t c1 = src[1];
+		uint8_t c2 = src[2];
+		const uint8_t a = src[3];
+
+		if (conversion.swap_red_blue)
+		{
+			const uint8_t t = c0;
+			c0 = c2;
+			c2 = t;
+		}
+
+		if (conversion.premultiply)
+		{
+			const uint8_t alpha = mul_div255(a, global_alpha);
+			dst[0] = mul_div255(c0, alpha);
+			dst[1] = mul_div255(c1, alpha);
+			dst[2] = mul_div255(c2, alpha);
+			dst[3] = alpha;
+		} else
+		{
+			dst[0] = mul_div255(c0, global_alpha);
+			dst[1] = mul_div255(c1, global_alpha);
+			dst[2] = mul_div255(c2, global_alpha);
+			dst[3] = mul_div255(a, global_alpha);
+		}
+	}
+}
+
+#if defined(OVERLAY_ARCH_X86)
+// two pixels widened to 16 bit lanes
+static inline __m128i convert_two_pixels_sse2(__m128i pixels, const overlay_pixel_conversion& conversion, __m128i global_alpha)
+{
+	const __m128i round = _mm_set1_epi16(128);
+
+	if (conversion.swap_red_blue)
+	{
+		pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+		pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	__m128i factor = global_alpha;
+	if (conversion.premultiply)
+	{
+		// alpha' in all lanes of a pixel, alpha lane set to 255 so it becomes alpha' after multiply
+		__m128i alpha = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+		alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+		alpha = _mm_add_epi16(_mm_mullo_epi16(alpha, global_alpha), round);
+		factor = _mm_srli_epi16(_mm_add_epi16(alpha, _mm_srli_epi16(alpha, 8)), 8);
+		pixels = _mm_or_si128(pixels, _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+	}
+
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels, factor), round);
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void convert_pixels_sse2(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i global_alpha = _mm_set1_epi16(conversion.global_alpha);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+		const __m128i lo = convert_two_pixels_sse2(_mm_unpacklo_epi8(pixels, zero), conversion, global_alpha);
+		const __m128i hi = convert_two_pixels_sse2(_mm_unpackhi_epi8(pixels, zero), conversion, global_alpha);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+	}
+
+	convert_pixels_scalar(dst + i * 4, src + i * 4, count - i, conversion);
+}
+
+OVERLAY_TARGET_AVX2 static inline __m256i convert_four_pixels_avx2(__m256i pixels, const overlay_pixel_conversion& conversion, __m256i global_alpha)
+{
+	const __m256i round = _mm256_set1_epi16(128);
+
+	if (conversion.swap_red_blue)
+	{
+		pixels = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+		pixels = _mm256_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	__m256i factor = global_alpha;
+	if (conversion.premultiply)
+	{
+		__m256i alpha = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+		alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+		alpha = _mm256_add_epi16(_mm256_mullo_epi16(alpha, global_alpha), round);
+		factor = _mm256_srli_epi16(_mm256_add_epi16(alpha, _mm256_srli_epi16(alpha, 8)), 8);
+		pixels = _mm256_or_si256(pixels, _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0));
+	}
+
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(pixels, factor), round);
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// unpack and pack work inside 128 bit halves, so pixel order is kept
+OVERLAY_TARGET_AVX2 static void convert_pixels_avx2(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i global_alpha = _mm256_set1_epi16(conversion.global_alpha);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+		const __m256i lo = convert_four_pixels_avx2(_mm256_unpacklo_epi8(pixels, zero), conversion, global_alpha);
+		const __m256i hi = convert_four_pixels_avx2(_mm256_unpackhi_epi8(pixels, zero), conversion, global_alpha);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+	}
+
+	convert_pixels_sse2(dst + i * 4, src + i * 4, count - i, conversion);
+}
+#elif defined(OVERLAY_ARCH_NEON)
+// vraddhn(t, vrshr(t, 8)) is (t + ((t + 128) >> 8) + 128) >> 8, same as scalar rounding
+static inline uint8x16_t mul_div255_neon(uint8x16_t x, uint8x16_t y)
+{
+	const uint16x8_t lo = vmull_u8(vget_low_u8(x), vget_low_u8(y));
+	const uint16x8_t hi = vmull_u8(vget_high_u8(x), vget_high_u8(y));
+	return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+static void convert_pixels_neon(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	const uint8x16_t global_alpha = vdupq_n_u8(conversion.global_alpha);
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t pixels = vld4q_u8(src + i * 4);
+
+		if (conversion.swap_red_blue)
+		{
+			const uint8x16_t t = pixels.val[0];
+			pixels.val[0] = pixels.val[2];
+			pixels.val[2] = t;
+		}
+
+		if (conversion.premultiply)
+		{
+			const uint8x16_t alpha = mul_div255_neon(pixels.val[3], global_alpha);
+			pixels.val[0] = mul_div255_neon(pixels.val[0], alpha);
+			pixels.val[1] = mul_div255_neon(pixels.val[1], alpha);
+			pixels.val[2] = mul_div255_neon(pixels.val[2], alpha);
+			pixels.val[3] = alpha;
+		} else
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				pixels.val[c] = mul_div255_neon(pixels.val[c], global_alpha);
+			}
+		}
+
+		vst4q_u8(dst + i * 4, pixels);
+	}
+
+	convert_pixels_scalar(dst + i * 4, src + i * 4, count - i, conversion);
+}
+#endif
+
+static convert_pixels_fn get_convert_pixels(overlay_isa isa)
+{
+	if (!cpu_has_isa(isa))
+	{
+		return nullptr;
+	}
+
+	switch (isa)
+	{
+	case overlay_isa::scalar:
+		return convert_pixels_scalar;
+#if defined(OVERLAY_ARCH_X86)
+	case overlay_isa::sse2:
+		return convert_pixels_sse2;
+	case overlay_isa::avx2:
+		return convert_pixels_avx2;
+#elif defined(OVERLAY_ARCH_NEON)
+	case overlay_isa::neon:
+		return convert_pixels_neon;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+static convert_pixels_fn select_convert_pixels()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_avx2())
+	{
+		return convert_pixels_avx2;
+	}
+	if (cpu_has_sse2())
+	{
+		return convert_pixels_sse2;
+	}
+#elif defined(OVERLAY_ARCH_NEON)
+	return convert_pixels_neon;
+#endif
+	return convert_pixels_scalar;
+}
+
+void convert_pixels(uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	static const convert_pixels_fn convert = select_convert_pixels();
+
+	if (conversion.is_copy())
+	{
+		if (dst != src)
+		{
+			memcpy(dst, src, count * 4);
+		}
+		return;
+	}
+
+	convert(dst, src, count, conversion);
+}
+
+bool convert_pixels_for_isa(overlay_isa isa, uint8_t* dst, const uint8_t* src, size_t count, const overlay_pixel_conversion& conversion)
+{
+	const convert_pixels_fn convert = get_convert_pixels(isa);
+	if (convert == nullptr)
+	{
+		return false;
+	}
+
+	convert(dst, src, count, conversion);
+	return true;
+}
+
+typedef void (*mark_alpha_blocks_fn)(uint8_t* blocks, const uint8_t* pixels, size_t block_count);
+
+static void mark_alpha_blocks_scalar(uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	for (size_t b = 0; b < block_count; b++, pixels += 16)
+	{
+		blocks[b] |= (pixels[3] | pixels[7] | pixels[11] | pixels[15]) != 0;
+	}
+}
+
+#if defined(OVERLAY_ARCH_X86)
+// alpha bytes are every fourth byte, block of 4 pixels has alpha if any of its alpha bytes is not zero
+static void mark_alpha_blocks_sse2(uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for (size_t b = 0; b < block_count; b++, pixels += 16)
+	{
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		const int zero_bytes = _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+		blocks[b] |= (zero_bytes & 0x8888) != 0x8888;
+	}
+}
+
+OVERLAY_TARGET_AVX2 static void mark_alpha_blocks_avx2(uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	size_t b = 0;
+	for (; b + 2 <= block_count; b += 2, pixels += 32)
+	{
+		const __m256i two_blocks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+		const unsigned int zero_bytes = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(two_blocks, zero)));
+		blocks[b] |= (zero_bytes & 0x8888) != 0x8888;
+		blocks[b + 1] |= (zero_bytes & 0x88880000) != 0x88880000;
+	}
+
+	mark_alpha_blocks_sse2(blocks + b, pixels, block_count - b);
+}
+#elif defined(OVERLAY_ARCH_NEON)
+static void mark_alpha_blocks_neon(uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	size_t b = 0;
+	for (; b + 4 <= block_count; b += 4, pixels += 64)
+	{
+		const uint8x16x4_t four_blocks = vld4q_u8(pixels);
+		// alpha of 4 pixels of a block lands in one 32 bit lane
+		const uint32x4_t alpha = vreinterpretq_u32_u8(four_blocks.val[3]);
+		const uint16x4_t has_alpha = vmovn_u32(vtstq_u32(alpha, alpha));
+		blocks[b] |= vget_lane_u16(has_alpha, 0) & 1;
+		blocks[b + 1] |= vget_lane_u16(has_alpha, 1) & 1;
+		blocks[b + 2] |= vget_lane_u16(has_alpha, 2) & 1;
+		blocks[b + 3] |= vget_lane_u16(has_alpha, 3) & 1;
+	}
+
+	mark_alpha_blocks_scalar(blocks + b, pixels, block_count - b);
+}
+#endif
+
+static mark_alpha_blocks_fn get_mark_alpha_blocks(overlay_isa isa)
+{
+	if (!cpu_has_isa(isa))
+	{
+		return nullptr;
+	}
+
+	switch (isa)
+	{
+	case overlay_isa::scalar:
+		return mark_alpha_blocks_scalar;
+#if defined(OVERLAY_ARCH_X86)
+	case overlay_isa::sse2:
+		return mark_alpha_blocks_sse2;
+	case overlay_isa::avx2:
+		return mark_alpha_blocks_avx2;
+#elif defined(OVERLAY_ARCH_NEON)
+	case overlay_isa::neon:
+		return mark_alpha_blocks_neon;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+static mark_alpha_blocks_fn select_mark_alpha_blocks()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_avx2())
+	{
+		return mark_alpha_blocks_avx2;
+	}
+	if (cpu_has_sse2())
+	{
+		return mark_alpha_blocks_sse2;
+	}
+#elif defined(OVERLAY_ARCH_NEON)
+	return mark_alpha_blocks_neon;
+#endif
+	return mark_alpha_blocks_scalar;
+}
+
+void mark_alpha_blocks(uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	static const mark_alpha_blocks_fn mark = select_mark_alpha_blocks();
+
+	mark(blocks, pixels, block_count);
+}
+
+bool mark_alpha_blocks_for_isa(overlay_isa isa, uint8_t* blocks, const uint8_t* pixels, size_t block_count)
+{
+	const mark_alpha_blocks_fn mark = get_mark_alpha_blocks(isa);
+	if (mark == nullptr)
+	{
+		return false;
+	}
+
+	mark(blocks, pixels, block_count);
+	return true;
+}
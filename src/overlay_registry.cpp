@@ -0,0 +1,141 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_registry.h"
+
+int overlay_registry::find_slot(int overlay_id) const
+{
+	if (overlay_id <= 0)
+	{
+		return -1;
+	}
+
+	const int index = overlay_id & (max_slots - 1);
+	const int generation = overlay_id >> slot_bits;
+	if (index >= static_cast<int>(slots.size()) || slots[index].generation != generation || slots[index].dense_index < 0)
+	{
+		return -1;
+	}
+
+	return index;
+}
+
+int overlay_registry::add(const std::shared_ptr<overlay_window>& overlay)
+{
+	int index = -1;
+	if (!free_slots.empty())
+	{
+		index = free_slots.back();
+		free_slots.pop_back();
+	} else if (slots.size() < static_cast<size_t>(max_slots))
+	{
+		index = static_cast<int>(slots.size());
+		slots.push_back(slot {1, -1, nullptr});
+	} else
+	{
+		return -1;
+	}
+
+	slots[index].dense_index = static_cast<int>(dense.size());
+	slots[index].window = nullptr;
+	dense.push_back(overlay);
+	dense_slots.push_back(index);
+
+	return (slots[index].generation << slot_bits) | index;
+}
+
+bool overlay_registry::remove(int overlay_id)
+{
+	const int index = find_slot(overlay_id);
+	if (index < 0)
+	{
+		return false;
+	}
+
+	slot& removed = slots[index];
+	if (removed.window != nullptr)
+	{
+		window_slots.erase(removed.window);
+	}
+
+	const int last = static_cast<int>(dense.size()) - 1;
+	if (removed.dense_index != last)
+	{
+		dense[removed.dense_index] = std::move(dense[last]);
+		dense_slots[removed.dense_index] = dense_slots[last];
+		slots[dense_slots[last]].dense_index = removed.dense_index;
+	}
+	dense.pop_back();
+	dense_slots.pop_back();
+
+	removed.dense_index = -1;
+	removed.window = nullptr;
+	removed.generation = removed.generation == max_generation ? 1 : removed.generation + 1;
+	free_slots.push_back(index);
+	return true;
+}
+
+bool overlay_registry::bind_window(int overlay_id, const void* window)
+{
+	const int index = find_slot(overlay_id);
+	if (index < 0)
+	{
+		return false;
+	}
+
+	if (slots[index].window != nullptr)
+	{
+		window_slots.erase(slots[index].window);
+	}
+	slots[index].window = window;
+	window_slots[window] = index;
+	return true;
+}
+
+std::shared_ptr<overlay_window> overlay_registry::find(int overlay_id) const
+{
+	const int index = find_slot(overlay_id);
+	if (index < 0)
+	{
+		return nullptr;
+	}
+
+	return dense[slots[index].dense_index];
+}
+
+std::shared_ptr<overlay_window> overlay_registry::find_by_window(const void* window) const
+{
+	auto found = window_slots.find(window);
+	if (found == window_slots.end())
+	{
+		return nullptr;
+	}
+
+	return dense[slots[found->second].dense_index];
+}
+
+size_t overlay_registry::size() const
+{
+	return dense.size();
+}
+
+overlay_registry::iterator overlay_registry::begin()
+{
+	return dense.begin();
+}
+
+overlay_registry::iterator overlay_registry::end()
+{
+	return dense.end();
+}
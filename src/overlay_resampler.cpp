@@ -0,0 +1,255 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_resampler.h"
+#include "overlay_cpu_features.h"
+
+#include <string.h>
+
+#if defined(OVERLAY_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+typedef void (*bilinear_row_fn)(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, int row_weight, const overlay_resample_tap* columns, int count);
+typedef void (*box_accumulate_fn)(uint32_t* sums, const uint8_t* row, const overlay_resample_tap* columns, int count);
+
+// pixel centers of source and destination are matched. next pixel is always first + 1
+// so a pair of pixels can be loaded at once, on the last pixel weight becomes 256 instead
+static void build_bilinear_taps(std::vector<overlay_resample_tap>& taps, int src_size, int dst_size)
+{
+	taps.resize(dst_size);
+	for (int i = 0; i < dst_size; i++)
+	{
+		const long long position = ((2LL * i + 1) * src_size * 256) / (2LL * dst_size) - 128;
+		int first = position < 0 ? 0 : static_cast<int>(position >> 8);
+		int weight = position < 0 ? 0 : static_cast<int>(position & 0xFF);
+
+		if (first >= src_size - 1)
+		{
+			first = src_size - 2;
+			weight = 256;
+		}
+
+		taps[i].first = first;
+		taps[i].count = 2;
+		taps[i].weight = weight;
+	}
+}
+
+static void build_box_taps(std::vector<overlay_resample_tap>& taps, int src_size, int dst_size)
+{
+	taps.resize(dst_size);
+	for (int i = 0; i < dst_size; i++)
+	{
+		const int first = static_cast<int>(static_cast<long long>(i) * src_size / dst_size);
+		const int last = static_cast<int>(static_cast<long long>(i + 1) * src_size / dst_size);
+		taps[i].first = first;
+		taps[i].count = last > first ? last - first : 1;
+		taps[i].weight = 0;
+	}
+}
+
+static inline uint32_t lerp_channel(uint32_t a, uint32_t b, uint32_t weight)
+{
+	return (a * (256 - weight) + b * weight + 128) >> 8;
+}
+
+static void bilinear_row_scalar(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, int row_weight, const overlay_resample_tap* columns, int count)
+{
+	for (int x = 0; x < count; x++, dst += 4)
+	{
+		const size_t p0 = static_cast<size_t>(columns[x].first) * 4;
+		for (int c = 0; c < 4; c++)
+		{
+			const uint32_t left = lerp_channel(row0[p0 + c], row1[p0 + c], row_weight);
+			const uint32_t right = lerp_channel(row0[p0 + 4 + c], row1[p0 + 4 + c], row_weight);
+			dst[c] = static_cast<uint8_t>(lerp_channel(left, right, columns[x].weight));
+		}
+	}
+}
+
+static void box_accumulate_scalar(uint32_t* sums, const uint8_t* row, const overlay_resample_tap* columns, int count)
+{
+	for (int x = 0; x < count; x++, sums += 4)
+	{
+		const uint8_t* pixel = row + static_cast<size_t>(columns[x].first) * 4;
+		for (int i = 0; i < columns[x].count; i++, pixel += 4)
+		{
+			sums[0] += pixel[0];
+			sums[1] += pixel[1];
+			sums[2] += pixel[2];
+			sums[3] += pixel[3];
+		}
+	}
+}
+
+#if defined(OVERLAY_ARCH_X86)
+// a pair of neighbour pixels in 16 bit lanes is blended with the next row, then halves are blended together
+static void bilinear_row_sse2(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, int row_weight, const overlay_resample_tap* columns, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+	const __m128i weight0 = _mm_set1_epi16(static_cast<short>(256 - row_weight));
+	const __m128i weight1 = _mm_set1_epi16(static_cast<short>(row_weight));
+
+	for (int x = 0; x < count; x++, dst += 4)
+	{
+		const size_t p0 = static_cast<size_t>(columns[x].first) * 4;
+		const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0 + p0)), zero);
+		const __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row1 + p0)), zero);
+
+		__m128i vertical = _mm_add_epi16(_mm_mullo_epi16(top, weight0), _mm_mullo_epi16(bottom, weight1));
+		vertical = _mm_srli_epi16(_mm_add_epi16(vertical, round), 8);
+
+		const short w = static_cast<short>(columns[x].weight);
+		const short iw = static_cast<short>(256 - columns[x].weight);
+		const __m128i column_weights = _mm_set_epi16(w, w, w, w, iw, iw, iw, iw);
+		__m128i blended = _mm_mullo_epi16(vertical, column_weights);
+		blended = _mm_add_epi16(blended, _mm_srli_si128(blended, 8));
+		blended = _mm_srli_epi16(_mm_add_epi16(blended, round), 8);
+
+		const int pixel = _mm_cvtsi128_si32(_mm_packus_epi16(blended, zero));
+		memcpy(dst, &pixel, 4);
+	}
+}
+
+static void box_accumulate_sse2(uint32_t* sums, const uint8_t* row, const overlay_resample_tap* columns, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int x = 0; x < count; x++, sums += 4)
+	{
+		const uint8_t* pixel = row + static_cast<size_t>(columns[x].first) * 4;
+		__m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums));
+		for (int i = 0; i < columns[x].count; i++, pixel += 4)
+		{
+			int value;
+			memcpy(&value, pixel, 4);
+			const __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+			sum = _mm_add_epi32(sum, channels);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sum);
+	}
+}
+#endif
+
+static bilinear_row_fn select_bilinear_row()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_sse2())
+	{
+		return bilinear_row_sse2;
+	}
+#endif
+	return bilinear_row_scalar;
+}
+
+static box_accumulate_fn select_box_accumulate()
+{
+#if defined(OVERLAY_ARCH_X86)
+	if (cpu_has_sse2())
+	{
+		return box_accumulate_sse2;
+	}
+#endif
+	return box_accumulate_scalar;
+}
+
+overlay_resampler::overlay_resampler()
+{
+	src_width = 0;
+	src_height = 0;
+	dst_width = 0;
+	dst_height = 0;
+	use_box = false;
+}
+
+void overlay_resampler::prepare(int new_src_width, int new_src_height, int new_dst_width, int new_dst_height)
+{
+	if (new_src_width == src_width && new_src_height == src_height && new_dst_width == dst_width && new_dst_height == dst_height)
+	{
+		return;
+	}
+
+	src_width = new_src_width;
+	src_height = new_src_height;
+	dst_width = new_dst_width;
+	dst_height = new_dst_height;
+	// bilinear needs two source pixels in each direction
+	use_box = src_width >= dst_width * 2 || src_height >= dst_height * 2 || src_width < 2 || src_height < 2;
+
+	if (use_box)
+	{
+		build_box_taps(columns, src_width, dst_width);
+		build_box_taps(rows, src_height, dst_height);
+		box_sums.resize(static_cast<size_t>(dst_width) * 4);
+	} else
+	{
+		build_bilinear_taps(columns, src_width, dst_width);
+		build_bilinear_taps(rows, src_height, dst_height);
+	}
+}
+
+void overlay_resampler::scale_bilinear(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch)
+{
+	static const bilinear_row_fn bilinear_row = select_bilinear_row();
+
+	for (int y = 0; y < dst_height; y++)
+	{
+		const uint8_t* row0 = src + rows[y].first * src_pitch;
+		bilinear_row(dst + y * dst_pitch, row0, row0 + src_pitch, rows[y].weight, columns.data(), dst_width);
+	}
+}
+
+void overlay_resampler::scale_box(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch)
+{
+	static const box_accumulate_fn box_accumulate = select_box_accumulate();
+
+	for (int y = 0; y < dst_height; y++)
+	{
+		memset(box_sums.data(), 0, box_sums.size() * sizeof(uint32_t));
+		for (int i = 0; i < rows[y].count; i++)
+		{
+			box_accumulate(box_sums.data(), src + (rows[y].first + i) * src_pitch, columns.data(), dst_width);
+		}
+
+		uint8_t* dst_row = dst + y * dst_pitch;
+		for (int x = 0; x < dst_width; x++)
+		{
+			const uint32_t area = static_cast<uint32_t>(rows[y].count * columns[x].count);
+			for (int c = 0; c < 4; c++)
+			{
+				dst_row[x * 4 + c] = static_cast<uint8_t>((box_sums[x * 4 + c] + area / 2) / area);
+			}
+		}
+	}
+}
+
+void overlay_resampler::scale(uint8_t* dst, int dst_w, int dst_h, size_t dst_pitch, const uint8_t* src, int src_w, int src_h, size_t src_pitch)
+{
+	if (dst_w <= 0 || dst_h <= 0 || src_w <= 0 || src_h <= 0)
+	{
+		return;
+	}
+
+	prepare(src_w, src_h, dst_w, dst_h);
+
+	if (use_box)
+	{
+		scale_box(dst, dst_pitch, src, src_pitch);
+	} else
+	{
+		scale_bilinear(dst, dst_pitch, src, src_pitch);
+	}
+}
@@ -0,0 +1,359 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_shared_frames.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static size_t align_size(size_t size)
+{
+	return (size + 63) & ~static_cast<size_t>(63);
+}
+
+overlay_shared_frames::overlay_shared_frames()
+{
+	mapping_handle = nullptr;
+	mapping_fd = -1;
+	view = nullptr;
+	view_size = 0;
+	owner = false;
+	last_read_frame = 0;
+	whole_frame_needed = true;
+}
+
+overlay_shared_frames::~overlay_shared_frames()
+{
+	close();
+}
+
+shared_frames_header* overlay_shared_frames::header()
+{
+	return reinterpret_cast<shared_frames_header*>(view);
+}
+
+shared_frame_slot_header* overlay_shared_frames::slot(uint32_t index)
+{
+	return reinterpret_cast<shared_frame_slot_header*>(view + align_size(sizeof(shared_frames_header)) + index * header()->slot_size);
+}
+
+// size 0 opens existing mapping with its whole size
+bool overlay_shared_frames::map(const std::string& name, size_t size, bool create)
+{
+#ifdef _WIN32
+	wchar_t wide_name[256];
+	if (MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, wide_name, 256) == 0)
+	{
+		return false;
+	}
+
+	HANDLE handle = nullptr;
+	if (create)
+	{
+		const unsigned long long mapping_size = size;
+		handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(mapping_size >> 32), static_cast<DWORD>(mapping_size & 0xFFFFFFFF), wide_name);
+		if (handle != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			CloseHandle(handle);
+			return false;
+		}
+	} else
+	{
+		handle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wide_name);
+	}
+
+	if (handle == nullptr)
+	{
+		return false;
+	}
+
+	view = static_cast<uint8_t*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (view == nullptr)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+	mapping_handle = handle;
+	view_size = size;
+#else
+	const std::string shm_name = name[0] == '/' ? name : "/" + name;
+	const int fd = shm_open(shm_name.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	if (create && ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		::close(fd);
+		shm_unlink(shm_name.c_str());
+		return false;
+	}
+
+	if (!create)
+	{
+		struct stat info;
+		if (fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+		size = static_cast<size_t>(info.st_size);
+	}
+
+	void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		::close(fd);
+		if (create)
+		{
+			shm_unlink(shm_name.c_str());
+		}
+		return false;
+	}
+	view = static_cast<uint8_t*>(mapped);
+	view_size = size;
+	mapping_fd = fd;
+#endif
+	mapping_name = name;
+	owner = create;
+	return true;
+}
+
+bool overlay_shared_frames::create(const std::string& name, uint32_t max_width, uint32_t max_height, uint32_t slot_count)
+{
+	close();
+
+	if (name.empty() || max_width == 0 || max_height == 0 || slot_count < 2)
+	{
+		return false;
+	}
+
+	const size_t slot_size = align_size(sizeof(shared_frame_slot_header)) + align_size(static_cast<size_t>(max_width) * max_height * 4);
+	const size_t size = align_size(sizeof(shared_frames_header)) + slot_size * slot_count;
+	if (!map(name, size, true))
+	{
+		return false;
+	}
+
+	// fresh mapping is zeroed so slot sequences start even
+	shared_frames_header* ring = header();
+	ring->version = shared_frames_version;
+	ring->slot_count = slot_count;
+	ring->max_width = max_width;
+	ring->max_height = max_height;
+	ring->slot_size = slot_size;
+	ring->last_frame_number.store(0);
+	std::atomic_thread_fence(std::memory_order_release);
+	ring->magic = shared_frames_magic;
+
+	request_full_frame();
+	return true;
+}
+
+bool overlay_shared_frames::open(const std::string& name)
+{
+	close();
+
+	if (name.empty() || !map(name, 0, false))
+	{
+		return false;
+	}
+
+	shared_frames_header* ring = header();
+#ifdef _WIN32
+	// view of whole mapping was requested, its size is known from header
+	view_size = align_size(sizeof(shared_frames_header)) + ring->slot_size * ring->slot_count;
+#endif
+	if (ring->magic != shared_frames_magic || ring->version != shared_frames_version ||
+	    align_size(sizeof(shared_frames_header)) + ring->slot_size * ring->slot_count > view_size)
+	{
+		close();
+		return false;
+	}
+
+	request_full_frame();
+	return true;
+}
+
+void overlay_shared_frames::close()
+{
+	if (view == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(view);
+	CloseHandle(static_cast<HANDLE>(mapping_handle));
+	mapping_handle = nullptr;
+#else
+	munmap(view, view_size);
+	::close(mapping_fd);
+	mapping_fd = -1;
+	if (owner)
+	{
+		const std::string shm_name = mapping_name[0] == '/' ? mapping_name : "/" + mapping_name;
+		shm_unlink(shm_name.c_str());
+	}
+#endif
+
+	view = nullptr;
+	view_size = 0;
+	owner = false;
+	mapping_name.clear();
+}
+
+bool overlay_shared_frames::is_open()
+{
+	return view != nullptr;
+}
+
+bool overlay_shared_frames::write_frame(const uint8_t* pixels, size_t pitch, int width, int height, const shared_frame_rect* rects, uint32_t rect_count)
+{
+	if (view == nullptr || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	shared_frames_header* ring = header();
+	if (static_cast<uint32_t>(width) > ring->max_width || static_cast<uint32_t>(height) > ring->max_height || pitch < static_cast<size_t>(width) * 4)
+	{
+		return false;
+	}
+
+	// numbering frames gives writers different slots, a slot still being written by a slow writer is skipped
+	const uint64_t frame_number = ring->last_frame_number.fetch_add(1) + 1;
+	for (uint32_t attempt = 0; attempt < ring->slot_count; attempt++)
+	{
+		shared_frame_slot_header* target = slot(static_cast<uint32_t>((frame_number + attempt) % ring->slot_count));
+		uint32_t sequence = target->sequence.load(std::memory_order_relaxed);
+		if ((sequence & 1) != 0 || !target->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+		{
+			continue;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		target->width = width;
+		target->height = height;
+		target->frame_number = frame_number;
+		target->rect_count = rect_count <= shared_frames_max_rects ? rect_count : 0;
+		if (target->rect_count != 0)
+		{
+			memcpy(target->rects, rects, target->rect_count * sizeof(shared_frame_rect));
+		}
+
+		uint8_t* target_pixels = reinterpret_cast<uint8_t*>(target) + align_size(sizeof(shared_frame_slot_header));
+		const size_t row_size = static_cast<size_t>(width) * 4;
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(target_pixels + y * row_size, pixels + y * pitch, row_size);
+		}
+
+		target->sequence.store(sequence + 2, std::memory_order_release);
+		return true;
+	}
+
+	return false;
+}
+
+bool overlay_shared_frames::read_begin(shared_frame_view& frame)
+{
+	if (view == nullptr)
+	{
+		return false;
+	}
+
+	shared_frames_header* ring = header();
+	bool found = false;
+	for (uint32_t index = 0; index < ring->slot_count; index++)
+	{
+		shared_frame_slot_header* source = slot(index);
+		const uint32_t sequence = source->sequence.load(std::memory_order_acquire);
+		if ((sequence & 1) != 0)
+		{
+			continue;
+		}
+
+		const uint64_t frame_number = source->frame_number;
+		if (frame_number <= last_read_frame || (found && frame_number <= frame.frame_number))
+		{
+			continue;
+		}
+
+		shared_frame_view candidate;
+		candidate.width = static_cast<int>(source->width);
+		candidate.height = static_cast<int>(source->height);
+		candidate.rect_count = source->rect_count;
+		if (candidate.rect_count <= shared_frames_max_rects)
+		{
+			memcpy(candidate.rects, source->rects, candidate.rect_count * sizeof(shared_frame_rect));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (source->sequence.load(std::memory_order_relaxed) != sequence)
+		{
+			continue;
+		}
+
+		if (candidate.width <= 0 || candidate.height <= 0 || static_cast<uint32_t>(candidate.width) > ring->max_width ||
+		    static_cast<uint32_t>(candidate.height) > ring->max_height || candidate.rect_count > shared_frames_max_rects)
+		{
+			continue;
+		}
+
+		candidate.pixels = reinterpret_cast<const uint8_t*>(source) + align_size(sizeof(shared_frame_slot_header));
+		candidate.slot = index;
+		candidate.sequence = sequence;
+		candidate.frame_number = frame_number;
+		frame = candidate;
+		found = true;
+	}
+
+	if (found)
+	{
+		frame.whole = whole_frame_needed || frame.frame_number != last_read_frame + 1 || frame.rect_count == 0;
+	}
+
+	return found;
+}
+
+bool overlay_shared_frames::read_end(const shared_frame_view& frame)
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	last_read_frame = frame.frame_number;
+	if (slot(frame.slot)->sequence.load(std::memory_order_relaxed) != frame.sequence)
+	{
+		whole_frame_needed = true;
+		return false;
+	}
+
+	whole_frame_needed = false;
+	return true;
+}
+
+// current frame can be read again, e.g. after window content buffer was recreated
+void overlay_shared_frames::request_full_frame()
+{
+	last_read_frame = 0;
+	whole_frame_needed = true;
+}
@@ -14,6 +14,9 @@
 
 #include "sl_overlay_api.h"
 
+#include "overlay_clock.h"
+#include "overlay_dirty_rects.h"
+#include "overlay_frame_layout.h"
 #include "overlay_logging.h"
 #include "sl_overlay_window.h"
 #include "sl_overlays.h"
@@ -256,77 +259,111 @@ int WINAPI add_overlay_by_hwnd(const void* hwnd_array, size_t array_size)
 	return ret;
 }
 
-int WINAPI paint_overlay_cached_buffer(int overlay_id, std::shared_ptr<overlay_frame> frame, int width, int height)
+static void delete_frame_copy(void* keeper)
 {
-	int ret = -1;
-	{
-		thread_state_mutex.lock();
-		if (thread_state != sl_overlay_thread_state::runing)
-		{
-			thread_state_mutex.unlock();
-		} else
-		{
-			std::shared_ptr<overlay_window> overlay = smg_overlays::get_instance()->get_overlay_by_id(overlay_id);
-
-			if (overlay != nullptr && width != 0 && height != 0)
-			{
-				RECT overlay_rect = overlay->get_rect();
-
-				if (width == overlay_rect.right - overlay_rect.left && height == overlay_rect.bottom - overlay_rect.top)
-				{
-					if (smg_overlays::get_instance()->showing_overlays)
-					{
-						if (overlay->set_cached_image(frame))
-							ret = 1;
-					}
-				} else
-				{
-					log_debug << "APP: paint_overlay_cached_buffer " << overlay_id << ", size " << width << "x" << height
-					          << ", for " << overlay_rect.right - overlay_rect.left << "x"
-					          << overlay_rect.bottom - overlay_rect.top << ", at [" << overlay_rect.left << ":"<< overlay_rect.top<< "]"<< std::endl;
-
-					overlay_rect.right = overlay_rect.left + width;
-					overlay_rect.bottom = overlay_rect.top + height;
-
-					overlay->apply_new_rect(overlay_rect);	
-
-					ret = 0;
-				}
-			}
+	delete static_cast<std::vector<uint8_t>*>(keeper);
+}
 
-			thread_state_mutex.unlock();
-		}
+// caller gave no keeper, so pixels are valid only during the call
+static void keep_frame_copy(overlay_painted_frame& frame)
+{
+	const size_t row_size = static_cast<size_t>(frame.width) * 4;
+	std::vector<uint8_t>* copy = new std::vector<uint8_t>(row_size * frame.height);
+	for (int y = 0; y < frame.height; y++)
+	{
+		memcpy(copy->data() + y * row_size, frame.pixels + y * frame.pitch, row_size);
 	}
-	return ret;
+	frame.pixels = copy->data();
+	frame.pitch = row_size;
+	frame.keeper = copy;
+	frame.release = &delete_frame_copy;
 }
 
-int WINAPI paint_overlay_from_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height)
+// frame is only checked and handed to overlay thread here, it is hashed, compared and copied there.
+// frame of other size than overlay is fitted or resizes overlay only when other_size_allowed, otherwise it is dropped
+static int paint_overlay_frame(int overlay_id, const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects, size_t stride, size_t offset, void* keeper, overlay_frame_release release, bool other_size_allowed)
 {
+	overlay_painted_frame frame;
+	frame.received_time = get_precise_time_us();
+	frame.width = width;
+	frame.height = height;
+	frame.dirty_rects = dirty_rects;
+	frame.keeper = keeper;
+	frame.release = release;
+
 	int ret = -1;
+	std::shared_ptr<overlay_window> overlay;
 	{
-		thread_state_mutex.lock();
-		if (thread_state != sl_overlay_thread_state::runing)
+		std::lock_guard<std::mutex> lock(thread_state_mutex);
+		if (thread_state == sl_overlay_thread_state::runing)
 		{
-			thread_state_mutex.unlock();
+			overlay = smg_overlays::get_instance()->get_overlay_by_id(overlay_id);
+		}
+	}
+
+	if (overlay != nullptr && width != 0 && height != 0)
+	{
+		RECT overlay_rect = overlay->get_rect();
+		overlay_stats& stats = overlay->get_stats();
+		overlay_stats::add(stats.frames_received);
+		const bool same_size = width == overlay_rect.right - overlay_rect.left && height == overlay_rect.bottom - overlay_rect.top;
+
+		if (!same_size && !other_size_allowed)
+		{
+			overlay_stats::add(stats.frames_dropped_size);
+		} else if (!same_size && overlay->get_frame_fit() == overlay_frame_fit::resize_overlay)
+		{
+			overlay_stats::add(stats.frames_dropped_size);
+			log_debug << "APP: paint_overlay_cached_buffer " << overlay_id << ", size " << width << "x" << height
+			          << ", for " << overlay_rect.right - overlay_rect.left << "x"
+			          << overlay_rect.bottom - overlay_rect.top << ", at [" << overlay_rect.left << ":"<< overlay_rect.top<< "]"<< std::endl;
+
+			// window is resized on overlay thread like for setPosition
+			set_overlay_position(overlay_id, overlay_rect.left, overlay_rect.top, width, height);
+
+			ret = 0;
+		} else if (!smg_overlays::get_instance()->showing_overlays)
+		{
+			overlay_stats::add(stats.frames_dropped_hidden);
+		} else if (image_array == nullptr || !is_frame_in_buffer(array_size, width, height, stride, offset))
+		{
+			log_error << "APP: paint_overlay_cached_buffer array_size = " << array_size << ", for " << width << "x" << height << ", stride = " << stride << ", offset = " << offset << std::endl;
 		} else
 		{
-			if (smg_overlays::get_instance()->showing_overlays)
+			frame.pixels = static_cast<const uint8_t*>(image_array) + offset;
+			frame.pitch = stride;
+			if (frame.keeper == nullptr)
 			{
-				std::shared_ptr<overlay_window> overlay = smg_overlays::get_instance()->get_overlay_by_id(overlay_id);
-				RECT overlay_rect = overlay->get_rect();
-
-				if (overlay != nullptr && width == overlay_rect.right - overlay_rect.left &&
-				    height == overlay_rect.bottom - overlay_rect.top)
-				{
-					overlay->apply_image_from_buffer(image_array, array_size, width, height);
-				}
+				keep_frame_copy(frame);
+			}
+
+			if (!overlay->accept_frame_by_rate(frame))
+			{
+				ret = 2;
+			} else
+			{
+				overlay->set_painted_frame(frame);
+				ret = 1;
 			}
-			thread_state_mutex.unlock();
 		}
 	}
+
+	// frame not handed to overlay goes back to its keeper now
+	release_painted_frame(frame);
 	return ret;
 }
 
+int WINAPI paint_overlay_cached_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects, size_t stride, size_t offset, void* keeper, overlay_frame_release release)
+{
+	return paint_overlay_frame(overlay_id, image_array, array_size, width, height, dirty_rects, stride, offset, keeper, release, true);
+}
+
+// paints only a frame of overlay size, other frames are rejected with -1 and overlay keeps its size
+int WINAPI paint_overlay_from_buffer(int overlay_id, const void* image_array, size_t array_size, int width, int height)
+{
+	return paint_overlay_frame(overlay_id, image_array, array_size, width, height, overlay_dirty_rects(), 0, 0, nullptr, nullptr, false);
+}
+
 int WINAPI set_overlay_position(int id, int x, int y, int width, int height)
 {
 	thread_state_mutex.lock();
@@ -439,6 +476,123 @@ int WINAPI set_overlay_autohide(int id, int autohide_timeout, int autohide_trans
 	return id;
 }
 
+// conversion is done while frames are copied on producer thread, so it is set directly and not by overlay thread message
+int WINAPI set_overlay_pixel_format(int id, const overlay_pixel_conversion& conversion)
+{
+	std::shared_ptr<overlay_window> overlay;
+	{
+		std::lock_guard<std::mutex> lock(thread_state_mutex);
+		if (thread_state == sl_overlay_thread_state::runing)
+		{
+			overlay = smg_overlays::get_instance()->get_overlay_by_id(id);
+		}
+	}
+
+	if (overlay == nullptr)
+	{
+		return -1;
+	}
+
+	overlay->set_pixel_conversion(conversion);
+	return id;
+}
+
+int WINAPI set_overlay_frame_fit(int id, overlay_frame_fit fit)
+{
+	std::shared_ptr<overlay_window> overlay;
+	{
+		std::lock_guard<std::mutex> lock(thread_state_mutex);
+		if (thread_state == sl_overlay_thread_state::runing)
+		{
+			overlay = smg_overlays::get_instance()->get_overlay_by_id(id);
+		}
+	}
+
+	if (overlay == nullptr)
+	{
+		return -1;
+	}
+
+	overlay->set_frame_fit(fit);
+	return id;
+}
+
+// ring is created here so a producer can open it by name as soon as this returns
+int WINAPI attach_overlay_shared_frames(int id, const std::string& name, int max_width, int max_height)
+{
+	if (max_width <= 0 || max_height <= 0)
+	{
+		return -1;
+	}
+
+	overlay_shared_frames* shared_frames = new overlay_shared_frames();
+	if (!shared_frames->create(name, max_width, max_height))
+	{
+		log_error << "APP: attach_overlay_shared_frames failed to create ring " << name << std::endl;
+		delete shared_frames;
+		return -1;
+	}
+
+	thread_state_mutex.lock();
+	if (thread_state != sl_overlay_thread_state::runing)
+	{
+		thread_state_mutex.unlock();
+		delete shared_frames;
+		return -1;
+	}
+
+	BOOL ret = PostThreadMessage(overlays_thread_id, WM_SLO_OVERLAY_SHARED_FRAMES, id, reinterpret_cast<LPARAM>(shared_frames));
+	thread_state_mutex.unlock();
+
+	if (!ret)
+	{
+		delete shared_frames;
+		return -1;
+	}
+
+	return id;
+}
+
+int WINAPI detach_overlay_shared_frames(int id)
+{
+	thread_state_mutex.lock();
+	if (thread_state != sl_overlay_thread_state::runing)
+	{
+		thread_state_mutex.unlock();
+		return -1;
+	}
+
+	BOOL ret = PostThreadMessage(overlays_thread_id, WM_SLO_OVERLAY_SHARED_FRAMES, id, 0);
+	thread_state_mutex.unlock();
+
+	if (!ret)
+	{
+		return -1;
+	}
+
+	return id;
+}
+
+int WINAPI set_overlay_frame_rate_limit(int id, int fps)
+{
+	std::shared_ptr<overlay_window> overlay;
+	{
+		std::lock_guard<std::mutex> lock(thread_state_mutex);
+		if (thread_state == sl_overlay_thread_state::runing)
+		{
+			overlay = smg_overlays::get_instance()->get_overlay_by_id(id);
+		}
+	}
+
+	if (overlay == nullptr)
+	{
+		return -1;
+	}
+
+	overlay->set_frame_rate_limit(fps);
+	return id;
+}
+
 std::shared_ptr<smg_overlays> get_overlays()
 {
 	thread_state_mutex.lock();
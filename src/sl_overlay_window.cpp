@@ -17,9 +17,18 @@
 #include "sl_overlays_settings.h"
 #include "stdafx.h"
 
+#include <cassert>
 #include <iostream>
+#include "overlay_allocation_counter.h"
+#include "overlay_clock.h"
+#include "overlay_flight_recorder.h"
+#include "overlay_frame_events.h"
+#include "overlay_frame_hash.h"
+#include "overlay_frame_layout.h"
 #include "overlay_logging.h"
 
+extern DWORD overlays_thread_id;
+
 void overlay_window::set_transparency(int transparency, bool save_as_normal)
 {
 	if (overlay_hwnd != 0)
@@ -62,6 +71,7 @@ void overlay_window::set_autohide(int timeout, int transparency)
 {
 	autohide_after = timeout;
 	autohide_by_transparency = transparency;
+	repaint_whole = true;
 	content_updated = true;
 	reset_autohide();
 }
@@ -95,15 +105,14 @@ void overlay_window::apply_interactive_mode(bool is_intercepting)
 	}
 }
 
-void overlay_window::check_autohide()
+void overlay_window::check_autohide(uint64_t current_ticks)
 {
-	ULONGLONG current_ticks = GetTickCount64();
-
 	if (autohide_after > 0 && !autohidden)
 	{
 		if (current_ticks > (last_content_chage_ticks + 1000 * autohide_after))
 		{
 			autohidden = true;
+			overlay_stats::add(stats.autohide_transitions);
 			if (autohide_by_transparency > 0)
 			{
 				set_transparency(autohide_by_transparency, false);
@@ -115,6 +124,80 @@ void overlay_window::check_autohide()
 	}
 }
 
+// time when check_autohide hides overlay, 0 if autohide is off or overlay is already hidden
+uint64_t overlay_window::get_autohide_deadline()
+{
+	if (autohide_after <= 0 || autohidden)
+	{
+		return 0;
+	}
+
+	return last_content_chage_ticks + 1000 * autohide_after + 1;
+}
+
+const int autohidden_frame_rate = 2;
+const uint64_t frame_rate_window_ms = 1000;
+const uint64_t slow_down_hold_ms = 5000;
+
+// called on overlay thread. tells producer to pause while overlay can't be seen and to slow down
+// while overlay thread uses less than half of frames it gets
+void overlay_window::check_producer_signal(bool overlays_shown)
+{
+	const uint64_t current_ticks = clock->now();
+
+	if (current_ticks - rate_window_start >= frame_rate_window_ms)
+	{
+		const uint64_t published = frames_published.load(std::memory_order_relaxed);
+		const uint64_t window_published = published - rate_window_published;
+		const uint64_t window_taken = frames_taken - rate_window_taken;
+		const uint64_t window_length = current_ticks - rate_window_start;
+
+		if (rate_window_start != 0 && window_published >= 10 && window_taken * 2 < window_published)
+		{
+			const int taken_rate = static_cast<int>(window_taken * 1000 / window_length);
+			used_frame_rate = taken_rate > 1 ? taken_rate : 1;
+		} else if (producer_event != overlay_frame_event::slow_down || current_ticks - producer_event_ticks >= slow_down_hold_ms)
+		{
+			// producer that was slowed down is let to speed up after a while to find if overlay keeps up now
+			used_frame_rate = 0;
+		}
+
+		rate_window_start = current_ticks;
+		rate_window_published = published;
+		rate_window_taken = frames_taken;
+	}
+
+	overlay_frame_event event = overlay_frame_event::resume;
+	int fps = 0;
+	if (!overlays_shown || !overlay_visibility)
+	{
+		event = overlay_frame_event::pause;
+	} else if (autohidden)
+	{
+		// new frames still have to come to show overlay again
+		event = overlay_frame_event::slow_down;
+		fps = autohidden_frame_rate;
+	} else if (used_frame_rate > 0)
+	{
+		event = overlay_frame_event::slow_down;
+		fps = used_frame_rate;
+	}
+
+	if (event == producer_event && fps == producer_fps)
+	{
+		return;
+	}
+
+	// not sent event is tried again on next check
+	if (send_frame_event(id, event, fps))
+	{
+		log_debug << "APP: frame event " << get_frame_event_name(event) << " " << fps << " for overlay " << id << std::endl;
+		producer_event = event;
+		producer_fps = fps;
+		producer_event_ticks = current_ticks;
+	}
+}
+
 void overlay_window::reset_autohide_timer()
 {
 	if (autohidden)
@@ -124,23 +207,43 @@ void overlay_window::reset_autohide_timer()
 			set_transparency(overlay_transparency, false);
 		}
 		autohidden = false;
+		overlay_stats::add(stats.autohide_transitions);
 	}
-	last_content_chage_ticks = GetTickCount64();
+	last_content_chage_ticks = clock->now();
 }
 
 overlay_window::~overlay_window()
 {
 	clean_resources();
+	release_painted_frame(painted_frame);
+	release_painted_frame(held_frame);
 }
 
 overlay_window::overlay_window()
 {
+	clock = get_overlay_clock();
 	last_content_chage_ticks = 0;
 	overlay_visibility = true;
 	content_updated = false;
 	content_set = false;
-	static int id_counter = 128;
-	id = id_counter++;
+	repaint_whole = false;
+	last_frame_hash = 0;
+	last_frame_width = 0;
+	last_frame_height = 0;
+	duplicate_frames_skipped = 0;
+	frame_fit = overlay_frame_fit::resize_overlay;
+	frame_ready_posted = false;
+	frame_held_posted = false;
+	producer_event = overlay_frame_event::resume;
+	producer_fps = 0;
+	producer_event_ticks = 0;
+	frames_published = 0;
+	frames_taken = 0;
+	rate_window_start = 0;
+	rate_window_published = 0;
+	rate_window_taken = 0;
+	used_frame_rate = 0;
+	id = 0; // given by overlay_registry
 	orig_handle = nullptr;
 	overlay_hwnd = nullptr;
 	manual_position = false;
@@ -172,6 +275,7 @@ void overlay_window::clean_resources()
 	{
 		status = overlay_status::destroing;
 		log_info << "APP: clean_resources for " << id << std::endl;
+		stats.content_buffer_bytes.store(0, std::memory_order_relaxed);
 
 		if (overlay_hwnd != nullptr)
 		{
@@ -272,38 +376,564 @@ bool overlay_window::set_rect(RECT& new_rect)
 	return true;
 }
 
-bool overlay_window::set_cached_image(std::shared_ptr<overlay_frame> save_frame)
+// pixels are converted during copy. rects can overlap so converting later in place could convert some pixels twice
+static void copy_rects(uint8_t* to, const uint8_t* from, size_t from_pitch, int width, const overlay_dirty_rects& rects, const overlay_pixel_conversion& conversion)
 {
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	for (const overlay_pixel_rect& rect : rects)
 	{
-		std::lock_guard<std::mutex> lock(frame_access);
-		frame = save_frame;
+		const size_t row_offset = rect.left * 4;
+		const size_t row_pixels = rect.right - rect.left;
+		for (int y = rect.top; y < rect.bottom; y++)
+		{
+			convert_pixels(to + y * pitch + row_offset, from + y * from_pitch + row_offset, row_pixels, conversion);
+		}
+	}
+}
 
-		const RECT overlay_rect = get_rect();
-		void* image_array = nullptr;
-		size_t image_array_size = 0;
-		size_t expected_array_size = (overlay_rect.right - overlay_rect.left) * (overlay_rect.bottom - overlay_rect.top) * 4;
+// called on overlay thread, takes newest frame from mailbox and repaints changed parts
+void overlay_window::update_content()
+{
+	content_updated = false;
 
-		frame->get_array(&image_array, &image_array_size);
-		if (image_array_size != expected_array_size)
+	take_painted_frame();
+	overlay_frame_slot* slot = frames.take();
+	if (slot != nullptr)
+	{
+		slot->times.taken = get_precise_time_us();
+		frames_taken++;
+		const RECT overlay_rect = get_rect();
+		if (slot->width == overlay_rect.right - overlay_rect.left && slot->height == overlay_rect.bottom - overlay_rect.top)
 		{
-			log_error << "APP: Saving image from electron array_size = " << image_array_size << ", expected = " << expected_array_size << std::endl;
-			frame = nullptr;
-			return false;
+			if (apply_image_from_buffer(slot->pixels.data(), slot->pixels.size(), slot->width, slot->height, slot->dirty_rects) && !repaint_whole)
+			{
+				for (const overlay_pixel_rect& dirty : slot->dirty_rects)
+				{
+					const RECT dirty_rect = {dirty.left, dirty.top, dirty.right, dirty.bottom};
+					InvalidateRect(overlay_hwnd, &dirty_rect, TRUE);
+				}
+			}
+			display_coverage.swap(slot->coverage);
+			reset_autohide();
+			record_flight_event(overlay_flight_event::frame_applied, id, slot->width, slot->height);
+			overlay_stats::add(stats.frames_applied);
+			overlay_stats::add(stats.bytes_uploaded, slot->dirty_rects.get_area() * 4);
+
+			slot->times.applied = get_precise_time_us();
+			record_frame_latency(overlay_frame_stage::copy, slot->times.received, slot->times.published);
+			record_frame_latency(overlay_frame_stage::wake, slot->times.published, slot->times.taken);
+			record_frame_latency(overlay_frame_stage::upload, slot->times.taken, slot->times.applied);
+			unpainted_frame = slot->times;
 		} else
 		{
-			if (apply_image_from_buffer(image_array, image_array_size, overlay_rect.right - overlay_rect.left, overlay_rect.bottom - overlay_rect.top))
+			record_flight_event(overlay_flight_event::frame_dropped, id, slot->width, slot->height);
+			overlay_stats::add(stats.frames_dropped_size);
+			log_debug << "APP: update_content drops frame " << slot->width << "x" << slot->height << " for overlay " << id << std::endl;
+		}
+	}
+
+	if (repaint_whole)
+	{
+		repaint_whole = false;
+		InvalidateRect(overlay_hwnd, nullptr, TRUE);
+	}
+}
+
+void release_painted_frame(overlay_painted_frame& frame)
+{
+	if (frame.release != nullptr)
+	{
+		frame.release(frame.keeper);
+	}
+	frame = overlay_painted_frame();
+}
+
+// called on thread what calls paintOverlay, takes ownership of frame pixels and only hands them to overlay thread.
+// takes the same short time for any frame size. frame replacing one overlay thread did not take yet gets its changed parts
+void overlay_window::set_painted_frame(overlay_painted_frame& frame)
+{
+	std::lock_guard<std::mutex> lock(frame_access);
+	frame_pacer.add_dropped_rects(frame.dirty_rects, frame.width, frame.height);
+
+	if (painted_frame.pixels != nullptr)
+	{
+		if (painted_frame.dirty_rects.size() == 0 || painted_frame.width != frame.width || painted_frame.height != frame.height)
+		{
+			frame.dirty_rects.clear();
+		} else if (frame.dirty_rects.size() != 0)
+		{
+			frame.dirty_rects.add(painted_frame.dirty_rects);
+		}
+		release_painted_frame(painted_frame);
+	}
+	painted_frame = frame;
+	frame = overlay_painted_frame();
+	frames_published++;
+
+	content_updated = true;
+	// one wake up is enough for all frames painted until overlay thread handles it
+	if (!frame_ready_posted.exchange(true))
+	{
+		if (!PostThreadMessage(overlays_thread_id, WM_SLO_OVERLAY_FRAME_READY, id, 0))
+		{
+			frame_ready_posted = false;
+		}
+	}
+}
+
+// called on overlay thread, hashes, compares, converts and copies newest painted frame to mailbox
+void overlay_window::take_painted_frame()
+{
+	overlay_painted_frame frame;
+	overlay_pixel_conversion conversion;
+	{
+		std::lock_guard<std::mutex> lock(frame_access);
+		if (painted_frame.pixels == nullptr)
+		{
+			return;
+		}
+		frame = painted_frame;
+		painted_frame = overlay_painted_frame();
+		conversion = pixel_conversion;
+	}
+
+	apply_painted_frame(frame, conversion);
+	release_painted_frame(frame);
+}
+
+// called on overlay thread. overlay could be resized since frame was painted, frame of other size is fitted or dropped
+void overlay_window::apply_painted_frame(const overlay_painted_frame& frame, const overlay_pixel_conversion& conversion)
+{
+	const RECT overlay_rect = get_rect();
+	if (frame.width == overlay_rect.right - overlay_rect.left && frame.height == overlay_rect.bottom - overlay_rect.top)
+	{
+		push_frame(frame.pixels, frame.pitch, frame.width, frame.height, frame.dirty_rects, frame.received_time, conversion);
+	} else if (frame_fit != overlay_frame_fit::resize_overlay)
+	{
+		fit_frame(frame.pixels, frame.width, frame.height, frame.pitch, frame.received_time, conversion);
+	} else
+	{
+		overlay_stats::add(stats.frames_dropped_size);
+	}
+}
+
+// called on overlay thread, image is scaled or cropped to overlay size and pushed
+bool overlay_window::fit_frame(const uint8_t* image, int image_width, int image_height, size_t image_pitch, uint64_t received_time, const overlay_pixel_conversion& conversion)
+{
+	const RECT overlay_rect = get_rect();
+	const int width = overlay_rect.right - overlay_rect.left;
+	const int height = overlay_rect.bottom - overlay_rect.top;
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	if (fitted_frame.size() != pitch * height)
+	{
+		std::vector<uint8_t> resized(pitch * height);
+		fitted_frame.swap(resized);
+	}
+
+	if (frame_fit == overlay_frame_fit::scale)
+	{
+		resampler.scale(fitted_frame.data(), width, height, pitch, image, image_width, image_height, image_pitch);
+	} else
+	{
+		// top left part of image, rest of overlay stays transparent
+		const size_t copy_size = (image_width < width ? image_width : width) * 4;
+		const int copy_rows = image_height < height ? image_height : height;
+		for (int y = 0; y < height; y++)
+		{
+			uint8_t* row = fitted_frame.data() + y * pitch;
+			const size_t copied = y < copy_rows ? copy_size : 0;
+			if (copied != 0)
+			{
+				memcpy(row, image + y * image_pitch, copied);
+			}
+			memset(row + copied, 0, pitch - copied);
+		}
+	}
+	overlay_stats::add(stats.bytes_fitted, pitch * height);
+
+	// dirty rects are in image coordinates, tiles compare will find what changed
+	return push_frame(fitted_frame.data(), pitch, width, height, overlay_dirty_rects(), received_time, conversion);
+}
+
+void overlay_window::set_frame_rate_limit(int fps)
+{
+	std::lock_guard<std::mutex> lock(frame_access);
+	frame_pacer.set_frame_rate_limit(fps);
+}
+
+int overlay_window::get_frame_rate_limit()
+{
+	std::lock_guard<std::mutex> lock(frame_access);
+	return frame_pacer.get_frame_rate_limit();
+}
+
+// called before frame is handed over, frames coming faster than overlay frame rate limit are dropped.
+// newest dropped frame is held without copy, it takes frame pixels and overlay thread publishes it when its time comes
+bool overlay_window::accept_frame_by_rate(overlay_painted_frame& frame)
+{
+	overlay_painted_frame replaced_frame;
+	bool accepted = true;
+	{
+		std::lock_guard<std::mutex> lock(frame_access);
+		// accepted frame is newer than the held one, so held one is given back too
+		replaced_frame = held_frame;
+		held_frame = overlay_painted_frame();
+		if (!frame_pacer.accept_frame(frame.dirty_rects))
+		{
+			accepted = false;
+			if (frame.pixels != nullptr)
 			{
-				content_updated = true;
+				frame_pacer.hold_frame();
+				held_frame = frame;
+				frame = overlay_painted_frame();
+				if (!frame_held_posted.exchange(true))
+				{
+					if (!PostThreadMessage(overlays_thread_id, WM_SLO_OVERLAY_FRAME_HELD, id, 0))
+					{
+						frame_held_posted = false;
+					}
+				}
 			}
-			frame = nullptr;
 		}
 	}
-	
-	reset_autohide(); 
+
+	release_painted_frame(replaced_frame);
+	return accepted;
+}
+
+// called on overlay thread before it schedules held frame, frames held after it post a new wake up
+void overlay_window::reset_frame_held_post()
+{
+	frame_held_posted = false;
+}
+
+// ms until held frame can be published, -1 if no frame is held
+int overlay_window::get_held_frame_delay()
+{
+	std::lock_guard<std::mutex> lock(frame_access);
+	if (!frame_pacer.has_held_frame())
+	{
+		return -1;
+	}
+	const std::chrono::steady_clock::duration delay = frame_pacer.get_held_frame_delay();
+	return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(delay).count());
+}
+
+// called on overlay thread, publishes held frame like producer would. false if it is still too early for it
+bool overlay_window::publish_held_frame()
+{
+	const uint64_t received_time = get_precise_time_us();
+	overlay_painted_frame frame;
+	overlay_painted_frame replaced_frame;
+	overlay_pixel_conversion conversion;
+	{
+		std::lock_guard<std::mutex> lock(frame_access);
+		if (!frame_pacer.take_held_frame(frame.dirty_rects))
+		{
+			return !frame_pacer.has_held_frame();
+		}
+
+		if (held_frame.pixels == nullptr)
+		{
+			return true;
+		}
+
+		// rects from pacer are of all frames dropped since last accepted one
+		frame.pixels = held_frame.pixels;
+		frame.pitch = held_frame.pitch;
+		frame.width = held_frame.width;
+		frame.height = held_frame.height;
+		frame.keeper = held_frame.keeper;
+		frame.release = held_frame.release;
+		held_frame = overlay_painted_frame();
+
+		// accepted frame overlay thread did not take yet is older, its changed parts go with held frame
+		if (painted_frame.pixels != nullptr)
+		{
+			if (painted_frame.dirty_rects.size() == 0 || painted_frame.width != frame.width || painted_frame.height != frame.height)
+			{
+				frame.dirty_rects.clear();
+			} else if (frame.dirty_rects.size() != 0)
+			{
+				frame.dirty_rects.add(painted_frame.dirty_rects);
+			}
+			replaced_frame = painted_frame;
+			painted_frame = overlay_painted_frame();
+		}
+		conversion = pixel_conversion;
+		frames_published++;
+	}
+
+	release_painted_frame(replaced_frame);
+	frame.received_time = received_time;
+	apply_painted_frame(frame, conversion);
+	content_updated = true;
+	release_painted_frame(frame);
+	return true;
+}
+
+uint64_t overlay_window::get_frames_accepted()
+{
+	return frame_pacer.get_accepted_count();
+}
+
+uint64_t overlay_window::get_frames_dropped()
+{
+	return frame_pacer.get_dropped_count();
+}
+
+void overlay_window::set_frame_fit(overlay_frame_fit fit)
+{
+	frame_fit = fit;
+}
+
+overlay_frame_fit overlay_window::get_frame_fit()
+{
+	return frame_fit;
+}
+
+// called on overlay thread, frame has overlay size and its rows are frame_pitch bytes apart
+bool overlay_window::push_frame(const uint8_t* frame_pixels, size_t frame_pitch, int width, int height, const overlay_dirty_rects& dirty_rects, uint64_t received_time, const overlay_pixel_conversion& conversion)
+{
+	overlay_dirty_rects frame_rects = dirty_rects;
+
+	// pages often repaint without visual changes, such frames are dropped before any copy or upload.
+	// frame can't be skipped if consumer asked for a whole frame, e.g. after window content buffer was recreated
+	const uint64_t frame_hash = hash_frame_rows(frame_pixels, static_cast<size_t>(width) * 4, frame_pitch, height, static_cast<uint64_t>(width));
+	if (frame_hash == last_frame_hash && width == last_frame_width && height == last_frame_height && !frames.is_full_frame_requested())
+	{
+		duplicate_frames_skipped++;
+		return true;
+	}
+	last_frame_hash = frame_hash;
+	last_frame_width = width;
+	last_frame_height = height;
+
+	if (frame_rects.size() == 0)
+	{
+		if (app_settings->detect_frame_damage)
+		{
+			frame_damage.find_damage(frame_pixels, frame_pitch, width, height, frame_rects);
+		} else
+		{
+			frame_rects.set_whole(width, height);
+		}
+	} else
+	{
+		frame_rects.clip(width, height);
+		if (app_settings->detect_frame_damage)
+		{
+			frame_damage.update(frame_pixels, frame_pitch, width, height, frame_rects);
+		}
+	}
+
+	if (!app_settings->detect_frame_damage)
+	{
+		frame_damage.reset();
+	}
+
+	if (frame_rects.size() != 0 || frames.is_full_frame_requested())
+	{
+#ifdef _DEBUG
+		const size_t allocations_before = get_thread_allocations_count();
+#endif
+		overlay_frame_slot& slot = frames.begin_write(width, height, frame_rects);
+		copy_rects(slot.pixels.data(), frame_pixels, frame_pitch, width, slot.dirty_rects, conversion);
+		overlay_stats::add(stats.bytes_copied, slot.dirty_rects.get_area() * 4);
+		// source frame is valid outside of dirty rects, so blocks around them can be checked here and not in the slot
+		frame_coverage.update(frame_pixels, frame_pitch, width, height, frame_rects);
+		slot.coverage = frame_coverage;
+		slot.times = overlay_frame_times();
+		slot.times.received = received_time;
+		slot.times.published = get_precise_time_us();
+		frames.publish();
+#ifdef _DEBUG
+		// only first frames after a resize are allowed to allocate slot buffers
+		assert(slot.reallocated || get_thread_allocations_count() == allocations_before);
+#endif
+	}
 
 	return true;
 }
 
+// called on overlay thread before it takes frames, frames published after it post a new wake up
+void overlay_window::reset_frame_ready_post()
+{
+	frame_ready_posted = false;
+}
+
+void overlay_window::set_pixel_conversion(const overlay_pixel_conversion& conversion)
+{
+	std::lock_guard<std::mutex> lock(frame_access);
+
+	pixel_conversion = conversion;
+	// pixels already in window were converted the old way
+	frames.request_full_frame();
+}
+
+// called on overlay thread when window content was lost
+void overlay_window::request_full_frame()
+{
+	frames.request_full_frame();
+	if (shared_frames)
+	{
+		shared_frames->request_full_frame();
+	}
+}
+
+// called on overlay thread, takes ownership of the ring. nullptr detaches current one
+void overlay_window::set_shared_frames(overlay_shared_frames* new_shared_frames)
+{
+	shared_frames.reset(new_shared_frames);
+	if (shared_frames)
+	{
+		shared_frames->request_full_frame();
+	}
+}
+
+bool overlay_window::has_shared_frames()
+{
+	return shared_frames != nullptr;
+}
+
+// called on overlay thread, uploads newest frame from shared memory ring right from the mapping
+void overlay_window::update_shared_content()
+{
+	shared_frame_view frame;
+	if (!shared_frames || !shared_frames->read_begin(frame))
+	{
+		return;
+	}
+	// writer of shared frames does not stamp them, only overlay thread stages are known
+	overlay_frame_times times;
+	times.taken = get_precise_time_us();
+
+	const RECT overlay_rect = get_rect();
+	if (frame.width != overlay_rect.right - overlay_rect.left || frame.height != overlay_rect.bottom - overlay_rect.top)
+	{
+		record_flight_event(overlay_flight_event::frame_dropped, id, frame.width, frame.height);
+		overlay_stats::add(stats.frames_dropped_size);
+		log_debug << "APP: update_shared_content drops frame " << frame.width << "x" << frame.height << " for overlay " << id << std::endl;
+		shared_frames->read_end(frame);
+		return;
+	}
+
+	overlay_dirty_rects dirty_rects;
+	if (frame.whole)
+	{
+		dirty_rects.set_whole(frame.width, frame.height);
+	} else
+	{
+		for (uint32_t i = 0; i < frame.rect_count; i++)
+		{
+			dirty_rects.add(overlay_pixel_rect {frame.rects[i].left, frame.rects[i].top, frame.rects[i].right, frame.rects[i].bottom});
+		}
+		dirty_rects.clip(frame.width, frame.height);
+	}
+
+	const bool applied = apply_image_from_buffer(frame.pixels, static_cast<size_t>(frame.width) * frame.height * 4, frame.width, frame.height, dirty_rects);
+	// pixels can't be read after read_end, so coverage is found in scratch and used only if frame was not torn
+	shared_coverage = display_coverage;
+	shared_coverage.update(frame.pixels, static_cast<size_t>(frame.width) * 4, frame.width, frame.height, dirty_rects);
+	// writer reused the slot while it was uploaded, newer frame will be uploaded as whole
+	if (!shared_frames->read_end(frame))
+	{
+		return;
+	}
+	display_coverage.swap(shared_coverage);
+
+	if (applied && !repaint_whole)
+	{
+		for (const overlay_pixel_rect& dirty : dirty_rects)
+		{
+			const RECT dirty_rect = {dirty.left, dirty.top, dirty.right, dirty.bottom};
+			InvalidateRect(overlay_hwnd, &dirty_rect, TRUE);
+		}
+	}
+	reset_autohide();
+	record_flight_event(overlay_flight_event::frame_applied, id, frame.width, frame.height);
+	overlay_stats::add(stats.frames_applied);
+	overlay_stats::add(stats.bytes_uploaded, dirty_rects.get_area() * 4);
+
+	times.applied = get_precise_time_us();
+	record_frame_latency(overlay_frame_stage::upload, times.taken, times.applied);
+	unpainted_frame = times;
+}
+
+void overlay_window::record_frame_latency(overlay_frame_stage stage, uint64_t from, uint64_t to)
+{
+	if (from != 0 && to >= from)
+	{
+		frame_latency[static_cast<int>(stage)].record(to - from);
+	}
+}
+
+// called on overlay thread after WM_PAINT painted window
+void overlay_window::on_frame_painted()
+{
+	overlay_stats::add(stats.paint_calls);
+
+	if (unpainted_frame.applied == 0)
+	{
+		return;
+	}
+
+	const uint64_t painted = get_precise_time_us();
+	record_frame_latency(overlay_frame_stage::present, unpainted_frame.applied, painted);
+	record_frame_latency(overlay_frame_stage::total, unpainted_frame.received, painted);
+	unpainted_frame = overlay_frame_times();
+}
+
+const overlay_latency_histogram& overlay_window::get_frame_latency(overlay_frame_stage stage)
+{
+	return frame_latency[static_cast<int>(stage)];
+}
+
+overlay_stats& overlay_window::get_stats()
+{
+	return stats;
+}
+
+size_t overlay_window::get_frame_buffers_bytes()
+{
+	return frames.get_allocated_bytes();
+}
+
+const char* get_frame_stage_name(overlay_frame_stage stage)
+{
+	switch (stage)
+	{
+	case overlay_frame_stage::copy:
+		return "copy";
+	case overlay_frame_stage::wake:
+		return "wake";
+	case overlay_frame_stage::upload:
+		return "upload";
+	case overlay_frame_stage::present:
+		return "present";
+	case overlay_frame_stage::total:
+		return "total";
+	default:
+		return "unknown";
+	}
+}
+
+// called on overlay thread, low-level mouse hook runs there too
+const overlay_alpha_coverage* overlay_window::get_alpha_coverage()
+{
+	return &display_coverage;
+}
+
+uint64_t overlay_window::get_duplicate_frames_skipped()
+{
+	return duplicate_frames_skipped.load(std::memory_order_relaxed);
+}
+
 bool overlay_window::reset_autohide() 
 {
 	if (autohidden)
@@ -319,30 +949,41 @@ bool overlay_window::reset_autohide()
 		}
 
 		autohidden = false;
+		overlay_stats::add(stats.autohide_transitions);
 	}
 	return true;
 }
-bool overlay_window_gdi::apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height)
+bool overlay_window_gdi::apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects)
 {
-	log_debug << "APP: Saving image from electron array_size = " << array_size << ", w " << width << ", h " << height << std::endl;
+	log_debug << "APP: Saving image from electron array_size = " << array_size << ", w " << width << ", h " << height << ", rects " << dirty_rects.size() << std::endl;
 	bool ret = true;
 	if (hbmp != nullptr)
 	{
-		LONG workedout = 0;
-
 		BITMAPINFO phmi;
 		phmi.bmiHeader.biSize = sizeof(phmi.bmiHeader);
 		phmi.bmiHeader.biWidth = width;
-		phmi.bmiHeader.biHeight = -height;
 		phmi.bmiHeader.biPlanes = 1;
 		phmi.bmiHeader.biBitCount = 32;
 		phmi.bmiHeader.biCompression = BI_RGB;
-		workedout = SetDIBitsToDevice(hdc, 0, 0, width, height, 0, 0, 0, height, image_array, &phmi, false);
-		if (workedout != height)
+
+		for (const overlay_pixel_rect& dirty : dirty_rects)
 		{
-			log_error << "APP: Saving image from electron with SetDIBitsToDevice failed with workedout = " << workedout << std::endl;
-			ret = false;
-		} else
+			const int dirty_width = dirty.right - dirty.left;
+			const int dirty_height = dirty.bottom - dirty.top;
+			// top-down dib that starts at first dirty row, columns are selected by xSrc
+			const BYTE* dirty_rows = static_cast<const BYTE*>(image_array) + static_cast<size_t>(dirty.top) * width * 4;
+			phmi.bmiHeader.biHeight = -dirty_height;
+
+			LONG workedout = SetDIBitsToDevice(hdc, dirty.left, dirty.top, dirty_width, dirty_height, dirty.left, 0, 0, dirty_height, dirty_rows, &phmi, false);
+			if (workedout != dirty_height)
+			{
+				log_error << "APP: Saving image from electron with SetDIBitsToDevice failed with workedout = " << workedout << std::endl;
+				ret = false;
+				break;
+			}
+		}
+
+		if (ret)
 		{
 			content_set = true;
 		}
@@ -354,15 +995,19 @@ bool overlay_window_gdi::apply_image_from_buffer(const void* image_array, size_t
 	return ret;
 }
 
-bool overlay_window_direct2d::apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height)
+bool overlay_window_direct2d::apply_image_from_buffer(const void* image_array, size_t array_size, int width, int height, const overlay_dirty_rects& dirty_rects)
 {
-	log_debug << "APP: Saving image from electron array_size = " << array_size << ", w " << width << ", h " << height << std::endl;
+	log_debug << "APP: Saving image from electron array_size = " << array_size << ", w " << width << ", h " << height << ", rects " << dirty_rects.size() << std::endl;
 	bool ret = true;
 
 	if (m_pBitmap != nullptr)
 	{
-		D2D1_RECT_U bits_size = {0, 0, (uint32_t)width, (uint32_t)height};
-		m_pBitmap->CopyFromMemory(&bits_size, image_array, width * 4);
+		for (const overlay_pixel_rect& dirty : dirty_rects)
+		{
+			D2D1_RECT_U bits_rect = {(uint32_t)dirty.left, (uint32_t)dirty.top, (uint32_t)dirty.right, (uint32_t)dirty.bottom};
+			const BYTE* dirty_bits = static_cast<const BYTE*>(image_array) + (static_cast<size_t>(dirty.top) * width + dirty.left) * 4;
+			m_pBitmap->CopyFromMemory(&bits_rect, dirty_bits, width * 4);
+		}
 		content_set = true;
 	}
 
@@ -382,7 +1027,7 @@ void overlay_window_direct2d::create_render_target(ID2D1Factory* m_pDirect2dFact
 		// Create a Direct2D render target.
 		hr = m_pDirect2dFactory->CreateHwndRenderTarget(
 		    D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_DEFAULT, D2D1::PixelFormat(DXGI_FORMAT_UNKNOWN, D2D1_ALPHA_MODE_PREMULTIPLIED)),
-		    D2D1::HwndRenderTargetProperties(overlay_hwnd, size),
+		    D2D1::HwndRenderTargetProperties(overlay_hwnd, size, D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS),
 		    &m_pRenderTarget);
 	}
 }
@@ -456,9 +1101,7 @@ void overlay_window_gdi::paint_to_window(HDC window_hdc)
 
 	ValidateRect(overlay_hwnd, &rect);
 
-	last_content_chage_ticks = GetTickCount64();
-
-	content_updated = false;
+	last_content_chage_ticks = clock->now();
 }
 
 void overlay_window_direct2d::paint_to_window(HDC window_hdc)
@@ -480,14 +1123,21 @@ void overlay_window_direct2d::paint_to_window(HDC window_hdc)
 		int width = static_cast<int>(rtSize.width);
 		int height = static_cast<int>(rtSize.height);
 
+		// target keeps its contents between presents so only invalidated part is redrawn
+		float dpi_x, dpi_y;
+		m_pRenderTarget->GetDpi(&dpi_x, &dpi_y);
+		const D2D1_RECT_F paint_rect = D2D1::RectF(
+		    ps.rcPaint.left * 96.0f / dpi_x, ps.rcPaint.top * 96.0f / dpi_y, ps.rcPaint.right * 96.0f / dpi_x, ps.rcPaint.bottom * 96.0f / dpi_y);
+		m_pRenderTarget->PushAxisAlignedClip(paint_rect, D2D1_ANTIALIAS_MODE_ALIASED);
+
+		m_pRenderTarget->Clear(D2D1::ColorF(0.0f, 0.0f));
 		if (m_pBitmap != nullptr && content_set)
 		{
 			m_pRenderTarget->DrawBitmap(m_pBitmap, D2D1::RectF(0, 0, width, height), 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, nullptr);
-		} else
-		{
-			m_pRenderTarget->Clear(D2D1::ColorF(0.0f, 0.0f));
 		}
 
+		m_pRenderTarget->PopAxisAlignedClip();
+
 		hr = m_pRenderTarget->EndDraw();
 	}
 
@@ -495,9 +1145,7 @@ void overlay_window_direct2d::paint_to_window(HDC window_hdc)
 
 	ValidateRect(overlay_hwnd, &rect);
 
-	last_content_chage_ticks = GetTickCount64();
-
-	content_updated = false;
+	last_content_chage_ticks = clock->now();
 }
 
 bool overlay_window::apply_size_from_orig()
@@ -520,7 +1168,9 @@ bool overlay_window::create_window()
 		//| 0x20000000;
 		// transparent, topmost, with no taskbar
 
-		overlay_hwnd = CreateWindowEx(dwStyleEx, g_szWindowClass, NULL, dwStyle, 0, 0, 0, 0, NULL, NULL, GetModuleHandle(NULL), NULL);
+		// id lets WndProc bind window to overlay before first messages of the window
+		overlay_hwnd = CreateWindowEx(
+		    dwStyleEx, g_szWindowClass, NULL, dwStyle, 0, 0, 0, 0, NULL, NULL, GetModuleHandle(NULL), reinterpret_cast<LPVOID>(static_cast<INT_PTR>(id)));
 
 		if (overlay_hwnd)
 		{
@@ -575,12 +1225,14 @@ bool overlay_window_gdi::create_window_content_buffer()
 			hdc = new_hdc;
 			hbmp = new_hbmp;
 			created = true;
+			stats.content_buffer_bytes.store(static_cast<uint64_t>(new_width) * new_height * 4, std::memory_order_relaxed);
 		}
 	} else
 	{
 		log_error << "APP: create_window_content_buffer failed to get rect from orig window " << GetLastError() << std::endl;
 	}
 	content_set = false;
+	request_full_frame();
 
 	ReleaseDC(nullptr, hdcScreen);
 
@@ -619,10 +1271,15 @@ bool overlay_window_direct2d::create_window_content_buffer()
 		if (SUCCEEDED(hr))
 		{
 			created = true;
+			stats.content_buffer_bytes.store(static_cast<uint64_t>(new_width) * new_height * 4, std::memory_order_relaxed);
+		} else
+		{
+			stats.content_buffer_bytes.store(0, std::memory_order_relaxed);
 		}
 	}
 
 	content_set = false;
+	request_full_frame();
 
 	return created;
 }
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include "sl_overlay_window.h"
 #include "sl_overlays_settings.h"
 
+#include "overlay_flight_recorder.h"
 #include "overlay_logging.h"
 #include "sl_overlay_api.h"
 
@@ -55,6 +56,7 @@ bool smg_overlays::process_commands(MSG& msg)
 
 		showup_overlays();
 		showing_overlays = true;
+		reschedule_overlays();
 		ret = true;
 	}
 	break;
@@ -63,6 +65,7 @@ bool smg_overlays::process_commands(MSG& msg)
 		showing_overlays = false;
 
 		hide_overlays();
+		reschedule_overlays();
 		ret = true;
 	}
 	break;
@@ -101,6 +104,7 @@ bool smg_overlays::process_commands(MSG& msg)
 		unhook_user_input();
 
 		apply_interactive_mode_view();
+		reschedule_overlays();
 	}
 	break;
 	};
@@ -144,7 +148,13 @@ int smg_overlays::create_overlay_window_by_hwnd(HWND hwnd)
 
 	{
 		std::unique_lock<std::shared_mutex> lock(overlays_list_access);
-		showing_windows.push_back(new_overlay_window);
+		const int overlay_id = showing_windows.add(new_overlay_window);
+		if (overlay_id < 0)
+		{
+			log_error << "APP: no free overlay slots" << std::endl;
+			return -1;
+		}
+		new_overlay_window->id = overlay_id;
 	}
 
 	PostThreadMessage(
@@ -156,30 +166,161 @@ int smg_overlays::create_overlay_window_by_hwnd(HWND hwnd)
 	return new_overlay_window->id;
 }
 
-void smg_overlays::on_update_timer()
+const uint64_t producer_signal_interval = 1000;
+
+// posted by producer thread after it published a frame. frames coming during coalesce timeout are uploaded together
+void smg_overlays::on_frame_ready(int overlay_id)
 {
-	if (showing_overlays)
+	std::shared_ptr<overlay_window> overlay = get_overlay_by_id(overlay_id);
+	if (overlay == nullptr)
 	{
-		std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-		std::for_each(
-		    showing_windows.begin(),
-		    showing_windows.end(),
-		    [is_intercepting = this->is_intercepting](std::shared_ptr<overlay_window>& n) {
-			    if (n->is_visible())
-			    {
-				    if (n->is_content_updated())
-				    {
-					    InvalidateRect(n->overlay_hwnd, nullptr, TRUE);
-				    } else
-				    {
-					    if (!is_intercepting)
-					    {
-						    n->check_autohide();
-					    }
-				    }
-			    }
-		    });
+		return;
+	}
+
+	overlay->reset_frame_ready_post();
+	if (!deadlines.is_scheduled(overlay->id, overlay_deadline_kind::frame_update))
+	{
+		deadlines.schedule(overlay->id, overlay_deadline_kind::frame_update, deadlines.now() + app_settings->frame_coalesce_timeout);
+	}
+}
+
+// posted by producer thread when frame rate limit held a frame, it is published when limit allows it
+void smg_overlays::on_frame_held(int overlay_id)
+{
+	std::shared_ptr<overlay_window> overlay = get_overlay_by_id(overlay_id);
+	if (overlay == nullptr)
+	{
+		return;
+	}
+
+	overlay->reset_frame_held_post();
+	schedule_held_frame(overlay);
+}
+
+void smg_overlays::schedule_held_frame(std::shared_ptr<overlay_window>& overlay)
+{
+	const int delay = overlay->get_held_frame_delay();
+	if (delay >= 0)
+	{
+		deadlines.schedule(overlay->id, overlay_deadline_kind::held_frame, deadlines.now() + delay);
+	}
+}
+
+// called when something changed what overlay has to do: it was shown, got new settings or new source of frames
+void smg_overlays::reschedule_overlay(std::shared_ptr<overlay_window>& overlay)
+{
+	const uint64_t now = deadlines.now();
+	if (overlay->is_content_updated())
+	{
+		deadlines.schedule(overlay->id, overlay_deadline_kind::frame_update, now);
+	}
+	if (overlay->has_shared_frames())
+	{
+		deadlines.schedule(overlay->id, overlay_deadline_kind::shared_frames, now);
+	}
+	deadlines.schedule(overlay->id, overlay_deadline_kind::producer_signal, now);
+	schedule_autohide(overlay);
+}
+
+void smg_overlays::copy_overlays(std::vector<std::shared_ptr<overlay_window>>& to)
+{
+	std::shared_lock<std::shared_mutex> lock(overlays_list_access);
+	to.assign(showing_windows.begin(), showing_windows.end());
+}
+
+void smg_overlays::reschedule_overlays()
+{
+	std::vector<std::shared_ptr<overlay_window>> overlays;
+	copy_overlays(overlays);
+
+	std::for_each(overlays.begin(), overlays.end(), [this](std::shared_ptr<overlay_window>& n) { reschedule_overlay(n); });
+}
+
+// autohide is checked only while overlay can be seen, it gets scheduled again when overlay is shown or input is released
+void smg_overlays::schedule_autohide(std::shared_ptr<overlay_window>& overlay)
+{
+	const uint64_t autohide_at = overlay->get_autohide_deadline();
+	if (autohide_at != 0 && showing_overlays && overlay->is_visible() && !is_intercepting)
+	{
+		deadlines.schedule(overlay->id, overlay_deadline_kind::autohide, autohide_at);
+	}
+}
+
+void smg_overlays::on_deadline(std::shared_ptr<overlay_window>& overlay, overlay_deadline_kind kind, uint64_t now)
+{
+	const bool can_be_seen = showing_overlays && overlay->is_visible();
+
+	switch (kind)
+	{
+	case overlay_deadline_kind::frame_update:
+		// frames of hidden overlay stay in mailbox and are uploaded when it is shown
+		if (can_be_seen && overlay->is_content_updated())
+		{
+			overlay->update_content();
+			schedule_autohide(overlay);
+		}
+		break;
+	case overlay_deadline_kind::shared_frames:
+		if (overlay->has_shared_frames())
+		{
+			if (can_be_seen)
+			{
+				overlay->update_shared_content();
+				schedule_autohide(overlay);
+			}
+			deadlines.schedule(overlay->id, overlay_deadline_kind::shared_frames, now + app_settings->shared_frames_poll_timeout);
+		}
+		break;
+	case overlay_deadline_kind::autohide:
+		if (can_be_seen && !is_intercepting && !overlay->is_content_updated())
+		{
+			overlay->check_autohide(now);
+		}
+		schedule_autohide(overlay);
+		break;
+	case overlay_deadline_kind::producer_signal:
+		overlay->check_producer_signal(showing_overlays);
+		deadlines.schedule(overlay->id, overlay_deadline_kind::producer_signal, now + producer_signal_interval);
+		break;
+	case overlay_deadline_kind::held_frame:
+		// coarse clock can wake a little before frame time
+		if (!overlay->publish_held_frame())
+		{
+			schedule_held_frame(overlay);
+		} else if (overlay->is_content_updated())
+		{
+			deadlines.schedule(overlay->id, overlay_deadline_kind::frame_update, now);
+		}
+		break;
+	}
+}
+
+// expired deadlines are taken first so deadlines scheduled by handlers for now run on next pass
+void smg_overlays::on_deadlines()
+{
+	overlay_deadline deadline;
+	while (deadlines.pop_expired(deadline))
+	{
+		due_deadlines.push_back(deadline);
+	}
+
+	const uint64_t now = deadlines.now();
+	for (const overlay_deadline& due : due_deadlines)
+	{
+		std::shared_ptr<overlay_window> overlay = get_overlay_by_id(due.overlay_id);
+		if (overlay != nullptr)
+		{
+			on_deadline(overlay, due.kind, now);
+		}
 	}
+	due_deadlines.clear();
+}
+
+static_assert(overlay_deadlines::no_timeout == INFINITE, "deadlines timeout is passed to windows waits");
+
+DWORD smg_overlays::get_wait_timeout()
+{
+	return deadlines.get_timeout();
 }
 
 void smg_overlays::deinit()
@@ -194,23 +335,25 @@ void smg_overlays::deinit()
 void smg_overlays::showup_overlays()
 {
 	log_info << "APP: showup_overlays " << std::endl;
-	{
-		std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-		std::for_each(showing_windows.begin(), showing_windows.end(), [](std::shared_ptr<overlay_window>& n) {
-			if (n->overlay_hwnd != 0 && n->is_visible())
-			{
-				ShowWindow(n->overlay_hwnd, SW_SHOW);
-				n->reset_autohide_timer();
-			}
-		});
-	}
+	std::vector<std::shared_ptr<overlay_window>> overlays;
+	copy_overlays(overlays);
+
+	std::for_each(overlays.begin(), overlays.end(), [](std::shared_ptr<overlay_window>& n) {
+		if (n->overlay_hwnd != 0 && n->is_visible())
+		{
+			ShowWindow(n->overlay_hwnd, SW_SHOW);
+			n->reset_autohide_timer();
+		}
+	});
 }
 
 void smg_overlays::hide_overlays()
 {
 	log_info << "APP: hide_overlays " << std::endl;
-	std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-	std::for_each(showing_windows.begin(), showing_windows.end(), [](std::shared_ptr<overlay_window>& n) {
+	std::vector<std::shared_ptr<overlay_window>> overlays;
+	copy_overlays(overlays);
+
+	std::for_each(overlays.begin(), overlays.end(), [](std::shared_ptr<overlay_window>& n) {
 		if (n->overlay_hwnd != 0)
 		{
 			ShowWindow(n->overlay_hwnd, SW_HIDE);
@@ -221,15 +364,12 @@ void smg_overlays::hide_overlays()
 void smg_overlays::apply_interactive_mode_view()
 {
 	log_info << "APP: apply_interactive_mode_view " << std::endl;
-	{
-		std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-		std::for_each(
-		    showing_windows.begin(),
-		    showing_windows.end(),
-		    [is_intercepting = this->is_intercepting](std::shared_ptr<overlay_window>& n) {
-			    n->apply_interactive_mode(is_intercepting);
-		    });
-	}
+	std::vector<std::shared_ptr<overlay_window>> overlays;
+	copy_overlays(overlays);
+
+	std::for_each(overlays.begin(), overlays.end(), [is_intercepting = this->is_intercepting](std::shared_ptr<overlay_window>& n) {
+		n->apply_interactive_mode(is_intercepting);
+	});
 }
 
 void smg_overlays::create_overlay_window_class()
@@ -245,24 +385,94 @@ void smg_overlays::create_overlay_window_class()
 	RegisterClassEx(&wcex);
 }
 
-bool smg_overlays::is_inside_overlay(int x, int y)
+// false if window is not one of hit_overlays
+bool smg_overlays::add_hit_rect(HWND window)
 {
-	bool ret = false;
-	std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-	std::for_each(showing_windows.begin(), showing_windows.end(), [&ret, &x, &y](std::shared_ptr<overlay_window>& n) {
-		RECT o_rect = n->get_rect();
-		if (n->is_visible())
+	auto found = std::find_if(hit_overlays.begin(), hit_overlays.end(), [window](std::shared_ptr<overlay_window>& n) { return n->overlay_hwnd == window; });
+	if (found == hit_overlays.end())
+	{
+		return false;
+	}
+
+	std::shared_ptr<overlay_window>& overlay = *found;
+	if (overlay->is_visible() && IsWindowVisible(window))
+	{
+		RECT window_rect;
+		if (GetWindowRect(window, &window_rect))
 		{
-			if (x <= o_rect.right && x >= o_rect.left)
+			const overlay_pixel_rect rect = {window_rect.left, window_rect.top, window_rect.right, window_rect.bottom};
+			hit_rects.push_back(overlay_hit_rect {overlay->id, rect, overlay->get_alpha_coverage()});
+		}
+	}
+	return true;
+}
+
+// called from WndProc when overlay windows move, resize, change z-order, show or hide. WndProc can run inside
+// windows calls made while overlays list is locked, so index is built later by update_hit_index
+void smg_overlays::invalidate_hit_index()
+{
+	hit_index_dirty = true;
+}
+
+// called on overlay thread after messages are handled, without locks. Overlays are topmost windows, so instead
+// of walking all windows of the desktop z-order is walked from first overlay up to the top and then down until
+// every overlay is found. Rects are collected topmost first
+void smg_overlays::update_hit_index()
+{
+	if (!hit_index_dirty)
+	{
+		return;
+	}
+	hit_index_dirty = false;
+
+	hit_overlays.clear();
+	{
+		std::shared_lock<std::shared_mutex> lock(overlays_list_access);
+		std::for_each(showing_windows.begin(), showing_windows.end(), [this](std::shared_ptr<overlay_window>& n) {
+			if (n->overlay_hwnd != 0)
 			{
-				if (y <= o_rect.bottom && y >= o_rect.top)
-				{
-					ret = true;
-				}
+				hit_overlays.push_back(n);
 			}
+		});
+	}
+
+	hit_rects.clear();
+	if (!hit_overlays.empty())
+	{
+		const HWND first = hit_overlays.front()->overlay_hwnd;
+		size_t found = 1;
+		for (HWND window = GetWindow(first, GW_HWNDPREV); window != nullptr && found < hit_overlays.size(); window = GetWindow(window, GW_HWNDPREV))
+		{
+			found += add_hit_rect(window) ? 1 : 0;
 		}
-	});
-	return ret;
+		// windows above first one were collected going up
+		std::reverse(hit_rects.begin(), hit_rects.end());
+
+		add_hit_rect(first);
+		for (HWND window = GetWindow(first, GW_HWNDNEXT); window != nullptr && found < hit_overlays.size(); window = GetWindow(window, GW_HWNDNEXT))
+		{
+			found += add_hit_rect(window) ? 1 : 0;
+		}
+	}
+	hit_overlays.clear();
+
+	if (hit_rects.size() > overlay_hit_index::max_rects)
+	{
+		log_error << "APP: update_hit_index too many visible overlays " << hit_rects.size() << std::endl;
+	}
+	hit_index.publish(hit_rects);
+}
+
+// called from low-level mouse hook. finds topmost overlay under point without locks
+bool smg_overlays::hit_test_overlays(int x, int y, overlay_hit& hit)
+{
+	return hit_index.hit_test(x, y, hit);
+}
+
+bool smg_overlays::is_inside_overlay(int x, int y)
+{
+	overlay_hit hit;
+	return hit_test_overlays(x, y, hit);
 }
 
 void smg_overlays::create_window_for_overlay(std::shared_ptr<overlay_window>& overlay)
@@ -276,6 +486,7 @@ void smg_overlays::create_window_for_overlay(std::shared_ptr<overlay_window>& ov
 		{
 			ShowWindow(overlay->overlay_hwnd, SW_HIDE);
 		}
+		reschedule_overlay(overlay);
 	} 
 }
 
@@ -296,6 +507,7 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 	{
 		KBDLLHOOKSTRUCT* event = (KBDLLHOOKSTRUCT*)lParam;
 		log_info << "APP: LowLevelKeyboardProc " << event->vkCode << ", " << event->dwExtraInfo << std::endl;
+		record_flight_event(overlay_flight_event::hook_event, 0, static_cast<int>(wParam), static_cast<int>(event->vkCode));
 
 		if (event->vkCode == VK_ESCAPE)
 		{
@@ -318,9 +530,13 @@ LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 		         << event->dwExtraInfo << std::endl;
 
 		std::shared_ptr<smg_overlays> app = smg_overlays::get_instance();
-		if (app->is_inside_overlay(event->pt.x, event->pt.y))
+		overlay_mouse_input input;
+		const bool inside = app->hit_test_overlays(event->pt.x, event->pt.y, input.hit);
+		record_flight_event(overlay_flight_event::hook_event, inside ? input.hit.overlay_id : 0, static_cast<int>(wParam), event->pt.x);
+		if (inside)
 		{
-			use_callback_for_mouse_input(wParam, lParam);
+			input.hook = *event;
+			use_callback_for_mouse_input(wParam, reinterpret_cast<LPARAM>(&input));
 		} else
 		{
 			if (wParam != WM_MOUSEMOVE && wParam != WM_MOUSEWHEEL && wParam != WM_MOUSEHWHEEL)
@@ -358,6 +574,7 @@ void smg_overlays::hook_user_input()
 		llmouse_hook = SetWindowsHookEx(WH_MOUSE_LL, LowLevelMouseProc, NULL, 0);
 
 		is_intercepting = true;
+		record_flight_event(overlay_flight_event::input_switched, 0, 1);
 
 		log_info << "APP: Input hooked" << std::endl;
 	}
@@ -386,6 +603,7 @@ void smg_overlays::unhook_user_input()
 
 		log_info << "APP: Input unhooked" << std::endl;
 		is_intercepting = false;
+		record_flight_event(overlay_flight_event::input_switched, 0, 0);
 	}
 }
 
@@ -397,38 +615,26 @@ size_t smg_overlays::get_count()
 
 std::shared_ptr<overlay_window> smg_overlays::get_overlay_by_id(int overlay_id)
 {
-	std::shared_ptr<overlay_window> ret;
 	std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-
-	std::list<std::shared_ptr<overlay_window>>::iterator findIter =
-	    std::find_if(showing_windows.begin(), showing_windows.end(), [&overlay_id](std::shared_ptr<overlay_window>& n) {
-		    return overlay_id == n->id;
-	    });
-
-	if (findIter != showing_windows.end())
-	{
-		ret = *findIter;
-	}
-
-	return ret;
+	return showing_windows.find(overlay_id);
 }
 
 std::shared_ptr<overlay_window> smg_overlays::get_overlay_by_window(HWND overlay_hwnd)
 {
-	std::shared_ptr<overlay_window> ret;
 	std::shared_lock<std::shared_mutex> lock(overlays_list_access);
+	return showing_windows.find_by_window(overlay_hwnd);
+}
 
-	std::list<std::shared_ptr<overlay_window>>::iterator findIter =
-	    std::find_if(showing_windows.begin(), showing_windows.end(), [&overlay_hwnd](std::shared_ptr<overlay_window>& n) {
-		    return overlay_hwnd == n->overlay_hwnd;
-	    });
+// called from WndProc on WM_NCCREATE, before any other message of the window needs to find its overlay
+void smg_overlays::on_window_create(HWND window, int overlay_id)
+{
+	record_flight_event(overlay_flight_event::window_created, overlay_id);
 
-	if (findIter != showing_windows.end())
+	std::unique_lock<std::shared_mutex> lock(overlays_list_access);
+	if (!showing_windows.bind_window(overlay_id, window))
 	{
-		ret = *findIter;
+		log_error << "APP: on_window_create overlay not found " << overlay_id << std::endl;
 	}
-
-	return ret;
 }
 
 bool smg_overlays::remove_overlay(std::shared_ptr<overlay_window> overlay)
@@ -460,8 +666,12 @@ bool smg_overlays::on_overlay_destroy(std::shared_ptr<overlay_window> overlay)
 		if (overlay->status == overlay_status::destroing)
 		{
 			std::unique_lock<std::shared_mutex> lock(overlays_list_access);
-			showing_windows.remove_if([&overlay](std::shared_ptr<overlay_window>& n) { return (overlay->id == n->id); });
+			showing_windows.remove(overlay->id);
+			deadlines.cancel(overlay->id);
 			removed = true;
+			record_flight_event(overlay_flight_event::window_destroyed, overlay->id);
+			lock.unlock();
+			invalidate_hit_index();
 		}
 	}
 
@@ -501,6 +711,7 @@ smg_overlays::smg_overlays()
 {
 	showing_overlays = false;
 	quiting = false;
+	hit_index_dirty = false;
 
 	log_info << "APP: start overlays " << std::endl;
 }
@@ -540,14 +751,11 @@ void smg_overlays::init()
 
 void smg_overlays::draw_overlay(HWND& hWnd)
 {
+	std::shared_ptr<overlay_window> overlay = get_overlay_by_window(hWnd);
+	if (overlay != nullptr)
 	{
-		std::shared_lock<std::shared_mutex> lock(overlays_list_access);
-		std::for_each(showing_windows.begin(), showing_windows.end(), [&hWnd](std::shared_ptr<overlay_window>& n) {
-			if (hWnd == n->overlay_hwnd)
-			{
-				n->paint_to_window(0);
-			}
-		});
+		overlay->paint_to_window(0);
+		overlay->on_frame_painted();
 	}
 }
 
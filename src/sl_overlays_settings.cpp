@@ -26,5 +26,7 @@ smg_settings::smg_settings() : settings_version(0x0002)
 {
 	transparency = 0xD0;
 	use_color_key = false;
-	redraw_timeout = 300;
+	frame_coalesce_timeout = 0;
+	shared_frames_poll_timeout = 16;
+	detect_frame_damage = true;
 }
\ No newline at end of file
@@ -14,150 +14,234 @@
 
 #include "user_input_callback.h"
 #include <errno.h>
+#include <array>
 #include <iostream>
-#include <map>
+#include <string.h>
 #include "overlay_logging.h"
 
 callback_keyboard_method_t* user_keyboard_callback_info = nullptr;
 callback_mouse_method_t* user_mouse_callback_info = nullptr;
 
-const std::string& translate_to_electron_keycode(const int id)
+struct electron_key_name
 {
-	static std::map<int, std::string> CodeToKeyCodes = {
-	    {1, "LButton"},
-	    {2, "RButton"},
-	    {4, "MButton"},
-	    {5, "XButotn1"},
-	    {6, "XButotn2"},
-	    {8, "Backspace"},
-	    {9, "Tab"},
-	    {13, "Enter"},
-	    {16, "Shift"},
-	    {17, "Ctrl"},
-	    {18, "Alt"},
-	    {19, "Pause"},
-	    {20, "CapsLock"},
-	    {27, "Escape"},
-	    {32, " "},
-	    {33, "PageUp"},
-	    {34, "PageDown"},
-	    {35, "End"},
-	    {36, "Home"},
-	    {37, "Left"},
-	    {38, "Up"},
-	    {39, "Right"},
-	    {40, "Down"},
-	    {45, "Insert"},
-	    {46, "Delete"},
-	    {48, "0"},
-	    {49, "1"},
-	    {50, "2"},
-	    {51, "3"},
-	    {52, "4"},
-	    {53, "5"},
-	    {54, "6"},
-	    {55, "7"},
-	    {56, "8"},
-	    {57, "9"},
-	    {65, "A"},
-	    {66, "B"},
-	    {67, "C"},
-	    {68, "D"},
-	    {69, "E"},
-	    {70, "F"},
-	    {71, "G"},
-	    {72, "H"},
-	    {73, "I"},
-	    {74, "J"},
-	    {75, "K"},
-	    {76, "L"},
-	    {77, "M"},
-	    {78, "N"},
-	    {79, "O"},
-	    {80, "P"},
-	    {81, "Q"},
-	    {82, "R"},
-	    {83, "S"},
-	    {84, "T"},
-	    {85, "U"},
-	    {86, "V"},
-	    {87, "W"},
-	    {88, "X"},
-	    {89, "Y"},
-	    {90, "Z"},
-	    {91, "Meta"},
-	    {92, "Meta"},
-	    {93, "ContextMenu"},
-	    {96, "0"},
-	    {97, "1"},
-	    {98, "2"},
-	    {99, "3"},
-	    {100, "4"},
-	    {101, "5"},
-	    {102, "6"},
-	    {103, "7"},
-	    {104, "8"},
-	    {105, "9"},
-	    {106, "*"},
-	    {107, "+"},
-	    {109, "-"},
-	    {110, "."},
-	    {111, "/"},
-	    {112, "F1"},
-	    {113, "F2"},
-	    {114, "F3"},
-	    {115, "F4"},
-	    {116, "F5"},
-	    {117, "F6"},
-	    {118, "F7"},
-	    {119, "F8"},
-	    {120, "F9"},
-	    {121, "F10"},
-	    {122, "F11"},
-	    {123, "F12"},
-	    {144, "NumLock"},
-	    {145, "ScrollLock"},
-	    {160, "Shift"},
-	    {161, "Shift"},
-	    {162, "Control"},
-	    {163, "Control"},
-	    {164, "Alt"},
-	    {165, "Alt"},
-	    {182, "My Computer"},
-	    {183, "My Calculator"},
-	    {186, ";"},
-	    {187, "="},
-	    {188, "},"},
-	    {189, "-"},
-	    {190, "."},
-	    {191, "/"},
-	    {192, "`"},
-	    {219, "["},
-	    {220, "\\"},
-	    {221, "]"},
-	    {222, "'"},
-	    {250, "Play"},
-	};
+	int code;
+	const char* name;
+};
 
-	return CodeToKeyCodes[id];
-}
+static constexpr electron_key_name electron_key_names[] = {
+	{1, "LButton"},
+	{2, "RButton"},
+	{4, "MButton"},
+	{5, "XButotn1"},
+	{6, "XButotn2"},
+	{8, "Backspace"},
+	{9, "Tab"},
+	{13, "Enter"},
+	{16, "Shift"},
+	{17, "Ctrl"},
+	{18, "Alt"},
+	{19, "Pause"},
+	{20, "CapsLock"},
+	{27, "Escape"},
+	{32, " "},
+	{33, "PageUp"},
+	{34, "PageDown"},
+	{35, "End"},
+	{36, "Home"},
+	{37, "Left"},
+	{38, "Up"},
+	{39, "Right"},
+	{40, "Down"},
+	{45, "Insert"},
+	{46, "Delete"},
+	{48, "0"},
+	{49, "1"},
+	{50, "2"},
+	{51, "3"},
+	{52, "4"},
+	{53, "5"},
+	{54, "6"},
+	{55, "7"},
+	{56, "8"},
+	{57, "9"},
+	{65, "A"},
+	{66, "B"},
+	{67, "C"},
+	{68, "D"},
+	{69, "E"},
+	{70, "F"},
+	{71, "G"},
+	{72, "H"},
+	{73, "I"},
+	{74, "J"},
+	{75, "K"},
+	{76, "L"},
+	{77, "M"},
+	{78, "N"},
+	{79, "O"},
+	{80, "P"},
+	{81, "Q"},
+	{82, "R"},
+	{83, "S"},
+	{84, "T"},
+	{85, "U"},
+	{86, "V"},
+	{87, "W"},
+	{88, "X"},
+	{89, "Y"},
+	{90, "Z"},
+	{91, "Meta"},
+	{92, "Meta"},
+	{93, "ContextMenu"},
+	{96, "0"},
+	{97, "1"},
+	{98, "2"},
+	{99, "3"},
+	{100, "4"},
+	{101, "5"},
+	{102, "6"},
+	{103, "7"},
+	{104, "8"},
+	{105, "9"},
+	{106, "*"},
+	{107, "+"},
+	{109, "-"},
+	{110, "."},
+	{111, "/"},
+	{112, "F1"},
+	{113, "F2"},
+	{114, "F3"},
+	{115, "F4"},
+	{116, "F5"},
+	{117, "F6"},
+	{118, "F7"},
+	{119, "F8"},
+	{120, "F9"},
+	{121, "F10"},
+	{122, "F11"},
+	{123, "F12"},
+	{144, "NumLock"},
+	{145, "ScrollLock"},
+	{160, "Shift"},
+	{161, "Shift"},
+	{162, "Control"},
+	{163, "Control"},
+	{164, "Alt"},
+	{165, "Alt"},
+	{182, "My Computer"},
+	{183, "My Calculator"},
+	{186, ";"},
+	{187, "="},
+	{188, ","},
+	{189, "-"},
+	{190, "."},
+	{191, "/"},
+	{192, "`"},
+	{219, "["},
+	{220, "\\"},
+	{221, "]"},
+	{222, "'"},
+	{250, "Play"},
+};
+
+static constexpr size_t electron_key_table_size = 256;
 
-struct wm_event_t
+static constexpr std::array<const char*, electron_key_table_size> make_electron_key_table()
 {
-	WPARAM wParam;
-	LPARAM lParam;
+	std::array<const char*, electron_key_table_size> table = {};
+	for (size_t i = 0; i < table.size(); i++)
+	{
+		table[i] = "";
+	}
+	for (const electron_key_name& key : electron_key_names)
+	{
+		table[key.code] = key.name;
+	}
+	return table;
+}
+
+// indexed by virtual key code, empty name for keys electron does not know
+static constexpr std::array<const char*, electron_key_table_size> electron_key_table = make_electron_key_table();
 
-	wm_event_t(WPARAM _wParam, LPARAM _lParam) noexcept : wParam(_wParam), lParam(_lParam) {}
+// indexes in overlay_js_strings cache, key names go first by key code
+enum input_js_string : size_t
+{
+	input_js_string_unknown = electron_key_table_size,
+	input_js_string_key_down,
+	input_js_string_key_up,
+	input_js_string_char,
+	input_js_string_mouse_move,
+	input_js_string_mouse_down,
+	input_js_string_mouse_up,
+	input_js_string_mouse_wheel,
+	input_js_string_no_modifiers,
+	input_js_string_left_button_down,
+	input_js_string_right_button_down,
+	input_js_string_left_button_up,
+	input_js_string_right_button_up,
+	input_js_string_count
 };
 
+static_assert(input_js_string_count <= overlay_js_strings::max_count, "input strings have to fit in cache");
+
+static const char* get_input_js_string_text(input_js_string index)
+{
+	switch (index)
+	{
+	case input_js_string_key_down:
+		return "keyDown";
+	case input_js_string_key_up:
+		return "keyUp";
+	case input_js_string_char:
+		return "char";
+	case input_js_string_mouse_move:
+		return "mouseMove";
+	case input_js_string_mouse_down:
+		return "mouseDown";
+	case input_js_string_mouse_up:
+		return "mouseUp";
+	case input_js_string_mouse_wheel:
+		return "mouseWheel";
+	case input_js_string_no_modifiers:
+		return "";
+	case input_js_string_left_button_down:
+		return "leftButtonDown";
+	case input_js_string_right_button_down:
+		return "rightButtonDown";
+	case input_js_string_left_button_up:
+		return "leftButtonUp";
+	case input_js_string_right_button_up:
+		return "rightButtonUp";
+	default:
+		return "unknown";
+	}
+}
+
+napi_status callback_method_t::get_js_string(napi_env env, input_js_string index, napi_value* result)
+{
+	return js_strings.get(env, index, get_input_js_string_text(index), result);
+}
+
+napi_status callback_method_t::get_js_key_name(napi_env env, int key_code, napi_value* result)
+{
+	if (key_code < 0 || static_cast<size_t>(key_code) >= electron_key_table_size)
+	{
+		return get_js_string(env, input_js_string_no_modifiers, result);
+	}
+	return js_strings.get(env, key_code, electron_key_table[key_code], result);
+}
+
 callback_method_t::callback_method_t()
 {
 	ready = false;
+	batched = false;
+	flush_timer = 0;
 }
 
 callback_method_t ::~callback_method_t()
 {
 	log_debug << "APP: ~callback_method_t" << std::endl;
+	js_strings.release();
 	napi_delete_reference(env_this, js_this);
 	napi_async_destroy(env_this, async_context);
 }
@@ -183,35 +267,60 @@ bool callback_method_t::get_intercept_active() noexcept
 	return is_intercept_active;
 }
 
-napi_status callback_keyboard_method_t::set_callback_args_values(napi_env env)
+// called in keyboard hook, lParam is valid only until hook returns
+overlay_input_event callback_keyboard_method_t::capture_event(WPARAM wParam, LPARAM lParam)
 {
-	log_info << "APP: callback_keyboard_method_t::set_callback_args_values" << std::endl;
-	napi_status status = napi_ok;
+	overlay_input_event event = {static_cast<int32_t>(overlay_input_type::unknown)};
+	event.count = 1;
 
-	std::shared_ptr<wm_event_t> event;
+	switch (wParam)
+	{
+	case WM_KEYDOWN:
+		event.type = static_cast<int32_t>(overlay_input_type::key_down);
+		break;
+	case WM_KEYUP:
+		event.type = static_cast<int32_t>(overlay_input_type::key_up);
+		break;
+	case WM_CHAR:
+		event.type = static_cast<int32_t>(overlay_input_type::key_char);
+		break;
+	default:
+		break;
+	};
 
+	if (event.type != static_cast<int32_t>(overlay_input_type::unknown))
 	{
-		std::lock_guard<std::mutex> lock(send_queue_mutex);
-		event = to_send.front();
-		to_send.pop();
+		const LPKBDLLHOOKSTRUCT key = reinterpret_cast<LPKBDLLHOOKSTRUCT>(lParam);
+		event.code = static_cast<int32_t>(key->vkCode);
+		event.scan_code = static_cast<int32_t>(key->scanCode);
+		event.flags = static_cast<int32_t>(key->flags);
+		event.time = static_cast<int32_t>(key->time);
 	}
 
+	return event;
+}
+
+napi_status callback_keyboard_method_t::set_callback_args_values(napi_env env, const overlay_input_event& event)
+{
+	log_debug << "APP: callback_keyboard_method_t::set_callback_args_values" << std::endl;
+	napi_status status = napi_ok;
+
 	bool send_key = false;
 
-	std::string event_type = "unknown";
+	input_js_string event_type = input_js_string_unknown;
 
-	switch (event->wParam)
+	switch (static_cast<overlay_input_type>(event.type))
 	{
-	case WM_KEYDOWN:
-		event_type = "keyDown";
+	case overlay_input_type::key_down:
+		event_type = input_js_string_key_down;
 		send_key = true;
 		break;
-	case WM_KEYUP:
-		event_type = "keyUp";
+	case overlay_input_type::key_up:
+		event_type = input_js_string_key_up;
 		send_key = true;
 		break;
-	case WM_CHAR:
-		event_type = "char";
+	case overlay_input_type::key_char:
+		event_type = input_js_string_char;
 		send_key = true;
 		break;
 	default:
@@ -220,16 +329,14 @@ napi_status callback_keyboard_method_t::set_callback_args_values(napi_env env)
 
 	if (status == napi_ok)
 	{
-		status = napi_create_string_utf8(env, event_type.c_str(), event_type.size(), &argv_to_cb[0]);
+		status = get_js_string(env, event_type, &argv_to_cb[0]);
 	}
 
 	if (send_key)
 	{
 		if (status == napi_ok)
 		{
-			const LPKBDLLHOOKSTRUCT key = reinterpret_cast<LPKBDLLHOOKSTRUCT>(event->lParam);
-			const std::string& keyCode = translate_to_electron_keycode(key->vkCode);
-			status = napi_create_string_utf8(env, keyCode.c_str(), keyCode.size(), &argv_to_cb[1]);
+			status = get_js_key_name(env, event.code, &argv_to_cb[1]);
 		}
 	}
 
@@ -241,78 +348,111 @@ napi_status callback_keyboard_method_t::set_callback_args_values(napi_env env)
 	return status;
 }
 
-napi_status callback_mouse_method_t::set_callback_args_values(napi_env env)
+// called in mouse hook with overlay_mouse_input, valid only until hook returns
+overlay_input_event callback_mouse_method_t::capture_event(WPARAM wParam, LPARAM lParam)
 {
-	log_info << "APP: callback_mouse_method_t::set_callback_args_values" << std::endl;
-	napi_status status = napi_ok;
-
-	std::shared_ptr<wm_event_t> event;
+	const overlay_mouse_input* input = reinterpret_cast<const overlay_mouse_input*>(lParam);
 
-	{
-		std::lock_guard<std::mutex> lock(send_queue_mutex);
-		event = to_send.front();
-		to_send.pop();
-	}
+	overlay_input_event event = {static_cast<int32_t>(overlay_input_type::unknown)};
+	event.count = 1;
 
-	bool send_mouse = false;
-	std::string event_type = "unknown";
-	std::string mouse_modifiers = "";
-
-	switch (event->wParam)
+	switch (wParam)
 	{
-
 	case WM_MOUSEMOVE:
-		event_type = "mouseMove";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_move);
 		break;
 	case WM_LBUTTONDOWN:
-		event_type = "mouseDown";
-		mouse_modifiers = "leftButtonDown";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_down);
+		event.code = static_cast<int32_t>(overlay_mouse_button::left);
 		break;
 	case WM_LBUTTONUP:
-		event_type = "mouseUp";
-		mouse_modifiers = "leftButtonUp";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_up);
+		event.code = static_cast<int32_t>(overlay_mouse_button::left);
 		break;
 	case WM_RBUTTONDOWN:
-		event_type = "mouseDown";
-		mouse_modifiers = "rightButtonDown";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_down);
+		event.code = static_cast<int32_t>(overlay_mouse_button::right);
 		break;
 	case WM_RBUTTONUP:
-		event_type = "mouseUp";
-		mouse_modifiers = "rightButtonUp";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_up);
+		event.code = static_cast<int32_t>(overlay_mouse_button::right);
 		break;
 	case WM_MOUSEWHEEL:
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_wheel);
+		event.code = static_cast<int32_t>(overlay_mouse_wheel::vertical);
+		event.wheel_delta = static_cast<int16_t>(HIWORD(input->hook.mouseData));
+		break;
 	case WM_MOUSEHWHEEL:
-		event_type = "mouseWheel";
-		mouse_modifiers = "";
-		send_mouse = true;
+		event.type = static_cast<int32_t>(overlay_input_type::mouse_wheel);
+		event.code = static_cast<int32_t>(overlay_mouse_wheel::horizontal);
+		event.wheel_delta = static_cast<int16_t>(HIWORD(input->hook.mouseData));
+		break;
+	default:
+		break;
+	};
+
+	event.flags = static_cast<int32_t>(input->hook.flags);
+	event.time = static_cast<int32_t>(input->hook.time);
+	event.overlay_id = input->hit.overlay_id;
+	event.x = input->hit.x;
+	event.y = input->hit.y;
+
+	return event;
+}
+
+napi_status callback_mouse_method_t::set_callback_args_values(napi_env env, const overlay_input_event& event)
+{
+	log_debug << "APP: callback_mouse_method_t::set_callback_args_values" << std::endl;
+	napi_status status = napi_ok;
+
+	bool send_mouse = true;
+	input_js_string event_type = input_js_string_unknown;
+	input_js_string mouse_modifiers = input_js_string_no_modifiers;
+	const bool left_button = event.code == static_cast<int32_t>(overlay_mouse_button::left);
+
+	switch (static_cast<overlay_input_type>(event.type))
+	{
+	case overlay_input_type::mouse_move:
+		event_type = input_js_string_mouse_move;
+		break;
+	case overlay_input_type::mouse_down:
+		event_type = input_js_string_mouse_down;
+		mouse_modifiers = left_button ? input_js_string_left_button_down : input_js_string_right_button_down;
+		break;
+	case overlay_input_type::mouse_up:
+		event_type = input_js_string_mouse_up;
+		mouse_modifiers = left_button ? input_js_string_left_button_up : input_js_string_right_button_up;
+		break;
+	case overlay_input_type::mouse_wheel:
+		event_type = input_js_string_mouse_wheel;
 		break;
 	default:
+		send_mouse = false;
 		break;
 	};
 
 	if (status == napi_ok)
 	{
-		status = napi_create_string_utf8(env, event_type.c_str(), event_type.size(), &argv_to_cb[0]);
+		status = get_js_string(env, event_type, &argv_to_cb[0]);
 	}
 
 	if (send_mouse)
 	{
 		if (status == napi_ok)
 		{
-			status = napi_create_int32(env, 100, &argv_to_cb[1]);
+			status = napi_create_int32(env, event.x, &argv_to_cb[1]);
 		}
 		if (status == napi_ok)
 		{
-			status = napi_create_int32(env, 100, &argv_to_cb[2]);
+			status = napi_create_int32(env, event.y, &argv_to_cb[2]);
 		}
 		if (status == napi_ok)
 		{
-			status = napi_create_string_utf8(env, mouse_modifiers.c_str(), mouse_modifiers.size(), &argv_to_cb[3]);
+			status = get_js_string(env, mouse_modifiers, &argv_to_cb[3]);
+		}
+		if (status == napi_ok)
+		{
+			status = napi_create_int32(env, event.overlay_id, &argv_to_cb[4]);
 		}
 	}
 
@@ -320,31 +460,97 @@ napi_status callback_mouse_method_t::set_callback_args_values(napi_env env)
 	{
 		status = napi_create_int32(env, 0, &argv_to_cb[1]);
 		status = napi_create_int32(env, 0, &argv_to_cb[2]);
+		status = get_js_string(env, input_js_string_no_modifiers, &argv_to_cb[3]);
+		status = napi_create_int32(env, 0, &argv_to_cb[4]);
 	}
 
 	return status;
 }
 
-int callback_method_t::use_callback(WPARAM wParam, LPARAM lParam)
+// overlay thread timer, moves events waiting for room in ring when no new input comes to hook
+static void CALLBACK flush_waiting_input(HWND hwnd, UINT message, UINT_PTR timer_id, DWORD time)
 {
-	log_info << "APP: use_callback called" << std::endl;
+	callback_method_t* methods[] = {user_keyboard_callback_info, user_mouse_callback_info};
+	for (callback_method_t* method : methods)
+	{
+		if (method != nullptr && method->flush_timer == timer_id)
+		{
+			method->flush_waiting();
+			return;
+		}
+	}
 
-	int ret = -1;
+	KillTimer(nullptr, timer_id);
+}
+
+// hook thread. wakes JS for events that got to ring, timer runs while some still wait
+void callback_method_t::flush_waiting()
+{
+	const bool waiting = to_send.flush();
 
+	if (waiting && flush_timer == 0)
 	{
-		std::lock_guard<std::mutex> lock(send_queue_mutex);
-		to_send.push(std::make_shared<wm_event_t>(wParam, lParam));
+		flush_timer = SetTimer(nullptr, 0, flush_waiting_ms, &flush_waiting_input);
+	} else if (!waiting && flush_timer != 0)
+	{
+		KillTimer(nullptr, flush_timer);
+		flush_timer = 0;
 	}
 
 	uv_async_send(&uv_async_this);
+}
 
-	if (to_send.size() > 256)
+// called from hook on overlay thread. event data is copied, so nothing is allocated and hook does not wait for JS.
+// when JS falls behind moves are merged and other events wait in spill, only moves are dropped when spill is full
+int callback_method_t::use_callback(WPARAM wParam, LPARAM lParam)
+{
+	log_debug << "APP: use_callback called" << std::endl;
+
+	if (!to_send.push(capture_event(wParam, lParam)))
 	{
-		log_info << "APP: Failed to send too many events, will switch input interception off" << std::endl;
-		ret = switch_input();
+		log_info << "APP: mouse moves dropped, JS is far behind, " << to_send.get_dropped_count() << " dropped" << std::endl;
 	}
 
-	return ret;
+	flush_waiting();
+
+	return 0;
+}
+
+// all events waiting in ring as one Int32Array, fields of each event go in order of overlay_input_event
+napi_status callback_method_t::set_batch_args_values(napi_env env, napi_value* batch, size_t& count)
+{
+	overlay_input_event events[overlay_input_ring::capacity];
+	const size_t popped = to_send.pop_many(events, overlay_input_ring::capacity);
+
+	count = 0;
+	for (size_t i = 0; i < popped; i++)
+	{
+		if (count != 0 && is_mouse_move(events[i]) && is_mouse_move(events[count - 1]))
+		{
+			merge_mouse_move(events[count - 1], events[i]);
+		} else
+		{
+			events[count++] = events[i];
+		}
+	}
+
+	if (count == 0)
+	{
+		return napi_ok;
+	}
+
+	const size_t fields = sizeof(overlay_input_event) / sizeof(int32_t);
+
+	void* data = nullptr;
+	napi_value buffer;
+	napi_status status = napi_create_arraybuffer(env, count * sizeof(overlay_input_event), &data, &buffer);
+	if (status == napi_ok)
+	{
+		memcpy(data, events, count * sizeof(overlay_input_event));
+		status = napi_create_typedarray(env, napi_int32_array, count * fields, buffer, 0, batch);
+	}
+
+	return status;
 }
 
 int switch_input()
@@ -362,7 +568,7 @@ int switch_input()
 
 int use_callback_keyboard(WPARAM wParam, LPARAM lParam)
 {
-	log_info << "APP: use_callback_keyboard  " << std::endl;
+	log_debug << "APP: use_callback_keyboard  " << std::endl;
 
 	int ret = -1;
 
@@ -377,7 +583,7 @@ int use_callback_keyboard(WPARAM wParam, LPARAM lParam)
 
 int use_callback_mouse(WPARAM wParam, LPARAM lParam)
 {
-	log_info << "APP: use_callback_mouse  " << std::endl;
+	log_debug << "APP: use_callback_mouse  " << std::endl;
 
 	int ret = -1;
 
@@ -456,31 +662,61 @@ void callback_method_t::async_callback()
 		status = napi_get_reference_value(env_this, js_this, &js_cb);
 		if (status == napi_ok)
 		{
-			while (to_send.size() > 0)
+			// same receiver for all calls of this wake up
+			if (async_context)
+			{
+				status = napi_create_object(env_this, &recv);
+			} else
+			{
+				status = napi_get_global(env_this, &recv);
+			}
+		}
+
+		overlay_input_event event;
+		while (status == napi_ok)
+		{
+			size_t argc = get_argc_to_cb();
+			napi_value* argv = get_argv_to_cb();
+			napi_value batch;
+			size_t batch_size = 0;
+			if (batched)
+			{
+				status = set_batch_args_values(env_this, &batch, batch_size);
+				if (batch_size == 0)
+				{
+					break;
+				}
+				argc = 1;
+				argv = &batch;
+			} else if (to_send.pop(event))
+			{
+				overlay_input_event next_event;
+				while (is_mouse_move(event) && to_send.peek(next_event) && is_mouse_move(next_event))
+				{
+					to_send.pop(next_event);
+					merge_mouse_move(event, next_event);
+				}
+				status = set_callback_args_values(env_this, event);
+			} else
+			{
+				break;
+			}
+
+			if (status == napi_ok)
 			{
-				status = set_callback_args_values(env_this);
-				if (status == napi_ok)
+				if (async_context)
+				{
+					status = napi_make_callback(env_this, async_context, recv, js_cb, argc, argv, &ret_value);
+				} else
 				{
-					status = napi_create_object(env_this, &recv);
-					if (status == napi_ok)
-					{
-						if (async_context)
-						{
-						
-							status = napi_make_callback(
-								env_this, async_context, recv, js_cb, get_argc_to_cb(), get_argv_to_cb(), &ret_value);
-						} else
-						{
-							napi_value global;
-							status = napi_get_global(env_this, &global);
-							if (status == napi_ok)
-							{
-								status = napi_call_function(env_this, global, js_cb, get_argc_to_cb(), get_argv_to_cb(), &ret_value);
-							}
-						}
-					}
+					status = napi_call_function(env_this, recv, js_cb, argc, argv, &ret_value);
 				}
 			}
+
+			if (batched)
+			{
+				break;
+			}
 		}
 
 		napi_close_handle_scope(env_this, scope);
@@ -489,10 +725,7 @@ void callback_method_t::async_callback()
 	if (status != napi_ok)
 	{
 		log_error << "APP: failed async_callback to send callback with status " << status << std::endl;
-		while (to_send.size() > 0)
-		{
-			to_send.pop();
-		}
+		to_send.clear();
 	}
 }
 
@@ -516,4 +749,16 @@ napi_status napi_create_and_set_named_property(napi_env& env, napi_value& obj, c
 		status = napi_set_named_property(env, obj, value_name, set_value);
 	}
 	return status;
+}
+
+napi_status napi_create_and_set_named_property(napi_env& env, napi_value& obj, const char* value_name, const int64_t value) noexcept
+{
+	napi_status status;
+	napi_value set_value;
+	status = napi_create_int64(env, value, &set_value);
+	if (status == napi_ok)
+	{
+		status = napi_set_named_property(env, obj, value_name, set_value);
+	}
+	return status;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_deadlines.h"
+#include "overlay_test.h"
+
+#include <random>
+#include <stdio.h>
+
+class bench_clock : public overlay_clock
+{
+	public:
+	uint64_t time = 0;
+
+	virtual uint64_t now() override
+	{
+		return time;
+	}
+};
+
+// one ms step of overlay thread loop: wait, take expired deadlines and schedule them again a second later
+static int run_ticks(bench_clock& clock, overlay_deadlines& deadlines, int ticks)
+{
+	int expired_count = 0;
+	for (int i = 0; i < ticks; i++)
+	{
+		clock.time++;
+		deadlines.get_timeout();
+		overlay_deadline deadline;
+		while (deadlines.pop_expired(deadline))
+		{
+			deadlines.schedule(deadline.overlay_id, deadline.kind, clock.time + 1000);
+			expired_count++;
+		}
+	}
+	return expired_count;
+}
+
+// Cost of moving a deadline, of a tick when nothing expires and of each expired deadline, with many
+// scheduled deadlines. Wheel jumps over empty slots, so all of them should stay flat while the number of deadlines grows.
+static void measure_wheel(int overlay_count)
+{
+	const int ticks = overlay_test_is_quick() ? 1000 : 100000;
+	std::mt19937 random(3);
+	std::shared_ptr<bench_clock> clock = std::make_shared<bench_clock>();
+	overlay_deadlines deadlines(clock);
+
+	// autohide is moved on every frame, far ahead
+	for (int id = 0; id < overlay_count; id++)
+	{
+		deadlines.schedule(id, overlay_deadline_kind::autohide, 1000000 + random() % 600000);
+	}
+	uint64_t start = overlay_test_now_ns();
+	for (int i = 0; i < ticks; i++)
+	{
+		deadlines.schedule(i % overlay_count, overlay_deadline_kind::autohide, 1000000 + random() % 600000);
+	}
+	const double schedule_ns = static_cast<double>(overlay_test_now_ns() - start) / ticks;
+
+	start = overlay_test_now_ns();
+	run_ticks(*clock, deadlines, ticks);
+	const double idle_tick_ns = static_cast<double>(overlay_test_now_ns() - start) / ticks;
+
+	// producer signal of every overlay each second, time of ticks between them is included
+	for (int id = 0; id < overlay_count; id++)
+	{
+		deadlines.schedule(id, overlay_deadline_kind::producer_signal, clock->time + 1 + random() % 1000);
+	}
+	start = overlay_test_now_ns();
+	const int expired_count = run_ticks(*clock, deadlines, ticks);
+	const double busy_ns = static_cast<double>(overlay_test_now_ns() - start);
+
+	char measurement[64];
+	snprintf(measurement, sizeof(measurement), "%d overlays schedule", overlay_count);
+	overlay_test_report(measurement, schedule_ns, "ns");
+	snprintf(measurement, sizeof(measurement), "%d overlays tick without expired", overlay_count);
+	overlay_test_report(measurement, idle_tick_ns, "ns");
+	snprintf(measurement, sizeof(measurement), "%d overlays per expired deadline", overlay_count);
+	overlay_test_report(measurement, expired_count > 0 ? busy_ns / expired_count : 0.0, "ns");
+}
+
+OVERLAY_TEST(deadlines, wheel_cost_per_tick)
+{
+	measure_wheel(10);
+	measure_wheel(100);
+	measure_wheel(1000);
+	measure_wheel(10000);
+}
@@ -0,0 +1,55 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_flight_recorder.h"
+#include "overlay_test.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Cost of one record on hot paths, alone and with other threads recording at the same time.
+// Threads share only the position counter, records are written to different cells
+static void measure_records(int threads_count)
+{
+	const int per_thread = overlay_test_is_quick() ? 10000 : 10000000;
+
+	const uint64_t start = overlay_test_now_ns();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threads_count; t++)
+	{
+		threads.emplace_back([t, per_thread]() {
+			for (int i = 0; i < per_thread; i++)
+			{
+				record_flight_event(overlay_flight_event::hook_event, t, i, i);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const double elapsed_ns = static_cast<double>(overlay_test_now_ns() - start);
+
+	char measurement[64];
+	snprintf(measurement, sizeof(measurement), "%d threads, per record", threads_count);
+	overlay_test_report(measurement, elapsed_ns / (static_cast<double>(per_thread) * threads_count), "ns");
+}
+
+OVERLAY_TEST(flight_recorder, record_cost)
+{
+	measure_records(1);
+	measure_records(2);
+	measure_records(4);
+}
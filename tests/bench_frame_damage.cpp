@@ -0,0 +1,63 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_damage.h"
+#include "overlay_test.h"
+
+#include <stdio.h>
+#include <vector>
+
+// Time of find_damage for a frame without changes, where every tile is compared to the end,
+// and for a frame where a small area changes, like a blinking cursor or a counter.
+static void measure_damage(const char* size_name, int width, int height)
+{
+	const int rounds = overlay_test_is_quick() ? 3 : 200;
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	std::vector<uint8_t> frame(pitch * height, 0x80);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.data(), pitch, width, height, rects);
+
+	uint64_t start = overlay_test_now_ns();
+	for (int i = 0; i < rounds; i++)
+	{
+		rects.clear();
+		damage.find_damage(frame.data(), pitch, width, height, rects);
+	}
+	const double same_ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+	start = overlay_test_now_ns();
+	for (int i = 0; i < rounds; i++)
+	{
+		frame[(height / 2) * pitch + (width / 2) * 4] = static_cast<uint8_t>(i);
+		rects.clear();
+		damage.find_damage(frame.data(), pitch, width, height, rects);
+	}
+	const double small_change_ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+	char measurement[64];
+	snprintf(measurement, sizeof(measurement), "%s same frame", size_name);
+	overlay_test_report(measurement, same_ns / 1000000.0, "ms");
+	snprintf(measurement, sizeof(measurement), "%s same frame compared", size_name);
+	overlay_test_report(measurement, pitch * height / same_ns, "GB/s");
+	snprintf(measurement, sizeof(measurement), "%s one pixel changed", size_name);
+	overlay_test_report(measurement, small_change_ns / 1000000.0, "ms");
+}
+
+OVERLAY_TEST(frame_damage, find_damage_speed)
+{
+	measure_damage("720p", 1280, 720);
+	measure_damage("1080p", 1920, 1080);
+	measure_damage("4K", 3840, 2160);
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_hash.h"
+#include "overlay_test.h"
+
+#include <stdio.h>
+#include <vector>
+
+OVERLAY_TEST(frame_hash, hash_speed)
+{
+	const overlay_isa isas[] = {overlay_isa::scalar, overlay_isa::sse2, overlay_isa::avx2, overlay_isa::neon};
+	const char* isa_names[] = {"scalar", "sse2", "avx2", "neon"};
+	const size_t size = 1920 * 1080 * 4;
+	const int rounds = overlay_test_is_quick() ? 2 : 100;
+	std::vector<uint8_t> frame(size, 0x5A);
+
+	for (int i = 0; i < 4; i++)
+	{
+		uint64_t hash = 0;
+		if (!hash_frame_pixels_for_isa(isas[i], frame.data(), size, 0, hash))
+		{
+			continue;
+		}
+
+		const uint64_t start = overlay_test_now_ns();
+		for (int round = 0; round < rounds; round++)
+		{
+			hash_frame_pixels_for_isa(isas[i], frame.data(), size, hash, hash);
+		}
+		const double ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+		char measurement[64];
+		snprintf(measurement, sizeof(measurement), "1080p frame hash %s", isa_names[i]);
+		overlay_test_report(measurement, size / ns, "GB/s");
+	}
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_input_ring.h"
+#include "overlay_test.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// JS thread side of batched delivery without napi: take what is in ring, merge moves and pack events
+// as int32 fields the way set_batch_args_values does. returns count of packed events
+static size_t pack_batch(overlay_input_queue& queue, overlay_input_event* events, std::vector<int32_t>& batch)
+{
+	const size_t popped = queue.pop_many(events, overlay_input_ring::capacity);
+	size_t count = 0;
+	for (size_t i = 0; i < popped; i++)
+	{
+		if (count != 0 && is_mouse_move(events[i]) && is_mouse_move(events[count - 1]))
+		{
+			merge_mouse_move(events[count - 1], events[i]);
+		} else
+		{
+			events[count++] = events[i];
+		}
+	}
+	memcpy(batch.data(), events, count * sizeof(overlay_input_event));
+	return count;
+}
+
+// Events per second from hook push to packed batch given to JS, with consumer taking a batch per wake up.
+// moves_per_click tells how much of input is mouse moves, merged moves count as delivered
+static void measure_delivery(int moves_per_click)
+{
+	const int32_t count = overlay_test_is_quick() ? 20000 : 2000000;
+	overlay_input_queue queue;
+	std::atomic<bool> done {false};
+
+	const uint64_t start = overlay_test_now_ns();
+	std::thread producer([&]() {
+		for (int32_t i = 0; i < count; i++)
+		{
+			overlay_input_event event = {};
+			event.type = static_cast<int32_t>(i % (moves_per_click + 1) == 0 ? overlay_input_type::mouse_down : overlay_input_type::mouse_move);
+			event.x = i;
+			event.count = 1;
+			queue.push(event);
+			// hook returns to message loop between events
+			if (i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		while (queue.flush())
+		{
+			std::this_thread::yield();
+		}
+		done = true;
+	});
+
+	overlay_input_event events[overlay_input_ring::capacity];
+	std::vector<int32_t> batch(overlay_input_ring::capacity * sizeof(overlay_input_event) / sizeof(int32_t));
+	uint64_t delivered = 0;
+	uint64_t batches = 0;
+	while (true)
+	{
+		const bool finished = done.load();
+		const size_t packed = pack_batch(queue, events, batch);
+		for (size_t i = 0; i < packed; i++)
+		{
+			delivered += static_cast<uint64_t>(events[i].count);
+		}
+		batches += packed != 0 ? 1 : 0;
+		if (packed == 0)
+		{
+			if (finished)
+			{
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	const double seconds = static_cast<double>(overlay_test_now_ns() - start) / 1e9;
+
+	CHECK_EQ(delivered + queue.get_dropped_count(), static_cast<uint64_t>(count));
+
+	char measurement[64];
+	snprintf(measurement, sizeof(measurement), "%d moves per click, events", moves_per_click);
+	overlay_test_report(measurement, static_cast<double>(delivered) / seconds / 1e6, "M/s");
+	snprintf(measurement, sizeof(measurement), "%d moves per click, events per batch", moves_per_click);
+	overlay_test_report(measurement, batches != 0 ? static_cast<double>(delivered) / batches : 0.0, "events");
+}
+
+OVERLAY_TEST(input_ring, delivery_events_per_second)
+{
+	measure_delivery(0);
+	measure_delivery(10);
+	measure_delivery(100);
+}
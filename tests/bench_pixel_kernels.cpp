@@ -0,0 +1,103 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_pixel_kernels.h"
+#include "overlay_test.h"
+
+#include <stdio.h>
+#include <vector>
+
+static const overlay_isa isas[] = {overlay_isa::scalar, overlay_isa::sse2, overlay_isa::avx2, overlay_isa::neon};
+static const char* isa_names[] = {"scalar", "sse2", "avx2", "neon"};
+
+// GB/s of source pixels converted, 1080p frame row by row like copy_rects does
+OVERLAY_TEST(pixel_kernels, convert_speed)
+{
+	const int width = 1920;
+	const int height = 1080;
+	const int rounds = overlay_test_is_quick() ? 1 : 50;
+	std::vector<uint8_t> src(static_cast<size_t>(width) * height * 4, 0x7F);
+	std::vector<uint8_t> dst(src.size());
+
+	struct named_conversion
+	{
+		const char* name;
+		overlay_pixel_conversion conversion;
+	};
+	named_conversion conversions[3];
+	conversions[0].name = "swizzle";
+	conversions[0].conversion.swap_red_blue = true;
+	conversions[1].name = "premultiply";
+	conversions[1].conversion.premultiply = true;
+	conversions[2].name = "premultiply global alpha";
+	conversions[2].conversion.premultiply = true;
+	conversions[2].conversion.global_alpha = 200;
+
+	for (const named_conversion& named : conversions)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			if (!cpu_has_isa(isas[i]))
+			{
+				continue;
+			}
+
+			const uint64_t start = overlay_test_now_ns();
+			for (int round = 0; round < rounds; round++)
+			{
+				for (int y = 0; y < height; y++)
+				{
+					const size_t row = static_cast<size_t>(y) * width * 4;
+					convert_pixels_for_isa(isas[i], dst.data() + row, src.data() + row, width, named.conversion);
+				}
+			}
+			const double ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+			char measurement[64];
+			snprintf(measurement, sizeof(measurement), "%s %s", named.name, isa_names[i]);
+			overlay_test_report(measurement, src.size() / ns, "GB/s");
+		}
+	}
+}
+
+OVERLAY_TEST(pixel_kernels, mark_alpha_blocks_speed)
+{
+	const int width = 1920;
+	const int height = 1080;
+	const int rounds = overlay_test_is_quick() ? 1 : 50;
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 0);
+	std::vector<uint8_t> blocks(width / 4);
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (!cpu_has_isa(isas[i]))
+		{
+			continue;
+		}
+
+		const uint64_t start = overlay_test_now_ns();
+		for (int round = 0; round < rounds; round++)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				mark_alpha_blocks_for_isa(isas[i], blocks.data(), pixels.data() + static_cast<size_t>(y) * width * 4, blocks.size());
+			}
+		}
+		const double ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+		char measurement[64];
+		snprintf(measurement, sizeof(measurement), "alpha coverage %s", isa_names[i]);
+		overlay_test_report(measurement, pixels.size() / ns, "GB/s");
+	}
+}
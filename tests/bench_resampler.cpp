@@ -0,0 +1,49 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_resampler.h"
+#include "overlay_test.h"
+
+#include <stdio.h>
+#include <vector>
+
+static void measure_scale(const char* name, int src_width, int src_height, int dst_width, int dst_height)
+{
+	const int rounds = overlay_test_is_quick() ? 1 : 30;
+	std::vector<uint8_t> src(static_cast<size_t>(src_width) * src_height * 4, 0x3C);
+	std::vector<uint8_t> dst(static_cast<size_t>(dst_width) * dst_height * 4);
+	overlay_resampler resampler;
+	resampler.scale(dst.data(), dst_width, dst_height, dst_width * 4, src.data(), src_width, src_height, src_width * 4);
+
+	const uint64_t start = overlay_test_now_ns();
+	for (int round = 0; round < rounds; round++)
+	{
+		resampler.scale(dst.data(), dst_width, dst_height, dst_width * 4, src.data(), src_width, src_height, src_width * 4);
+	}
+	const double ns = static_cast<double>(overlay_test_now_ns() - start) / rounds;
+
+	char measurement[64];
+	snprintf(measurement, sizeof(measurement), "%s", name);
+	overlay_test_report(measurement, ns / 1000000.0, "ms");
+	snprintf(measurement, sizeof(measurement), "%s output", name);
+	overlay_test_report(measurement, dst_width * static_cast<double>(dst_height) / ns * 1000.0, "Mpixel/s");
+}
+
+OVERLAY_TEST(resampler, scale_speed)
+{
+	measure_scale("1080p to 720p bilinear", 1920, 1080, 1280, 720);
+	measure_scale("720p to 1080p bilinear", 1280, 720, 1920, 1080);
+	measure_scale("4K to 1080p box", 3840, 2160, 1920, 1080);
+	measure_scale("1080p to 1050x590 box", 1920, 1080, 1050, 590);
+}
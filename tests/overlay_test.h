@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sstream>
+#include <stdint.h>
+#include <string>
+
+// Small test runner without dependencies. Tests and benchmarks register themselves from
+// static initializers, overlay_test_main runs the ones of suites given as arguments or all of them.
+// Failed checks are reported and the test goes on, so one run shows every broken check.
+typedef void (*overlay_test_fn)();
+
+struct overlay_test_case
+{
+	const char* suite;
+	const char* name;
+	overlay_test_fn run;
+	overlay_test_case* next;
+};
+
+bool overlay_test_register(overlay_test_case* test);
+void overlay_test_fail(const char* file, int line, const std::string& message);
+
+// benchmarks use smaller sizes and fewer rounds when started with --quick, ctest starts them so
+bool overlay_test_is_quick();
+uint64_t overlay_test_now_ns();
+void overlay_test_report(const char* measurement, double value, const char* unit);
+
+#define OVERLAY_TEST(suite, name) \
+	static void suite##_##name(); \
+	static overlay_test_case suite##_##name##_case = {#suite, #name, suite##_##name, nullptr}; \
+	[[maybe_unused]] static const bool suite##_##name##_registered = overlay_test_register(&suite##_##name##_case); \
+	static void suite##_##name()
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+			overlay_test_fail(__FILE__, __LINE__, #expression); \
+	} while (0)
+
+#define CHECK_EQ(actual, expected) overlay_check_equal(__FILE__, __LINE__, #actual, (actual), (expected))
+
+template <typename A, typename E>
+void overlay_check_equal(const char* file, int line, const char* expression, const A& actual, const E& expected)
+{
+	if (!(actual == expected))
+	{
+		std::ostringstream message;
+		message << expression << " is " << actual << ", expected " << expected;
+		overlay_test_fail(file, line, message.str());
+	}
+}
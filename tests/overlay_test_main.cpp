@@ -0,0 +1,111 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_test.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static overlay_test_case* first_test = nullptr;
+static overlay_test_case* last_test = nullptr;
+static int failed_checks = 0;
+static bool quick = false;
+
+bool overlay_test_register(overlay_test_case* test)
+{
+	// kept in registration order so a suite runs in the order it is written
+	if (last_test == nullptr)
+	{
+		first_test = test;
+	} else
+	{
+		last_test->next = test;
+	}
+	last_test = test;
+	return true;
+}
+
+void overlay_test_fail(const char* file, int line, const std::string& message)
+{
+	failed_checks++;
+	fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+}
+
+bool overlay_test_is_quick()
+{
+	return quick;
+}
+
+uint64_t overlay_test_now_ns()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void overlay_test_report(const char* measurement, double value, const char* unit)
+{
+	printf("    %-48s %12.2f %s\n", measurement, value, unit);
+	fflush(stdout);
+}
+
+// arguments are suite names to run, none runs all. --quick makes benchmarks short
+int main(int argc, char** argv)
+{
+	std::vector<const char*> suites;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			quick = true;
+		} else
+		{
+			suites.push_back(argv[i]);
+		}
+	}
+
+	int run_count = 0;
+	int failed_count = 0;
+	for (overlay_test_case* test = first_test; test != nullptr; test = test->next)
+	{
+		bool selected = suites.empty();
+		for (const char* suite : suites)
+		{
+			selected = selected || strcmp(suite, test->suite) == 0;
+		}
+		if (!selected)
+		{
+			continue;
+		}
+
+		printf("[ run  ] %s.%s\n", test->suite, test->name);
+		fflush(stdout);
+		const int failed_before = failed_checks;
+		test->run();
+		const bool passed = failed_checks == failed_before;
+		printf("[ %s ] %s.%s\n", passed ? " ok " : "FAIL", test->suite, test->name);
+
+		run_count++;
+		failed_count += passed ? 0 : 1;
+	}
+
+	if (run_count == 0)
+	{
+		fprintf(stderr, "no tests matched\n");
+		return 1;
+	}
+
+	printf("%d tests, %d failed\n", run_count, failed_count);
+	return failed_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_deadlines.h"
+#include "overlay_test.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+class test_clock : public overlay_clock
+{
+	public:
+	uint64_t time = 1000;
+
+	virtual uint64_t now() override
+	{
+		return time;
+	}
+};
+
+static std::vector<overlay_deadline> pop_all(overlay_deadlines& deadlines)
+{
+	std::vector<overlay_deadline> popped;
+	overlay_deadline deadline;
+	while (deadlines.pop_expired(deadline))
+	{
+		popped.push_back(deadline);
+	}
+	return popped;
+}
+
+OVERLAY_TEST(deadlines, empty_wheel_waits_without_timeout)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	CHECK_EQ(deadlines.get_timeout(), overlay_deadlines::no_timeout);
+	CHECK_EQ(pop_all(deadlines).size(), 0u);
+	CHECK_EQ(deadlines.now(), 1000u);
+}
+
+OVERLAY_TEST(deadlines, deadline_expires_at_its_time)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	deadlines.schedule(7, overlay_deadline_kind::autohide, 1010);
+	CHECK(deadlines.is_scheduled(7, overlay_deadline_kind::autohide));
+	CHECK(!deadlines.is_scheduled(7, overlay_deadline_kind::frame_update));
+	CHECK_EQ(deadlines.get_timeout(), 10u);
+
+	clock->time = 1009;
+	CHECK_EQ(pop_all(deadlines).size(), 0u);
+	CHECK_EQ(deadlines.get_timeout(), 1u);
+
+	clock->time = 1010;
+	const std::vector<overlay_deadline> popped = pop_all(deadlines);
+	CHECK_EQ(popped.size(), 1u);
+	CHECK(popped.size() == 1 && popped[0].overlay_id == 7 && popped[0].kind == overlay_deadline_kind::autohide && popped[0].at == 1010);
+	CHECK(!deadlines.is_scheduled(7, overlay_deadline_kind::autohide));
+	CHECK_EQ(deadlines.get_timeout(), overlay_deadlines::no_timeout);
+}
+
+OVERLAY_TEST(deadlines, past_deadline_expires_now)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	deadlines.schedule(1, overlay_deadline_kind::frame_update, 500);
+	deadlines.schedule(2, overlay_deadline_kind::frame_update, 1000);
+	CHECK_EQ(deadlines.get_timeout(), 0u);
+	CHECK_EQ(pop_all(deadlines).size(), 2u);
+}
+
+OVERLAY_TEST(deadlines, schedule_again_moves_deadline)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	deadlines.schedule(3, overlay_deadline_kind::autohide, 1005);
+	deadlines.schedule(3, overlay_deadline_kind::autohide, 6000);
+
+	clock->time = 1005;
+	CHECK_EQ(pop_all(deadlines).size(), 0u);
+
+	// and back closer
+	deadlines.schedule(3, overlay_deadline_kind::autohide, 1100);
+	clock->time = 1100;
+	const std::vector<overlay_deadline> popped = pop_all(deadlines);
+	CHECK_EQ(popped.size(), 1u);
+	CHECK(popped.size() == 1 && popped[0].at == 1100);
+}
+
+OVERLAY_TEST(deadlines, cancel_removes_all_kinds_of_overlay)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	for (int kind = 0; kind < static_cast<int>(overlay_deadline_kind::count); kind++)
+	{
+		deadlines.schedule(4, static_cast<overlay_deadline_kind>(kind), 1000 + kind * 100);
+	}
+	deadlines.schedule(5, overlay_deadline_kind::autohide, 1300);
+
+	deadlines.cancel(4);
+	clock->time = 100000;
+	const std::vector<overlay_deadline> popped = pop_all(deadlines);
+	CHECK_EQ(popped.size(), 1u);
+	CHECK(popped.size() == 1 && popped[0].overlay_id == 5);
+}
+
+// timers of a cancelled overlay are taken by the next overlay, expired timers are scheduled again in place
+OVERLAY_TEST(deadlines, timers_are_reused_after_cancel_and_expiry)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	deadlines.schedule(6, overlay_deadline_kind::autohide, 1200);
+	deadlines.schedule(6, overlay_deadline_kind::frame_update, 1001);
+	deadlines.cancel(6);
+	deadlines.cancel(6);
+	CHECK(!deadlines.is_scheduled(6, overlay_deadline_kind::autohide));
+	CHECK_EQ(deadlines.get_timeout(), overlay_deadlines::no_timeout);
+
+	deadlines.schedule(8, overlay_deadline_kind::producer_signal, 1002);
+	CHECK(!deadlines.is_scheduled(8, overlay_deadline_kind::autohide));
+	for (int round = 0; round < 3; round++)
+	{
+		clock->time += 2;
+		const std::vector<overlay_deadline> popped = pop_all(deadlines);
+		CHECK_EQ(popped.size(), 1u);
+		CHECK(popped.size() == 1 && popped[0].overlay_id == 8 && popped[0].kind == overlay_deadline_kind::producer_signal);
+		CHECK(!deadlines.is_scheduled(8, overlay_deadline_kind::producer_signal));
+		deadlines.schedule(8, overlay_deadline_kind::producer_signal, clock->time + 2);
+	}
+	CHECK_EQ(deadlines.get_timeout(), 2u);
+}
+
+// hours ahead is past the last level, deadline waits there and is placed again when it comes close
+OVERLAY_TEST(deadlines, far_deadline_is_not_early)
+{
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	const uint64_t at = 1000 + 6ULL * 3600 * 1000 + 123;
+	deadlines.schedule(1, overlay_deadline_kind::producer_signal, at);
+
+	// thread sleeps as told and never sleeps past the deadline
+	int wakes = 0;
+	while (clock->time < at)
+	{
+		const uint32_t timeout = deadlines.get_timeout();
+		CHECK(timeout != overlay_deadlines::no_timeout);
+		CHECK(clock->time + timeout <= at);
+		CHECK_EQ(pop_all(deadlines).size(), 0u);
+		clock->time += timeout > 0 ? timeout : 1;
+		wakes++;
+	}
+	CHECK(wakes < 20);
+	CHECK_EQ(pop_all(deadlines).size(), 1u);
+}
+
+// wheel against a plain map of deadlines with random schedules, moves, cancels and time steps
+OVERLAY_TEST(deadlines, random_deadlines_match_reference)
+{
+	std::mt19937 random(11);
+	std::shared_ptr<test_clock> clock = std::make_shared<test_clock>();
+	overlay_deadlines deadlines(clock);
+	std::map<std::pair<int, int>, uint64_t> expected;
+
+	for (int step = 0; step < 20000; step++)
+	{
+		const int action = random() % 10;
+		const int overlay_id = random() % 20;
+		if (action < 6)
+		{
+			const int kind = random() % static_cast<int>(overlay_deadline_kind::count);
+			static const uint64_t ranges[] = {4, 100, 5000, 400000, 40000000};
+			const uint64_t at = clock->time + random() % ranges[random() % 5];
+			deadlines.schedule(overlay_id, static_cast<overlay_deadline_kind>(kind), at);
+			expected[std::make_pair(overlay_id, kind)] = at;
+		} else if (action < 7)
+		{
+			deadlines.cancel(overlay_id);
+			for (int kind = 0; kind < static_cast<int>(overlay_deadline_kind::count); kind++)
+			{
+				expected.erase(std::make_pair(overlay_id, kind));
+			}
+		} else
+		{
+			uint64_t nearest = ~0ULL;
+			for (const auto& entry : expected)
+			{
+				nearest = entry.second < nearest ? entry.second : nearest;
+			}
+			const uint32_t timeout = deadlines.get_timeout();
+			if (expected.empty())
+			{
+				CHECK_EQ(timeout, overlay_deadlines::no_timeout);
+			} else
+			{
+				CHECK(clock->time + timeout <= (nearest > clock->time ? nearest : clock->time));
+			}
+
+			clock->time += random() % 3 == 0 ? timeout % 100000 : random() % 3000;
+			for (const overlay_deadline& deadline : pop_all(deadlines))
+			{
+				const auto found = expected.find(std::make_pair(deadline.overlay_id, static_cast<int>(deadline.kind)));
+				CHECK(found != expected.end() && found->second == deadline.at && deadline.at <= clock->time);
+				if (found != expected.end())
+				{
+					expected.erase(found);
+				}
+			}
+			for (const auto& entry : expected)
+			{
+				CHECK(entry.second > clock->time);
+			}
+		}
+	}
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_dirty_rects.h"
+#include "overlay_test.h"
+
+static bool same_rect(const overlay_pixel_rect& a, const overlay_pixel_rect& b)
+{
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+OVERLAY_TEST(dirty_rects, union_ignores_empty_rect)
+{
+	const overlay_pixel_rect a = {10, 20, 30, 40};
+	const overlay_pixel_rect b = {0, 30, 15, 50};
+	const overlay_pixel_rect empty = {100, 100, 100, 200};
+
+	CHECK(same_rect(union_pixel_rects(a, b), overlay_pixel_rect {0, 20, 30, 50}));
+	CHECK(same_rect(union_pixel_rects(a, empty), a));
+	CHECK(same_rect(union_pixel_rects(empty, b), b));
+}
+
+OVERLAY_TEST(dirty_rects, intersect)
+{
+	const overlay_pixel_rect a = {10, 20, 30, 40};
+	overlay_pixel_rect result;
+
+	CHECK(intersect_pixel_rects(result, a, overlay_pixel_rect {25, 0, 100, 25}));
+	CHECK(same_rect(result, overlay_pixel_rect {25, 20, 30, 25}));
+
+	// touching edges do not overlap, right and bottom are outside
+	CHECK(!intersect_pixel_rects(result, a, overlay_pixel_rect {30, 20, 40, 40}));
+	CHECK(result.is_empty());
+
+	// result can be one of the inputs
+	result = a;
+	CHECK(intersect_pixel_rects(result, result, overlay_pixel_rect {0, 0, 15, 100}));
+	CHECK(same_rect(result, overlay_pixel_rect {10, 20, 15, 40}));
+}
+
+OVERLAY_TEST(dirty_rects, contains)
+{
+	const overlay_pixel_rect a = {10, 20, 30, 40};
+	CHECK(a.contains(10, 20));
+	CHECK(a.contains(29, 39));
+	CHECK(!a.contains(30, 25));
+	CHECK(!a.contains(15, 40));
+	CHECK(!a.contains(9, 25));
+}
+
+OVERLAY_TEST(dirty_rects, add_skips_empty_rects)
+{
+	overlay_dirty_rects rects;
+	rects.add(overlay_pixel_rect {5, 5, 5, 10});
+	rects.add(overlay_pixel_rect {5, 10, 10, 5});
+	CHECK_EQ(rects.size(), 0u);
+
+	rects.add(overlay_pixel_rect {0, 0, 4, 4});
+	CHECK_EQ(rects.size(), 1u);
+	CHECK_EQ(rects.get_area(), 16u);
+}
+
+OVERLAY_TEST(dirty_rects, overflow_merges_into_bounds)
+{
+	overlay_dirty_rects rects;
+	for (int i = 0; i < static_cast<int>(max_dirty_rects); i++)
+	{
+		rects.add(overlay_pixel_rect {i * 10, i, i * 10 + 5, i + 1});
+	}
+	CHECK_EQ(rects.size(), max_dirty_rects);
+
+	rects.add(overlay_pixel_rect {500, 100, 510, 120});
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {0, 0, 510, 120}));
+}
+
+OVERLAY_TEST(dirty_rects, add_other_list)
+{
+	overlay_dirty_rects first;
+	overlay_dirty_rects second;
+	first.add(overlay_pixel_rect {0, 0, 10, 10});
+	second.add(overlay_pixel_rect {20, 20, 30, 30});
+	second.add(overlay_pixel_rect {40, 40, 50, 50});
+
+	first.add(second);
+	CHECK_EQ(first.size(), 3u);
+	CHECK(same_rect(first.rects[2], overlay_pixel_rect {40, 40, 50, 50}));
+}
+
+OVERLAY_TEST(dirty_rects, clip_to_frame)
+{
+	overlay_dirty_rects rects;
+	rects.add(overlay_pixel_rect {-10, -10, 20, 20});
+	rects.add(overlay_pixel_rect {200, 0, 300, 10});
+	rects.add(overlay_pixel_rect {90, 40, 120, 60});
+
+	rects.clip(100, 50);
+	CHECK_EQ(rects.size(), 2u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {0, 0, 20, 20}));
+	CHECK(same_rect(rects.rects[1], overlay_pixel_rect {90, 40, 100, 50}));
+}
+
+OVERLAY_TEST(dirty_rects, set_whole_and_clear)
+{
+	overlay_dirty_rects rects;
+	rects.add(overlay_pixel_rect {1, 1, 2, 2});
+	rects.set_whole(64, 32);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK_EQ(rects.get_area(), 64u * 32u);
+
+	rects.clear();
+	CHECK_EQ(rects.size(), 0u);
+	CHECK(rects.begin() == rects.end());
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_flight_recorder.h"
+#include "overlay_test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// records kept by recorder, older ones are overwritten
+static const size_t kept_records = 4096;
+
+struct dumped_record
+{
+	unsigned long long index;
+	std::string event;
+	int overlay_id;
+	int a;
+	int b;
+};
+
+// lines of dump after its header: "index seconds.ms thread id event overlay id a b"
+static std::vector<dumped_record> dump_records(const char* name)
+{
+	const fs::path directory = fs::temp_directory_path() / "overlay_tests";
+	fs::create_directories(directory);
+	const fs::path file = directory / name;
+	CHECK_EQ(dump_flight_recorder(file.string()), 0);
+
+	std::vector<dumped_record> records;
+	std::ifstream input(file);
+	std::string line;
+	std::getline(input, line);
+	CHECK(line.find("flight recorder, ") == 0);
+	while (std::getline(input, line))
+	{
+		std::istringstream fields(line);
+		dumped_record record;
+		std::string time;
+		std::string thread;
+		std::string thread_id;
+		std::string overlay;
+		fields >> record.index >> time >> thread >> thread_id >> record.event >> overlay >> record.overlay_id >> record.a >> record.b;
+		CHECK(!fields.fail());
+		records.push_back(record);
+	}
+	return records;
+}
+
+OVERLAY_TEST(flight_recorder, dump_has_recorded_events)
+{
+	record_flight_event(overlay_flight_event::window_created, 7);
+	record_flight_event(overlay_flight_event::frame_applied, 7, 640, 480);
+	record_flight_event(overlay_flight_event::window_destroyed, 7);
+
+	const std::vector<dumped_record> records = dump_records("flight_events.txt");
+	CHECK(records.size() >= 3u);
+	if (records.size() < 3u)
+	{
+		return;
+	}
+
+	const dumped_record* last = &records[records.size() - 3];
+	CHECK_EQ(last[0].event, std::string("window_created"));
+	CHECK_EQ(last[1].event, std::string("frame_applied"));
+	CHECK_EQ(last[1].overlay_id, 7);
+	CHECK_EQ(last[1].a, 640);
+	CHECK_EQ(last[1].b, 480);
+	CHECK_EQ(last[2].event, std::string("window_destroyed"));
+	CHECK_EQ(last[2].index, last[0].index + 2);
+}
+
+OVERLAY_TEST(flight_recorder, only_newest_records_are_kept)
+{
+	for (int i = 0; i < static_cast<int>(kept_records) + 100; i++)
+	{
+		record_flight_event(overlay_flight_event::hook_event, 1, i);
+	}
+
+	const std::vector<dumped_record> records = dump_records("flight_wrap.txt");
+	CHECK_EQ(records.size(), kept_records);
+	CHECK_EQ(records.front().a, 100);
+	CHECK_EQ(records.back().a, static_cast<int>(kept_records) + 99);
+}
+
+// records of all threads are in dump, each thread's records in its order
+OVERLAY_TEST(flight_recorder, threads_record_at_once)
+{
+	const int threads_count = 4;
+	const int per_thread = static_cast<int>(kept_records) / threads_count;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threads_count; t++)
+	{
+		threads.emplace_back([t]() {
+			for (int i = 0; i < per_thread; i++)
+			{
+				record_flight_event(overlay_flight_event::command, 100 + t, i);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	const std::vector<dumped_record> records = dump_records("flight_threads.txt");
+	CHECK_EQ(records.size(), kept_records);
+	// older records of a thread could be overwritten, its first kept one starts the check
+	std::vector<int> next(threads_count, -1);
+	int wrong = 0;
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const int t = records[i].overlay_id - 100;
+		wrong += i != 0 && records[i].index != records[i - 1].index + 1 ? 1 : 0;
+		wrong += t < 0 || t >= threads_count || (next[t] != -1 && records[i].a != next[t]) ? 1 : 0;
+		if (t >= 0 && t < threads_count)
+		{
+			next[t] = records[i].a + 1;
+		}
+	}
+	CHECK_EQ(wrong, 0);
+	for (int t = 0; t < threads_count; t++)
+	{
+		CHECK_EQ(next[t], per_thread);
+	}
+}
+
+OVERLAY_TEST(flight_recorder, crash_dump_is_off_without_path)
+{
+	CHECK_EQ(set_flight_recorder_crash_dump(""), 0);
+	CHECK_EQ(dump_flight_recorder((fs::temp_directory_path() / "overlay_tests" / "missing" / "dump.txt").string()), -1);
+}
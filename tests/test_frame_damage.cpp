@@ -0,0 +1,229 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_damage.h"
+#include "overlay_test.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+struct test_frame
+{
+	int width;
+	int height;
+	size_t pitch;
+	std::vector<uint8_t> pixels;
+
+	test_frame(int frame_width, int frame_height, size_t padding = 0)
+	{
+		width = frame_width;
+		height = frame_height;
+		pitch = static_cast<size_t>(width) * 4 + padding;
+		pixels.assign(pitch * height, 0x40);
+	}
+
+	uint8_t* pixel(int x, int y)
+	{
+		return pixels.data() + y * pitch + x * 4;
+	}
+};
+
+static bool same_rect(const overlay_pixel_rect& a, const overlay_pixel_rect& b)
+{
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool is_damaged(const overlay_dirty_rects& damage, int x, int y)
+{
+	for (const overlay_pixel_rect& rect : damage)
+	{
+		if (rect.contains(x, y))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+OVERLAY_TEST(frame_damage, first_frame_is_whole)
+{
+	test_frame frame(100, 70);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {0, 0, 100, 70}));
+}
+
+OVERLAY_TEST(frame_damage, same_frame_has_no_damage)
+{
+	test_frame frame(300, 200);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 0u);
+}
+
+OVERLAY_TEST(frame_damage, changed_pixel_damages_its_tile)
+{
+	test_frame frame(300, 200);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	frame.pixel(130, 70)[1] ^= 1;
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {128, 64, 192, 128}));
+
+	// change is in retained frame now
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 0u);
+}
+
+OVERLAY_TEST(frame_damage, edge_tiles_are_cut_by_frame)
+{
+	test_frame frame(300, 200);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	frame.pixel(299, 199)[3] = 0;
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {256, 192, 300, 200}));
+}
+
+OVERLAY_TEST(frame_damage, column_of_tiles_is_one_rect)
+{
+	test_frame frame(256, 256);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	// two tiles wide area in every band
+	for (int y = 0; y < frame.height; y += 32)
+	{
+		frame.pixel(64, y)[0] ^= 0xFF;
+		frame.pixel(190, y)[0] ^= 0xFF;
+	}
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {64, 0, 192, 256}));
+}
+
+OVERLAY_TEST(frame_damage, row_padding_is_ignored)
+{
+	test_frame frame(100, 100, 24);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	for (int y = 0; y < frame.height; y++)
+	{
+		memset(frame.pixel(frame.width, y), 0xEE, 24);
+	}
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 0u);
+}
+
+OVERLAY_TEST(frame_damage, new_size_is_whole)
+{
+	test_frame frame(100, 100);
+	test_frame bigger(120, 100);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	rects.clear();
+	damage.find_damage(bigger.pixels.data(), bigger.pitch, bigger.width, bigger.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK(same_rect(rects.rects[0], overlay_pixel_rect {0, 0, 120, 100}));
+}
+
+OVERLAY_TEST(frame_damage, update_keeps_retained_frame)
+{
+	test_frame frame(200, 100);
+	overlay_frame_damage damage;
+	overlay_dirty_rects rects;
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+	// frame came with its dirty rect, next frame without rects is compared with it
+	frame.pixel(10, 10)[2] = 0;
+	overlay_dirty_rects known;
+	known.add(overlay_pixel_rect {10, 10, 11, 11});
+	damage.update(frame.pixels.data(), frame.pitch, frame.width, frame.height, known);
+
+	rects.clear();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 0u);
+
+	damage.reset();
+	damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+	CHECK_EQ(rects.size(), 1u);
+}
+
+// every changed pixel has to be inside damage
+OVERLAY_TEST(frame_damage, random_changes_are_covered)
+{
+	std::mt19937 random(5);
+	for (int round = 0; round < 40; round++)
+	{
+		const int width = 1 + random() % 400;
+		const int height = 1 + random() % 300;
+		test_frame frame(width, height, (random() % 3) * 4);
+		overlay_frame_damage damage;
+		overlay_dirty_rects rects;
+		damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+
+		for (int step = 0; step < 5; step++)
+		{
+			std::vector<uint8_t> before = frame.pixels;
+			const int changes = random() % 6;
+			for (int i = 0; i < changes; i++)
+			{
+				frame.pixel(random() % width, random() % height)[random() % 4] ^= 1 + random() % 255;
+			}
+
+			rects.clear();
+			damage.find_damage(frame.pixels.data(), frame.pitch, frame.width, frame.height, rects);
+			for (int y = 0; y < height; y++)
+			{
+				for (int x = 0; x < width; x++)
+				{
+					const size_t at = y * frame.pitch + x * 4;
+					if (memcmp(before.data() + at, frame.pixels.data() + at, 4) != 0)
+					{
+						CHECK(is_damaged(rects, x, y));
+					}
+				}
+			}
+			for (const overlay_pixel_rect& rect : rects)
+			{
+				CHECK(rect.left >= 0 && rect.top >= 0 && rect.right <= width && rect.bottom <= height);
+				CHECK(rect.left % overlay_frame_damage::tile_size == 0 && rect.top % overlay_frame_damage::tile_size == 0);
+			}
+		}
+	}
+}
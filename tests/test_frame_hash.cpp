@@ -0,0 +1,112 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_hash.h"
+#include "overlay_test.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+static std::vector<uint8_t> random_bytes(size_t size, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<uint8_t> bytes(size);
+	for (uint8_t& byte : bytes)
+	{
+		byte = static_cast<uint8_t>(random());
+	}
+	return bytes;
+}
+
+// sizes around stripe size and odd tails, data at odd address
+OVERLAY_TEST(frame_hash, every_isa_gives_scalar_hash)
+{
+	const overlay_isa isas[] = {overlay_isa::sse2, overlay_isa::avx2, overlay_isa::neon};
+	const std::vector<uint8_t> bytes = random_bytes(70000, 1);
+
+	for (size_t size : {0, 1, 3, 4, 63, 64, 65, 127, 128, 129, 1000, 4096, 65537})
+	{
+		for (size_t start : {0, 1})
+		{
+			uint64_t expected = 0;
+			CHECK(hash_frame_pixels_for_isa(overlay_isa::scalar, bytes.data() + start, size, 42, expected));
+			CHECK_EQ(hash_frame_pixels(bytes.data() + start, size, 42), expected);
+
+			for (overlay_isa isa : isas)
+			{
+				uint64_t hash = 0;
+				if (hash_frame_pixels_for_isa(isa, bytes.data() + start, size, 42, hash))
+				{
+					CHECK_EQ(hash, expected);
+				}
+			}
+		}
+	}
+}
+
+OVERLAY_TEST(frame_hash, isa_support_is_reported)
+{
+	uint64_t hash = 0;
+	const uint8_t byte = 0;
+	CHECK_EQ(hash_frame_pixels_for_isa(overlay_isa::avx2, &byte, 1, 0, hash), cpu_has_isa(overlay_isa::avx2));
+	CHECK(cpu_has_isa(overlay_isa::scalar));
+}
+
+OVERLAY_TEST(frame_hash, changes_change_hash)
+{
+	std::vector<uint8_t> bytes = random_bytes(1920 * 4 * 8, 2);
+	const uint64_t original = hash_frame_pixels(bytes.data(), bytes.size(), 0);
+
+	CHECK(hash_frame_pixels(bytes.data(), bytes.size(), 1) != original);
+	CHECK(hash_frame_pixels(bytes.data(), bytes.size() - 4, 0) != original);
+
+	// one bit anywhere, in stripes and in tail
+	for (size_t at : {size_t(0), size_t(31), size_t(1000), bytes.size() - 1})
+	{
+		bytes[at] ^= 0x10;
+		CHECK(hash_frame_pixels(bytes.data(), bytes.size(), 0) != original);
+		bytes[at] ^= 0x10;
+	}
+	CHECK_EQ(hash_frame_pixels(bytes.data(), bytes.size(), 0), original);
+
+	// same 64 bytes moved to other stripe
+	std::vector<uint8_t> moved = bytes;
+	memcpy(moved.data(), bytes.data() + 64, 64);
+	memcpy(moved.data() + 64, bytes.data(), 64);
+	CHECK(hash_frame_pixels(moved.data(), moved.size(), 0) != original);
+}
+
+OVERLAY_TEST(frame_hash, row_padding_is_not_hashed)
+{
+	const int width = 33;
+	const int rows = 9;
+	const size_t row_size = width * 4;
+	const size_t pitch = row_size + 20;
+	std::vector<uint8_t> padded = random_bytes(pitch * rows, 3);
+
+	const uint64_t hash = hash_frame_rows(padded.data(), row_size, pitch, rows, 7);
+	for (int y = 0; y < rows; y++)
+	{
+		memset(padded.data() + y * pitch + row_size, y, pitch - row_size);
+	}
+	CHECK_EQ(hash_frame_rows(padded.data(), row_size, pitch, rows, 7), hash);
+
+	padded[pitch * 4 + 5] ^= 1;
+	CHECK(hash_frame_rows(padded.data(), row_size, pitch, rows, 7) != hash);
+
+	// rows without padding are hashed as one block
+	std::vector<uint8_t> packed = random_bytes(row_size * rows, 4);
+	CHECK_EQ(hash_frame_rows(packed.data(), row_size, row_size, rows, 7), hash_frame_pixels(packed.data(), packed.size(), 7));
+}
@@ -0,0 +1,108 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_dirty_rects.h"
+#include "overlay_frame_layout.h"
+#include "overlay_test.h"
+
+#include <stdint.h>
+
+OVERLAY_TEST(frame_layout, packed_frame_has_to_fill_buffer)
+{
+	size_t stride = 0;
+	CHECK(is_frame_in_buffer(10 * 5 * 4, 10, 5, stride, 0));
+	CHECK_EQ(stride, 40u);
+
+	stride = 0;
+	CHECK(!is_frame_in_buffer(10 * 5 * 4 + 4, 10, 5, stride, 0));
+	stride = 0;
+	CHECK(!is_frame_in_buffer(10 * 5 * 4 - 4, 10, 5, stride, 0));
+}
+
+OVERLAY_TEST(frame_layout, explicit_layout_can_be_inside_bigger_buffer)
+{
+	// last row does not need padding after it
+	size_t stride = 64;
+	CHECK(is_frame_in_buffer(100 + 64 * 4 + 40, 10, 5, stride, 100));
+	CHECK_EQ(stride, 64u);
+
+	stride = 64;
+	CHECK(!is_frame_in_buffer(100 + 64 * 4 + 39, 10, 5, stride, 100));
+
+	// offset alone keeps packed rows
+	stride = 0;
+	CHECK(is_frame_in_buffer(1000, 10, 5, stride, 800));
+	CHECK_EQ(stride, 40u);
+	stride = 0;
+	CHECK(!is_frame_in_buffer(1000, 10, 5, stride, 801));
+}
+
+OVERLAY_TEST(frame_layout, bad_sizes_are_rejected)
+{
+	size_t stride = 36;
+	CHECK(!is_frame_in_buffer(1000, 10, 5, stride, 0));
+	stride = 0;
+	CHECK(!is_frame_in_buffer(1000, 0, 5, stride, 0));
+	stride = 0;
+	CHECK(!is_frame_in_buffer(1000, 10, -1, stride, 0));
+	stride = 0;
+	CHECK(!is_frame_in_buffer(0, INT32_MAX, INT32_MAX, stride, 0));
+}
+
+// sums that wrap around size_t would look like a small frame
+OVERLAY_TEST(frame_layout, overflowing_layout_is_rejected)
+{
+	size_t stride = SIZE_MAX / 2 + 1;
+	CHECK(!is_frame_in_buffer(4096, 1, 3, stride, 0));
+
+	stride = SIZE_MAX / 4;
+	CHECK(!is_frame_in_buffer(4096, 1, 5, stride, 0));
+
+	// stride * rows fits, adding row size does not
+	stride = (SIZE_MAX - 3) / 2;
+	CHECK(!is_frame_in_buffer(4096, 1, 3, stride, 0));
+
+	stride = 0;
+	CHECK(!is_frame_in_buffer(4096, 4, 4, stride, SIZE_MAX - 8));
+	stride = 16;
+	CHECK(!is_frame_in_buffer(4096, 4, 4, stride, SIZE_MAX));
+
+	// one row does not use stride
+	stride = SIZE_MAX;
+	CHECK(is_frame_in_buffer(4096, 4, 1, stride, 0));
+}
+
+OVERLAY_TEST(frame_layout, rect_edges_are_clamped)
+{
+	const overlay_pixel_rect big = make_pixel_rect(INT32_MAX, 10, INT32_MAX, 5);
+	CHECK_EQ(big.left, INT32_MAX);
+	CHECK_EQ(big.right, INT32_MAX);
+	CHECK(big.is_empty());
+
+	const overlay_pixel_rect wide = make_pixel_rect(-5, INT32_MIN, INT32_MAX, INT32_MAX);
+	CHECK_EQ(wide.left, -5);
+	CHECK_EQ(wide.right, INT32_MAX - 5);
+	CHECK_EQ(wide.top, INT32_MIN);
+	CHECK_EQ(wide.bottom, -1);
+
+	const overlay_pixel_rect negative = make_pixel_rect(10, 10, -20, 5);
+	CHECK(negative.is_empty());
+
+	// huge rect from producer ends up as the whole frame
+	overlay_dirty_rects rects;
+	rects.add(make_pixel_rect(-100, -100, INT32_MAX, INT32_MAX));
+	rects.clip(640, 480);
+	CHECK_EQ(rects.size(), 1u);
+	CHECK_EQ(rects.get_area(), 640u * 480u);
+}
@@ -0,0 +1,191 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_mailbox.h"
+#include "overlay_test.h"
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+
+static void write_frame(overlay_frame_mailbox& mailbox, int width, int height, const overlay_dirty_rects& rects, uint8_t value)
+{
+	overlay_frame_slot& slot = mailbox.begin_write(width, height, rects);
+	memset(slot.pixels.data(), value, slot.pixels.size());
+	mailbox.publish();
+}
+
+static overlay_dirty_rects make_rects(int left, int top, int right, int bottom)
+{
+	overlay_dirty_rects rects;
+	rects.add(overlay_pixel_rect {left, top, right, bottom});
+	return rects;
+}
+
+OVERLAY_TEST(frame_mailbox, empty_until_published)
+{
+	overlay_frame_mailbox mailbox;
+	CHECK(mailbox.take() == nullptr);
+
+	mailbox.begin_write(8, 8, make_rects(0, 0, 8, 8));
+	CHECK(mailbox.take() == nullptr);
+
+	mailbox.publish();
+	overlay_frame_slot* slot = mailbox.take();
+	CHECK(slot != nullptr);
+	CHECK(mailbox.take() == nullptr);
+}
+
+OVERLAY_TEST(frame_mailbox, first_frame_is_whole)
+{
+	overlay_frame_mailbox mailbox;
+	write_frame(mailbox, 16, 8, make_rects(1, 1, 2, 2), 1);
+
+	overlay_frame_slot* slot = mailbox.take();
+	CHECK(slot != nullptr);
+	CHECK_EQ(slot->width, 16);
+	CHECK_EQ(slot->height, 8);
+	CHECK_EQ(slot->dirty_rects.get_area(), 16u * 8u);
+}
+
+OVERLAY_TEST(frame_mailbox, newest_frame_wins_with_rects_of_skipped_ones)
+{
+	overlay_frame_mailbox mailbox;
+	write_frame(mailbox, 16, 16, overlay_dirty_rects(), 1);
+	mailbox.take();
+
+	write_frame(mailbox, 16, 16, make_rects(0, 0, 4, 4), 2);
+	write_frame(mailbox, 16, 16, make_rects(8, 8, 12, 12), 3);
+
+	overlay_frame_slot* slot = mailbox.take();
+	CHECK(slot != nullptr);
+	CHECK_EQ(slot->pixels[0], 3);
+	CHECK_EQ(slot->dirty_rects.size(), 2u);
+	CHECK(mailbox.take() == nullptr);
+
+	// rects of a taken frame are not carried to the next one
+	write_frame(mailbox, 16, 16, make_rects(4, 4, 5, 5), 4);
+	slot = mailbox.take();
+	CHECK(slot != nullptr);
+	CHECK_EQ(slot->dirty_rects.size(), 1u);
+	CHECK_EQ(slot->dirty_rects.get_area(), 1u);
+}
+
+OVERLAY_TEST(frame_mailbox, full_frame_after_request_or_resize)
+{
+	overlay_frame_mailbox mailbox;
+	write_frame(mailbox, 16, 16, overlay_dirty_rects(), 1);
+	mailbox.take();
+
+	mailbox.request_full_frame();
+	CHECK(mailbox.is_full_frame_requested());
+	write_frame(mailbox, 16, 16, make_rects(0, 0, 1, 1), 2);
+	CHECK(!mailbox.is_full_frame_requested());
+	CHECK_EQ(mailbox.take()->dirty_rects.get_area(), 16u * 16u);
+
+	write_frame(mailbox, 20, 10, make_rects(0, 0, 1, 1), 3);
+	CHECK_EQ(mailbox.take()->dirty_rects.get_area(), 20u * 10u);
+}
+
+OVERLAY_TEST(frame_mailbox, buffers_are_reused)
+{
+	overlay_frame_mailbox mailbox;
+	overlay_frame_slot& first = mailbox.begin_write(32, 32, overlay_dirty_rects());
+	CHECK(first.reallocated);
+	mailbox.publish();
+
+	// slots go around producer, mailbox and consumer, after a few frames each has a buffer
+	for (int i = 0; i < 3; i++)
+	{
+		mailbox.take();
+		mailbox.begin_write(32, 32, overlay_dirty_rects());
+		mailbox.publish();
+	}
+	CHECK_EQ(mailbox.get_allocated_bytes(), 3u * 32u * 32u * 4u);
+
+	for (int i = 0; i < 6; i++)
+	{
+		overlay_frame_slot& slot = mailbox.begin_write(32, 32, overlay_dirty_rects());
+		CHECK(!slot.reallocated);
+		mailbox.publish();
+		mailbox.take();
+	}
+
+	// much smaller overlay gives memory back
+	overlay_frame_slot& slot = mailbox.begin_write(8, 8, overlay_dirty_rects());
+	CHECK(slot.reallocated);
+	CHECK(mailbox.get_allocated_bytes() < 3u * 32u * 32u * 4u);
+}
+
+// consumer never sees a frame while producer writes it and frames come in order
+OVERLAY_TEST(frame_mailbox, concurrent_frames_are_not_torn)
+{
+	overlay_frame_mailbox mailbox;
+	const uint32_t frames = 20000;
+	std::atomic<bool> done {false};
+	int torn_frames = 0;
+	int taken_frames = 0;
+	int64_t last_number = -1;
+
+	std::thread consumer([&]() {
+		while (true)
+		{
+			const bool finished = done.load();
+			overlay_frame_slot* slot = mailbox.take();
+			if (slot == nullptr)
+			{
+				if (finished)
+				{
+					break;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+
+			// every pixel holds number of the frame, consumer can skip any number of frames but not go back
+			uint32_t number = 0;
+			memcpy(&number, slot->pixels.data(), sizeof(number));
+			for (size_t at = 0; at < slot->pixels.size(); at += sizeof(number))
+			{
+				if (memcmp(slot->pixels.data() + at, &number, sizeof(number)) != 0)
+				{
+					torn_frames++;
+					break;
+				}
+			}
+			if (number <= last_number)
+			{
+				torn_frames++;
+			}
+			last_number = number;
+			taken_frames++;
+		}
+	});
+
+	for (uint32_t number = 0; number < frames; number++)
+	{
+		overlay_frame_slot& slot = mailbox.begin_write(64, 16, overlay_dirty_rects());
+		for (size_t at = 0; at < slot.pixels.size(); at += sizeof(number))
+		{
+			memcpy(slot.pixels.data() + at, &number, sizeof(number));
+		}
+		mailbox.publish();
+	}
+	done = true;
+	consumer.join();
+
+	CHECK_EQ(torn_frames, 0);
+	CHECK(taken_frames > 0);
+	CHECK_EQ(last_number, frames - 1);
+}
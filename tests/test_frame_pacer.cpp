@@ -0,0 +1,157 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_frame_pacer.h"
+#include "overlay_test.h"
+
+#include <thread>
+
+static overlay_dirty_rects make_rects(int left, int top, int right, int bottom)
+{
+	overlay_dirty_rects rects;
+	rects.add(overlay_pixel_rect {left, top, right, bottom});
+	return rects;
+}
+
+// limit is low enough that a test never misses the interval of 200 ms
+static const int test_fps = 5;
+
+OVERLAY_TEST(frame_pacer, no_limit_accepts_all)
+{
+	overlay_frame_pacer pacer;
+	CHECK_EQ(pacer.get_frame_rate_limit(), 0);
+	for (int i = 0; i < 10; i++)
+	{
+		CHECK(pacer.accept_frame(overlay_dirty_rects()));
+	}
+	CHECK_EQ(pacer.get_accepted_count(), 10u);
+	CHECK_EQ(pacer.get_dropped_count(), 0u);
+}
+
+OVERLAY_TEST(frame_pacer, early_frame_rects_go_to_next_frame)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK_EQ(pacer.get_frame_rate_limit(), test_fps);
+
+	CHECK(pacer.accept_frame(make_rects(0, 0, 4, 4)));
+	CHECK(!pacer.accept_frame(make_rects(10, 10, 20, 20)));
+	CHECK_EQ(pacer.get_dropped_count(), 1u);
+
+	overlay_dirty_rects next = make_rects(30, 30, 40, 40);
+	pacer.add_dropped_rects(next, 100, 100);
+	CHECK_EQ(next.size(), 2u);
+	CHECK_EQ(next.get_area(), 200u);
+
+	// rects are added once
+	overlay_dirty_rects other = make_rects(30, 30, 40, 40);
+	pacer.add_dropped_rects(other, 100, 100);
+	CHECK_EQ(other.size(), 1u);
+}
+
+OVERLAY_TEST(frame_pacer, dropped_whole_frame_makes_next_whole)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK(pacer.accept_frame(overlay_dirty_rects()));
+	CHECK(!pacer.accept_frame(overlay_dirty_rects()));
+
+	overlay_dirty_rects next = make_rects(0, 0, 1, 1);
+	pacer.add_dropped_rects(next, 64, 32);
+	CHECK_EQ(next.get_area(), 64u * 32u);
+}
+
+OVERLAY_TEST(frame_pacer, held_frame_is_taken_when_its_time_comes)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK(pacer.accept_frame(make_rects(0, 0, 8, 8)));
+	CHECK(!pacer.has_held_frame());
+
+	// last frame of a burst, producer sends nothing after it
+	CHECK(!pacer.accept_frame(make_rects(2, 2, 6, 6)));
+	pacer.hold_frame();
+	CHECK(pacer.has_held_frame());
+
+	overlay_dirty_rects rects;
+	CHECK(!pacer.take_held_frame(rects));
+	const std::chrono::steady_clock::duration delay = pacer.get_held_frame_delay();
+	CHECK(delay > std::chrono::steady_clock::duration::zero());
+	CHECK(delay <= std::chrono::milliseconds(1000 / test_fps));
+
+	std::this_thread::sleep_for(delay);
+	CHECK(pacer.get_held_frame_delay() == std::chrono::steady_clock::duration::zero());
+	CHECK(pacer.take_held_frame(rects));
+	CHECK_EQ(rects.size(), 1u);
+	CHECK_EQ(rects.get_area(), 16u);
+
+	// taken frame is on the grid like an accepted one and its rects are not added again
+	CHECK(!pacer.has_held_frame());
+	CHECK_EQ(pacer.get_accepted_count(), 2u);
+	overlay_dirty_rects next = make_rects(0, 0, 1, 1);
+	pacer.add_dropped_rects(next, 16, 8);
+	CHECK_EQ(next.size(), 1u);
+	CHECK(!pacer.accept_frame(overlay_dirty_rects()));
+}
+
+OVERLAY_TEST(frame_pacer, newest_dropped_frame_is_held)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK(pacer.accept_frame(overlay_dirty_rects()));
+
+	CHECK(!pacer.accept_frame(overlay_dirty_rects()));
+	pacer.hold_frame();
+	CHECK(!pacer.accept_frame(make_rects(0, 0, 2, 2)));
+	pacer.hold_frame();
+
+	std::this_thread::sleep_for(pacer.get_held_frame_delay());
+	overlay_dirty_rects rects = make_rects(0, 0, 1, 1);
+	CHECK(pacer.take_held_frame(rects));
+	// one of dropped frames was whole
+	CHECK_EQ(rects.size(), 0u);
+	CHECK(!pacer.has_held_frame());
+}
+
+OVERLAY_TEST(frame_pacer, accepted_frame_replaces_held_one)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK(pacer.accept_frame(overlay_dirty_rects()));
+
+	CHECK(!pacer.accept_frame(overlay_dirty_rects()));
+	pacer.hold_frame();
+
+	std::this_thread::sleep_for(pacer.get_held_frame_delay());
+	CHECK(pacer.accept_frame(make_rects(0, 0, 1, 1)));
+	CHECK(!pacer.has_held_frame());
+
+	overlay_dirty_rects rects;
+	CHECK(!pacer.take_held_frame(rects));
+}
+
+OVERLAY_TEST(frame_pacer, removed_limit_frees_held_frame)
+{
+	overlay_frame_pacer pacer;
+	pacer.set_frame_rate_limit(test_fps);
+	CHECK(pacer.accept_frame(overlay_dirty_rects()));
+
+	CHECK(!pacer.accept_frame(overlay_dirty_rects()));
+	pacer.hold_frame();
+
+	pacer.set_frame_rate_limit(0);
+	CHECK(pacer.get_held_frame_delay() == std::chrono::steady_clock::duration::zero());
+	overlay_dirty_rects rects;
+	CHECK(pacer.take_held_frame(rects));
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_hit_index.h"
+#include "overlay_test.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+static overlay_hit_rect make_hit_rect(int overlay_id, int left, int top, int right, int bottom, const overlay_alpha_coverage* coverage = nullptr)
+{
+	return overlay_hit_rect {overlay_id, overlay_pixel_rect {left, top, right, bottom}, coverage};
+}
+
+// topmost rect containing the point, without index
+static int find_hit(const std::vector<overlay_hit_rect>& rects, int x, int y)
+{
+	for (const overlay_hit_rect& n : rects)
+	{
+		if (n.rect.contains(x, y))
+		{
+			return n.overlay_id;
+		}
+	}
+	return 0;
+}
+
+OVERLAY_TEST(hit_index, nothing_published_is_not_hit)
+{
+	overlay_hit_index index;
+	overlay_hit hit;
+	CHECK(!index.hit_test(0, 0, hit));
+
+	index.publish(std::vector<overlay_hit_rect>());
+	CHECK(!index.hit_test(0, 0, hit));
+}
+
+OVERLAY_TEST(hit_index, topmost_overlay_is_hit)
+{
+	overlay_hit_index index;
+	index.publish({make_hit_rect(1, 100, 100, 200, 200), make_hit_rect(2, 150, 150, 400, 300)});
+
+	overlay_hit hit;
+	CHECK(index.hit_test(160, 170, hit));
+	CHECK_EQ(hit.overlay_id, 1);
+	CHECK_EQ(hit.x, 60);
+	CHECK_EQ(hit.y, 70);
+
+	CHECK(index.hit_test(250, 250, hit));
+	CHECK_EQ(hit.overlay_id, 2);
+	CHECK_EQ(hit.x, 100);
+	CHECK_EQ(hit.y, 100);
+
+	// right and bottom edges are outside
+	CHECK(!index.hit_test(400, 200, hit));
+	CHECK(!index.hit_test(160, 300, hit));
+	CHECK(!index.hit_test(99, 100, hit));
+}
+
+OVERLAY_TEST(hit_index, empty_rects_are_skipped)
+{
+	overlay_hit_index index;
+	index.publish({make_hit_rect(1, 10, 10, 10, 50), make_hit_rect(2, 0, 0, 100, 100)});
+
+	overlay_hit hit;
+	CHECK(index.hit_test(10, 20, hit));
+	CHECK_EQ(hit.overlay_id, 2);
+}
+
+OVERLAY_TEST(hit_index, transparent_part_goes_to_overlay_below)
+{
+	// left half of upper overlay is transparent
+	const int width = 64;
+	const int height = 32;
+	std::vector<uint8_t> pixels(width * height * 4, 0);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = width / 2; x < width; x++)
+		{
+			pixels[(y * width + x) * 4 + 3] = 255;
+		}
+	}
+	overlay_alpha_coverage coverage;
+	overlay_dirty_rects whole;
+	whole.set_whole(width, height);
+	coverage.update(pixels.data(), width * 4, width, height, whole);
+
+	overlay_hit_index index;
+	index.publish({make_hit_rect(1, 0, 0, width, height, &coverage), make_hit_rect(2, 0, 0, 200, 200)});
+
+	overlay_hit hit;
+	CHECK(index.hit_test(5, 5, hit));
+	CHECK_EQ(hit.overlay_id, 2);
+	CHECK(index.hit_test(40, 5, hit));
+	CHECK_EQ(hit.overlay_id, 1);
+	CHECK_EQ(hit.x, 40);
+}
+
+OVERLAY_TEST(hit_index, rects_over_limit_are_not_indexed)
+{
+	const int max_rects = overlay_hit_index::max_rects;
+	std::vector<overlay_hit_rect> rects;
+	for (int i = 0; i < max_rects + 4; i++)
+	{
+		rects.push_back(make_hit_rect(i + 1, i * 10, 0, i * 10 + 10, 10));
+	}
+	overlay_hit_index index;
+	index.publish(rects);
+
+	overlay_hit hit;
+	CHECK(index.hit_test((max_rects - 1) * 10 + 5, 5, hit));
+	CHECK_EQ(hit.overlay_id, max_rects);
+	CHECK(!index.hit_test(max_rects * 10 + 5, 5, hit));
+}
+
+OVERLAY_TEST(hit_index, new_snapshot_replaces_old)
+{
+	overlay_hit_index index;
+	index.publish({make_hit_rect(1, 0, 0, 100, 100)});
+	index.publish({make_hit_rect(2, 500, 500, 600, 600)});
+	index.publish({make_hit_rect(3, 1000, 0, 1100, 100)});
+
+	overlay_hit hit;
+	CHECK(!index.hit_test(50, 50, hit));
+	CHECK(!index.hit_test(550, 550, hit));
+	CHECK(index.hit_test(1050, 50, hit));
+	CHECK_EQ(hit.overlay_id, 3);
+}
+
+// grid cells give the same answers as checking every rect, also for screens left and above of primary one
+OVERLAY_TEST(hit_index, random_rects_match_reference)
+{
+	std::mt19937 random(23);
+	overlay_hit_index index;
+	for (int round = 0; round < 50; round++)
+	{
+		std::vector<overlay_hit_rect> rects;
+		const int count = 1 + random() % overlay_hit_index::max_rects;
+		for (int i = 0; i < count; i++)
+		{
+			const int left = -3000 + static_cast<int>(random() % 6000);
+			const int top = -2000 + static_cast<int>(random() % 4000);
+			rects.push_back(make_hit_rect(i + 1, left, top, left + 1 + random() % 1500, top + 1 + random() % 1000));
+		}
+		index.publish(rects);
+
+		for (int i = 0; i < 2000; i++)
+		{
+			const int x = -3500 + static_cast<int>(random() % 8000);
+			const int y = -2500 + static_cast<int>(random() % 5500);
+			overlay_hit hit;
+			const bool found = index.hit_test(x, y, hit);
+			const int expected = find_hit(rects, x, y);
+			CHECK_EQ(found ? hit.overlay_id : 0, expected);
+		}
+	}
+}
+
+// hook thread tests while overlay thread publishes, answers always come from one whole snapshot
+OVERLAY_TEST(hit_index, hit_test_during_publish)
+{
+	overlay_hit_index index;
+	const std::vector<overlay_hit_rect> left = {make_hit_rect(1, 0, 0, 100, 100), make_hit_rect(2, 0, 0, 1000, 1000)};
+	const std::vector<overlay_hit_rect> right = {make_hit_rect(3, 900, 900, 1000, 1000), make_hit_rect(4, 0, 0, 1000, 1000)};
+	index.publish(left);
+
+	std::atomic<bool> done {false};
+	std::thread publisher([&]() {
+		for (int i = 0; i < 20000; i++)
+		{
+			index.publish(i % 2 == 0 ? right : left);
+		}
+		done = true;
+	});
+
+	int wrong = 0;
+	while (!done.load())
+	{
+		overlay_hit hit;
+		if (!index.hit_test(50, 50, hit) || (hit.overlay_id != 1 && hit.overlay_id != 4))
+		{
+			wrong++;
+		}
+		if (!index.hit_test(950, 950, hit) || (hit.overlay_id != 2 && hit.overlay_id != 3))
+		{
+			wrong++;
+		}
+	}
+	publisher.join();
+	CHECK_EQ(wrong, 0);
+}
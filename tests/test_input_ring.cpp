@@ -0,0 +1,352 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_input_ring.h"
+#include "overlay_test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static const size_t capacity = overlay_input_ring::capacity;
+
+static overlay_input_event make_event(int32_t number)
+{
+	overlay_input_event event = {};
+	event.type = static_cast<int32_t>(overlay_input_type::mouse_down);
+	event.code = number;
+	event.x = number * 2;
+	event.count = 1;
+	return event;
+}
+
+OVERLAY_TEST(input_ring, empty_ring_gives_nothing)
+{
+	overlay_input_ring ring;
+	overlay_input_event event;
+	CHECK(!ring.peek(event));
+	CHECK(!ring.pop(event));
+	CHECK_EQ(ring.pop_many(&event, 1), 0u);
+	CHECK_EQ(ring.get_free_space(), capacity);
+}
+
+OVERLAY_TEST(input_ring, events_come_in_order)
+{
+	overlay_input_ring ring;
+	for (int32_t i = 0; i < 10; i++)
+	{
+		CHECK(ring.push(make_event(i)));
+	}
+	CHECK_EQ(ring.get_free_space(), capacity - 10);
+
+	overlay_input_event event;
+	CHECK(ring.peek(event));
+	CHECK_EQ(event.code, 0);
+	// peek does not take event
+	CHECK(ring.pop(event));
+	CHECK_EQ(event.code, 0);
+	CHECK_EQ(event.x, 0);
+
+	overlay_input_event batch[4];
+	CHECK_EQ(ring.pop_many(batch, 4), 4u);
+	for (int32_t i = 0; i < 4; i++)
+	{
+		CHECK_EQ(batch[i].code, i + 1);
+	}
+
+	overlay_input_event rest[16];
+	CHECK_EQ(ring.pop_many(rest, 16), 5u);
+	CHECK_EQ(rest[4].code, 9);
+	CHECK_EQ(rest[4].x, 18);
+}
+
+OVERLAY_TEST(input_ring, full_ring_rejects_event)
+{
+	overlay_input_ring ring;
+	const int32_t last = static_cast<int32_t>(capacity);
+	for (int32_t i = 0; i < last; i++)
+	{
+		CHECK(ring.push(make_event(i)));
+	}
+	CHECK_EQ(ring.get_free_space(), 0u);
+	CHECK(!ring.push(make_event(last)));
+
+	// freed place is used again, ring wraps around
+	overlay_input_event event;
+	CHECK(ring.pop(event));
+	CHECK_EQ(event.code, 0);
+	CHECK(ring.push(make_event(last)));
+	CHECK(!ring.push(make_event(last + 1)));
+
+	std::vector<overlay_input_event> all(capacity);
+	CHECK_EQ(ring.pop_many(all.data(), all.size()), capacity);
+	CHECK_EQ(all.front().code, 1);
+	CHECK_EQ(all.back().code, last);
+}
+
+OVERLAY_TEST(input_ring, clear_drops_waiting_events)
+{
+	overlay_input_ring ring;
+	for (int32_t i = 0; i < 5; i++)
+	{
+		CHECK(ring.push(make_event(i)));
+	}
+	ring.clear();
+
+	overlay_input_event event;
+	CHECK(!ring.pop(event));
+	CHECK_EQ(ring.get_free_space(), capacity);
+	CHECK(ring.push(make_event(7)));
+	CHECK(ring.pop(event));
+	CHECK_EQ(event.code, 7);
+}
+
+// hook thread pushes while JS thread takes batches, no event is lost, duplicated or reordered
+OVERLAY_TEST(input_ring, producer_and_consumer_threads)
+{
+	overlay_input_ring ring;
+	const int32_t count = 200000;
+	std::atomic<bool> done {false};
+
+	std::thread producer([&]() {
+		for (int32_t i = 0; i < count;)
+		{
+			if (ring.push(make_event(i)))
+			{
+				i++;
+			} else
+			{
+				std::this_thread::yield();
+			}
+		}
+		done = true;
+	});
+
+	int32_t expected = 0;
+	int wrong = 0;
+	overlay_input_event batch[64];
+	while (true)
+	{
+		const bool finished = done.load();
+		const size_t taken = ring.pop_many(batch, 64);
+		for (size_t i = 0; i < taken; i++)
+		{
+			if (batch[i].code != expected || batch[i].x != expected * 2)
+			{
+				wrong++;
+			}
+			expected++;
+		}
+		if (taken == 0)
+		{
+			if (finished)
+			{
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	CHECK_EQ(wrong, 0);
+	CHECK_EQ(expected, count);
+}
+
+static overlay_input_event make_move(int32_t x)
+{
+	overlay_input_event event = {};
+	event.type = static_cast<int32_t>(overlay_input_type::mouse_move);
+	event.x = x;
+	event.count = 1;
+	return event;
+}
+
+static const size_t reserved_for_clicks = overlay_input_queue::reserved_for_clicks;
+static const size_t spill_capacity = overlay_input_queue::spill_capacity;
+
+static std::vector<overlay_input_event> take_all(overlay_input_queue& queue)
+{
+	std::vector<overlay_input_event> all;
+	overlay_input_event batch[100];
+	size_t taken = 0;
+	do
+	{
+		queue.flush();
+		taken = queue.pop_many(batch, 100);
+		all.insert(all.end(), batch, batch + taken);
+	} while (taken != 0);
+	return all;
+}
+
+OVERLAY_TEST(input_ring, queue_merges_moves_when_ring_is_full)
+{
+	overlay_input_queue queue;
+	const size_t moves_in_ring = capacity - reserved_for_clicks;
+	for (int32_t i = 0; i < static_cast<int32_t>(moves_in_ring) + 10; i++)
+	{
+		CHECK(queue.push(make_move(i)));
+	}
+	CHECK(queue.has_waiting());
+
+	std::vector<overlay_input_event> all(capacity);
+	CHECK_EQ(queue.pop_many(all.data(), all.size()), moves_in_ring);
+	CHECK_EQ(all[moves_in_ring - 1].x, static_cast<int32_t>(moves_in_ring) - 1);
+
+	// merged move goes to ring without new input, latest position and count of merged moves
+	CHECK(!queue.flush());
+	overlay_input_event event;
+	CHECK(queue.pop(event));
+	CHECK_EQ(event.x, static_cast<int32_t>(moves_in_ring) + 9);
+	CHECK_EQ(event.count, 10);
+	CHECK(!queue.pop(event));
+	CHECK_EQ(queue.get_dropped_count(), 0u);
+}
+
+OVERLAY_TEST(input_ring, queue_keeps_order_of_spilled_events)
+{
+	overlay_input_queue queue;
+	int32_t number = 0;
+	for (size_t i = 0; i < capacity + 20; i++)
+	{
+		CHECK(queue.push(make_event(number++)));
+	}
+	// move between clicks waits in spill too and does not jump ahead of them
+	CHECK(queue.push(make_move(1000)));
+	CHECK(queue.push(make_event(number++)));
+	CHECK(queue.has_waiting());
+
+	const std::vector<overlay_input_event> all = take_all(queue);
+	CHECK(!queue.has_waiting());
+	CHECK_EQ(all.size(), capacity + 22);
+	int32_t expected = 0;
+	for (const overlay_input_event& event : all)
+	{
+		if (event.type == static_cast<int32_t>(overlay_input_type::mouse_move))
+		{
+			CHECK_EQ(expected, static_cast<int32_t>(capacity) + 20);
+			CHECK_EQ(event.x, 1000);
+		} else
+		{
+			CHECK_EQ(event.code, expected++);
+		}
+	}
+}
+
+// clicks are never dropped, spill grows when there is no move to drop
+OVERLAY_TEST(input_ring, queue_grows_spill_for_clicks)
+{
+	overlay_input_queue queue;
+	const int32_t count = static_cast<int32_t>(capacity + spill_capacity * 3);
+	for (int32_t i = 0; i < count; i++)
+	{
+		CHECK(queue.push(make_event(i)));
+	}
+	CHECK_EQ(queue.get_dropped_count(), 0u);
+	CHECK(queue.get_spill_capacity() >= spill_capacity * 3);
+
+	const std::vector<overlay_input_event> all = take_all(queue);
+	CHECK_EQ(all.size(), static_cast<size_t>(count));
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		CHECK_EQ(all[i].code, static_cast<int32_t>(i));
+	}
+	CHECK(!queue.has_waiting());
+}
+
+// full spill makes room by dropping moves waiting between clicks before it grows
+OVERLAY_TEST(input_ring, queue_drops_spilled_moves_before_growing)
+{
+	overlay_input_queue queue;
+	int32_t number = 0;
+	for (size_t i = 0; i < capacity; i++)
+	{
+		CHECK(queue.push(make_event(number++)));
+	}
+	// each click pushes merged move before it to spill
+	const size_t pairs = spill_capacity / 2;
+	for (size_t i = 0; i < pairs; i++)
+	{
+		CHECK(queue.push(make_move(1000 + number)));
+		CHECK(queue.push(make_event(number++)));
+	}
+	CHECK_EQ(queue.get_dropped_count(), 0u);
+
+	// spill is full, move is dropped, then moves in spill are dropped to make room for the click
+	CHECK(queue.push(make_move(5000)));
+	CHECK(queue.push(make_move(5001)));
+	CHECK(!queue.push(make_event(number++)));
+	CHECK_EQ(queue.get_dropped_count(), static_cast<uint64_t>(pairs + 2));
+	CHECK_EQ(queue.get_spill_capacity(), spill_capacity);
+
+	const std::vector<overlay_input_event> all = take_all(queue);
+	CHECK_EQ(all.size(), static_cast<size_t>(number));
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		CHECK_EQ(all[i].type, static_cast<int32_t>(overlay_input_type::mouse_down));
+		CHECK_EQ(all[i].code, static_cast<int32_t>(i));
+	}
+}
+
+// hook thread pushes faster than JS takes, flushes on its own wake ups keep everything in order
+OVERLAY_TEST(input_ring, queue_with_slow_consumer_thread)
+{
+	overlay_input_queue queue;
+	const int32_t count = 20000;
+	std::atomic<bool> done {false};
+
+	std::thread producer([&]() {
+		for (int32_t i = 0; i < count; i++)
+		{
+			queue.push(i % 3 == 0 ? make_move(i) : make_event(i));
+			if (i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		while (queue.flush())
+		{
+			std::this_thread::yield();
+		}
+		done = true;
+	});
+
+	int32_t last = -1;
+	int32_t clicks = 0;
+	int wrong = 0;
+	overlay_input_event batch[16];
+	while (true)
+	{
+		const bool finished = done.load();
+		const size_t taken = queue.pop_many(batch, 16);
+		for (size_t i = 0; i < taken; i++)
+		{
+			const int32_t number = batch[i].type == static_cast<int32_t>(overlay_input_type::mouse_move) ? batch[i].x : batch[i].code;
+			wrong += number > last ? 0 : 1;
+			last = number;
+			clicks += batch[i].type == static_cast<int32_t>(overlay_input_type::mouse_move) ? 0 : 1;
+		}
+		if (taken == 0)
+		{
+			if (finished)
+			{
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	CHECK_EQ(wrong, 0);
+	CHECK_EQ(clicks, count - (count + 2) / 3);
+}
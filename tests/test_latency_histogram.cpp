@@ -0,0 +1,85 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_latency_histogram.h"
+#include "overlay_test.h"
+
+#include <memory>
+
+// values are known within 1/16 of them
+static bool is_close(uint64_t value, uint64_t expected)
+{
+	const uint64_t error = expected / 16;
+	return value + error >= expected && value <= expected + error;
+}
+
+OVERLAY_TEST(latency_histogram, empty_histogram)
+{
+	overlay_latency_histogram histogram;
+	CHECK_EQ(histogram.get_count(), 0u);
+	CHECK_EQ(histogram.get_max(), 0u);
+	CHECK_EQ(histogram.get_percentile(50.0), 0u);
+}
+
+OVERLAY_TEST(latency_histogram, small_values_are_exact)
+{
+	overlay_latency_histogram histogram;
+	for (uint64_t value = 0; value < 32; value++)
+	{
+		histogram.record(value);
+	}
+	CHECK_EQ(histogram.get_count(), 32u);
+	CHECK_EQ(histogram.get_max(), 31u);
+	CHECK_EQ(histogram.get_percentile(50.0), 15u);
+	CHECK_EQ(histogram.get_percentile(100.0), 31u);
+}
+
+OVERLAY_TEST(latency_histogram, percentiles_of_spread_values)
+{
+	overlay_latency_histogram histogram;
+	for (uint64_t value = 1; value <= 10000; value++)
+	{
+		histogram.record(value * 10);
+	}
+	CHECK(is_close(histogram.get_percentile(50.0), 50000));
+	CHECK(is_close(histogram.get_percentile(95.0), 95000));
+	CHECK(is_close(histogram.get_percentile(99.0), 99000));
+	CHECK_EQ(histogram.get_percentile(100.0), 100000u);
+	CHECK_EQ(histogram.get_max(), 100000u);
+
+	histogram.reset();
+	CHECK_EQ(histogram.get_count(), 0u);
+	CHECK_EQ(histogram.get_percentile(99.0), 0u);
+}
+
+// highest power of two range has its own buckets, values above it go to the last one.
+// histogram is on heap, so a bucket past the end is caught by address sanitizer
+OVERLAY_TEST(latency_histogram, largest_values_stay_in_buckets)
+{
+	const uint64_t largest = (1ull << 32) - 1;
+	std::unique_ptr<overlay_latency_histogram> histogram = std::make_unique<overlay_latency_histogram>();
+
+	histogram->record(1ull << 31);
+	histogram->record(largest);
+	CHECK_EQ(histogram->get_count(), 2u);
+	CHECK_EQ(histogram->get_max(), largest);
+	CHECK(is_close(histogram->get_percentile(50.0), 1ull << 31));
+	CHECK_EQ(histogram->get_percentile(100.0), largest);
+
+	histogram->record(1ull << 40);
+	CHECK_EQ(histogram->get_count(), 3u);
+	CHECK_EQ(histogram->get_max(), 1ull << 40);
+	CHECK_EQ(histogram->get_percentile(100.0), largest);
+	CHECK(is_close(histogram->get_percentile(30.0), 1ull << 31));
+}
@@ -0,0 +1,200 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_log_output.h"
+#include "overlay_logging.h"
+#include "overlay_test.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// empty directory for one test in system temp directory
+static fs::path make_test_directory(const char* name)
+{
+	const fs::path directory = fs::temp_directory_path() / "overlay_tests" / name;
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+	return directory;
+}
+
+static fs::path rotated(const fs::path& file, int index)
+{
+	fs::path path = file;
+	path += "." + std::to_string(index);
+	return path;
+}
+
+static std::string read_text(const fs::path& file)
+{
+	std::ifstream input(file, std::ios_base::binary);
+	return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+static std::vector<std::string> read_lines(const fs::path& file)
+{
+	std::vector<std::string> lines;
+	std::ifstream input(file);
+	std::string line;
+	while (std::getline(input, line))
+	{
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+OVERLAY_TEST(logging, time_is_formatted_as_date_and_time)
+{
+	char text[log_time_size];
+	const size_t length = format_log_time(text, std::time(nullptr));
+	CHECK_EQ(length, 16u);
+	CHECK_EQ(text[8], ':');
+	CHECK_EQ(text[15], '.');
+	for (size_t i = 0; i < length; i++)
+	{
+		CHECK(i == 8 || i == 15 || (text[i] >= '0' && text[i] <= '9'));
+	}
+}
+
+OVERLAY_TEST(logging, file_rotates_when_it_reaches_max_size)
+{
+	const fs::path file = make_test_directory("rotate_size") / "test.log";
+	const std::string line = std::string(99, 'a') + "\n";
+
+	overlay_log_file log_file;
+	CHECK(log_file.open(file, 1000, 3));
+	for (int i = 0; i < 9; i++)
+	{
+		log_file.write(line.data(), line.size());
+	}
+	log_file.flush();
+	CHECK_EQ(log_file.get_size(), 900u);
+	CHECK(!fs::exists(rotated(file, 1)));
+
+	// line which reaches max size is last in old file, next one starts new file
+	log_file.write(line.data(), line.size());
+	CHECK_EQ(log_file.get_size(), 0u);
+	CHECK_EQ(fs::file_size(rotated(file, 1)), 1000u);
+	log_file.write(line.data(), line.size());
+	log_file.flush();
+	CHECK_EQ(fs::file_size(file), 100u);
+}
+
+OVERLAY_TEST(logging, reopened_file_counts_existing_size)
+{
+	const fs::path file = make_test_directory("rotate_reopen") / "test.log";
+	const std::string line = std::string(49, 'b') + "\n";
+	{
+		overlay_log_file log_file;
+		CHECK(log_file.open(file, 1000, 2));
+		for (int i = 0; i < 15; i++)
+		{
+			log_file.write(line.data(), line.size());
+		}
+	}
+
+	overlay_log_file log_file;
+	CHECK(log_file.open(file, 1000, 2));
+	CHECK_EQ(log_file.get_size(), 750u);
+	for (int i = 0; i < 5; i++)
+	{
+		log_file.write(line.data(), line.size());
+	}
+	CHECK(fs::exists(rotated(file, 1)));
+	CHECK_EQ(log_file.get_size(), 0u);
+}
+
+OVERLAY_TEST(logging, rotation_keeps_only_newest_files)
+{
+	const fs::path file = make_test_directory("rotate_count") / "test.log";
+	overlay_log_file log_file;
+	CHECK(log_file.open(file, 7, 3));
+
+	// every line fills a file, so each one ends up in its own rotated file
+	for (int i = 0; i < 6; i++)
+	{
+		const std::string line = "line " + std::to_string(i) + "\n";
+		log_file.write(line.data(), line.size());
+	}
+	log_file.flush();
+
+	CHECK_EQ(read_text(rotated(file, 1)), std::string("line 5\n"));
+	CHECK_EQ(read_text(rotated(file, 2)), std::string("line 4\n"));
+	CHECK_EQ(read_text(rotated(file, 3)), std::string("line 3\n"));
+	CHECK(!fs::exists(rotated(file, 4)));
+	CHECK_EQ(fs::file_size(file), 0u);
+}
+
+OVERLAY_TEST(logging, rotate_with_missing_files)
+{
+	const fs::path file = make_test_directory("rotate_missing") / "test.log";
+	std::ofstream(rotated(file, 2)) << "old\n";
+
+	// gaps are kept, nothing throws when there is no current file
+	rotate_log_files(file, 3);
+	CHECK(!fs::exists(file));
+	CHECK(!fs::exists(rotated(file, 1)));
+	CHECK_EQ(read_text(rotated(file, 3)), std::string("old\n"));
+
+	rotate_log_files(file, 3);
+	CHECK(!fs::exists(rotated(file, 3)));
+	CHECK(!fs::exists(rotated(file, 4)));
+
+	std::ofstream(file) << "current\n";
+	rotate_log_files(file, 0);
+	CHECK(!fs::exists(file));
+	CHECK(!fs::exists(rotated(file, 1)));
+}
+
+// writer thread sleeps between lines, every line logged before logging_end is in the file after it
+OVERLAY_TEST(logging, lines_are_written_before_end)
+{
+	const fs::path file = make_test_directory("writer") / "test.log";
+	logging_start(file.string());
+	CHECK(logging_set_level("debug"));
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 3; t++)
+	{
+		threads.emplace_back([t]() {
+			for (int i = 0; i < 5; i++)
+			{
+				log_error << "thread " << t << " line " << i << std::endl;
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	log_error << "last line" << std::endl;
+	logging_end();
+
+	const std::vector<std::string> lines = read_lines(file);
+	CHECK_EQ(lines.size(), 16u);
+	CHECK(!lines.empty() && lines.back().find("ERR:") == 0);
+	CHECK(!lines.empty() && lines.back().find(": last line") != std::string::npos);
+
+	// logging is off after end
+	log_error << "after end" << std::endl;
+	CHECK_EQ(read_lines(file).size(), 16u);
+	CHECK(logging_set_level("info"));
+}
@@ -0,0 +1,197 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_pixel_kernels.h"
+#include "overlay_test.h"
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static const overlay_isa vector_isas[] = {overlay_isa::sse2, overlay_isa::avx2, overlay_isa::neon};
+
+// random pixels with extreme values mixed in, they are where rounding goes wrong
+static std::vector<uint8_t> random_pixels(size_t count, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<uint8_t> pixels(count * 4);
+	for (uint8_t& channel : pixels)
+	{
+		const unsigned int kind = random() % 8;
+		channel = kind == 0 ? 0 : kind == 1 ? 255 : static_cast<uint8_t>(random());
+	}
+	return pixels;
+}
+
+static std::vector<overlay_pixel_conversion> all_conversions()
+{
+	std::vector<overlay_pixel_conversion> conversions;
+	for (int swap = 0; swap < 2; swap++)
+	{
+		for (int premultiply = 0; premultiply < 2; premultiply++)
+		{
+			for (int global_alpha : {255, 254, 128, 77, 1, 0})
+			{
+				overlay_pixel_conversion conversion;
+				conversion.swap_red_blue = swap != 0;
+				conversion.premultiply = premultiply != 0;
+				conversion.global_alpha = static_cast<uint8_t>(global_alpha);
+				conversions.push_back(conversion);
+			}
+		}
+	}
+	return conversions;
+}
+
+static uint8_t reference_mul_div255(int x, int y)
+{
+	return static_cast<uint8_t>(floor(x * y / 255.0 + 0.5));
+}
+
+OVERLAY_TEST(pixel_kernels, scalar_matches_exact_math)
+{
+	const std::vector<uint8_t> src = random_pixels(4096, 1);
+	std::vector<uint8_t> dst(src.size());
+
+	for (const overlay_pixel_conversion& conversion : all_conversions())
+	{
+		CHECK(convert_pixels_for_isa(overlay_isa::scalar, dst.data(), src.data(), 4096, conversion));
+		for (size_t i = 0; i < src.size(); i += 4)
+		{
+			const int b = src[i + (conversion.swap_red_blue ? 2 : 0)];
+			const int g = src[i + 1];
+			const int r = src[i + (conversion.swap_red_blue ? 0 : 2)];
+			const int a = src[i + 3];
+			const int alpha = conversion.premultiply ? reference_mul_div255(a, conversion.global_alpha) : conversion.global_alpha;
+			const uint8_t expected[4] = {reference_mul_div255(b, alpha), reference_mul_div255(g, alpha), reference_mul_div255(r, alpha),
+			                             conversion.premultiply ? static_cast<uint8_t>(alpha) : reference_mul_div255(a, alpha)};
+			if (memcmp(dst.data() + i, expected, 4) != 0)
+			{
+				CHECK(memcmp(dst.data() + i, expected, 4) == 0);
+				break;
+			}
+		}
+	}
+}
+
+OVERLAY_TEST(pixel_kernels, known_pixels)
+{
+	const uint8_t src[8] = {255, 128, 0, 128, 10, 20, 30, 255};
+	uint8_t dst[8];
+
+	overlay_pixel_conversion premultiply;
+	premultiply.premultiply = true;
+	convert_pixels(dst, src, 2, premultiply);
+	const uint8_t premultiplied[8] = {128, 64, 0, 128, 10, 20, 30, 255};
+	CHECK(memcmp(dst, premultiplied, 8) == 0);
+
+	overlay_pixel_conversion swap;
+	swap.swap_red_blue = true;
+	convert_pixels(dst, src, 2, swap);
+	const uint8_t swapped[8] = {0, 128, 255, 128, 30, 20, 10, 255};
+	CHECK(memcmp(dst, swapped, 8) == 0);
+
+	// plain copy does not go through kernels
+	overlay_pixel_conversion copy;
+	CHECK(copy.is_copy());
+	convert_pixels(dst, src, 2, copy);
+	CHECK(memcmp(dst, src, 8) == 0);
+}
+
+// every width up to a few vectors, so each tail length of each version is used, at odd addresses
+OVERLAY_TEST(pixel_kernels, convert_matches_scalar_on_every_isa)
+{
+	const std::vector<uint8_t> src = random_pixels(1100, 2);
+	std::vector<uint8_t> expected(src.size() + 16);
+	std::vector<uint8_t> actual(src.size() + 16);
+
+	for (const overlay_pixel_conversion& conversion : all_conversions())
+	{
+		for (overlay_isa isa : vector_isas)
+		{
+			if (!cpu_has_isa(isa))
+			{
+				continue;
+			}
+
+			for (size_t count : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(5), size_t(7), size_t(9), size_t(15), size_t(17), size_t(31), size_t(33), size_t(63), size_t(1024), size_t(1099)})
+			{
+				for (size_t misalign : {size_t(0), size_t(1), size_t(3)})
+				{
+					memset(expected.data(), 0xCD, expected.size());
+					memset(actual.data(), 0xCD, actual.size());
+					convert_pixels_for_isa(overlay_isa::scalar, expected.data() + misalign, src.data() + misalign, count, conversion);
+					CHECK(convert_pixels_for_isa(isa, actual.data() + misalign, src.data() + misalign, count, conversion));
+					// bytes after the last pixel are not touched
+					if (memcmp(expected.data(), actual.data(), actual.size()) != 0)
+					{
+						CHECK(memcmp(expected.data(), actual.data(), actual.size()) == 0);
+						fprintf(stderr, "    isa %d, count %zu, misalign %zu\n", static_cast<int>(isa), count, misalign);
+					}
+				}
+			}
+		}
+	}
+}
+
+OVERLAY_TEST(pixel_kernels, convert_in_place)
+{
+	const std::vector<uint8_t> src = random_pixels(333, 3);
+	overlay_pixel_conversion conversion;
+	conversion.premultiply = true;
+	conversion.swap_red_blue = true;
+	conversion.global_alpha = 200;
+
+	std::vector<uint8_t> expected(src.size());
+	convert_pixels_for_isa(overlay_isa::scalar, expected.data(), src.data(), 333, conversion);
+
+	for (overlay_isa isa : {overlay_isa::scalar, overlay_isa::sse2, overlay_isa::avx2, overlay_isa::neon})
+	{
+		std::vector<uint8_t> pixels = src;
+		if (convert_pixels_for_isa(isa, pixels.data(), pixels.data(), 333, conversion))
+		{
+			CHECK(pixels == expected);
+		}
+	}
+}
+
+OVERLAY_TEST(pixel_kernels, mark_alpha_blocks_matches_scalar_on_every_isa)
+{
+	std::mt19937 random(4);
+	std::vector<uint8_t> pixels(130 * 16);
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		// mostly transparent, alpha set here and there in any of 4 pixels of a block
+		pixels[i] = (i % 4 == 3) ? (random() % 9 == 0 ? static_cast<uint8_t>(1 + random() % 255) : 0) : static_cast<uint8_t>(random());
+	}
+
+	for (size_t block_count = 0; block_count <= 130; block_count++)
+	{
+		std::vector<uint8_t> expected(block_count + 1, 0);
+		expected[block_count / 2] = 1; // blocks already marked stay marked
+		std::vector<uint8_t> initial = expected;
+		mark_alpha_blocks_for_isa(overlay_isa::scalar, expected.data(), pixels.data(), block_count);
+
+		for (overlay_isa isa : vector_isas)
+		{
+			std::vector<uint8_t> actual = initial;
+			if (mark_alpha_blocks_for_isa(isa, actual.data(), pixels.data(), block_count))
+			{
+				CHECK(actual == expected);
+			}
+		}
+	}
+}
@@ -0,0 +1,187 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_registry.h"
+#include "overlay_test.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+// registry only keeps pointers to overlays, a small stand-in is enough for these tests
+class overlay_window
+{
+	public:
+	int tag;
+
+	explicit overlay_window(int overlay_tag) : tag(overlay_tag) {}
+};
+
+static std::shared_ptr<overlay_window> make_overlay(int tag)
+{
+	return std::make_shared<overlay_window>(tag);
+}
+
+static const void* make_handle(int value)
+{
+	return reinterpret_cast<const void*>(static_cast<uintptr_t>(0x1000 + value * 16));
+}
+
+OVERLAY_TEST(registry, add_and_find)
+{
+	overlay_registry registry;
+	CHECK_EQ(registry.size(), 0u);
+	CHECK(registry.begin() == registry.end());
+
+	const int first = registry.add(make_overlay(1));
+	const int second = registry.add(make_overlay(2));
+	CHECK(first > 0);
+	CHECK(second > 0);
+	CHECK(first != second);
+	CHECK_EQ(registry.size(), 2u);
+
+	CHECK(registry.find(first) != nullptr && registry.find(first)->tag == 1);
+	CHECK(registry.find(second) != nullptr && registry.find(second)->tag == 2);
+	CHECK(registry.find(0) == nullptr);
+	CHECK(registry.find(-5) == nullptr);
+	CHECK(registry.find(first + second + 100) == nullptr);
+}
+
+OVERLAY_TEST(registry, removed_id_is_not_found_after_slot_reuse)
+{
+	overlay_registry registry;
+	const int first = registry.add(make_overlay(1));
+	CHECK(registry.remove(first));
+	CHECK(!registry.remove(first));
+	CHECK(registry.find(first) == nullptr);
+
+	// new overlay takes the freed slot with the next generation
+	const int reused = registry.add(make_overlay(2));
+	CHECK(reused != first);
+	CHECK(registry.find(first) == nullptr);
+	CHECK(registry.find(reused) != nullptr && registry.find(reused)->tag == 2);
+}
+
+OVERLAY_TEST(registry, remove_keeps_others_reachable)
+{
+	overlay_registry registry;
+	std::vector<int> ids;
+	for (int tag = 0; tag < 5; tag++)
+	{
+		ids.push_back(registry.add(make_overlay(tag)));
+	}
+
+	// first is replaced by the last one in dense array
+	CHECK(registry.remove(ids[0]));
+	CHECK_EQ(registry.size(), 4u);
+	for (int tag = 1; tag < 5; tag++)
+	{
+		CHECK(registry.find(ids[tag]) != nullptr && registry.find(ids[tag])->tag == tag);
+	}
+
+	std::vector<int> tags;
+	for (const std::shared_ptr<overlay_window>& overlay : registry)
+	{
+		tags.push_back(overlay->tag);
+	}
+	std::sort(tags.begin(), tags.end());
+	CHECK(tags == std::vector<int>({1, 2, 3, 4}));
+}
+
+OVERLAY_TEST(registry, window_binding)
+{
+	overlay_registry registry;
+	const int first = registry.add(make_overlay(1));
+	const int second = registry.add(make_overlay(2));
+	CHECK(registry.find_by_window(make_handle(1)) == nullptr);
+
+	CHECK(registry.bind_window(first, make_handle(1)));
+	CHECK(registry.bind_window(second, make_handle(2)));
+	CHECK(registry.find_by_window(make_handle(1)) != nullptr && registry.find_by_window(make_handle(1))->tag == 1);
+	CHECK(registry.find_by_window(make_handle(2)) != nullptr && registry.find_by_window(make_handle(2))->tag == 2);
+
+	// new window of the same overlay replaces the old one
+	CHECK(registry.bind_window(first, make_handle(3)));
+	CHECK(registry.find_by_window(make_handle(1)) == nullptr);
+	CHECK(registry.find_by_window(make_handle(3)) != nullptr && registry.find_by_window(make_handle(3))->tag == 1);
+
+	CHECK(registry.remove(first));
+	CHECK(registry.find_by_window(make_handle(3)) == nullptr);
+	CHECK(!registry.bind_window(first, make_handle(4)));
+
+	// window of moved overlay still finds it
+	CHECK(registry.find_by_window(make_handle(2)) != nullptr && registry.find_by_window(make_handle(2))->tag == 2);
+}
+
+OVERLAY_TEST(registry, full_registry_rejects_overlay)
+{
+	overlay_registry registry;
+	int added = 0;
+	int last_id = 0;
+	while (added < 10000)
+	{
+		const int id = registry.add(make_overlay(added));
+		if (id < 0)
+		{
+			break;
+		}
+		last_id = id;
+		added++;
+	}
+	CHECK_EQ(added, 4096);
+	CHECK_EQ(registry.size(), 4096u);
+
+	CHECK(registry.remove(last_id));
+	CHECK(registry.add(make_overlay(0)) > 0);
+}
+
+// registry against a map of live ids with random adds and removes
+OVERLAY_TEST(registry, random_adds_and_removes)
+{
+	std::mt19937 random(17);
+	overlay_registry registry;
+	std::map<int, int> live;
+	std::vector<int> removed;
+
+	for (int step = 0; step < 20000; step++)
+	{
+		if (live.empty() || (live.size() < 300 && random() % 2 == 0))
+		{
+			const int id = registry.add(make_overlay(step));
+			CHECK(id > 0);
+			CHECK(live.find(id) == live.end());
+			live[id] = step;
+		} else
+		{
+			auto victim = live.begin();
+			std::advance(victim, random() % live.size());
+			CHECK(registry.remove(victim->first));
+			removed.push_back(victim->first);
+			live.erase(victim);
+		}
+	}
+
+	CHECK_EQ(registry.size(), live.size());
+	for (const auto& entry : live)
+	{
+		CHECK(registry.find(entry.first) != nullptr && registry.find(entry.first)->tag == entry.second);
+	}
+	for (int id : removed)
+	{
+		if (live.find(id) == live.end())
+		{
+			CHECK(registry.find(id) == nullptr);
+		}
+	}
+}
@@ -0,0 +1,273 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_resampler.h"
+#include "overlay_test.h"
+
+#include <math.h>
+#include <random>
+#include <vector>
+
+struct test_image
+{
+	int width;
+	int height;
+	size_t pitch;
+	std::vector<uint8_t> pixels;
+
+	test_image(int image_width, int image_height, size_t padding = 0)
+	{
+		width = image_width;
+		height = image_height;
+		pitch = static_cast<size_t>(width) * 4 + padding;
+		pixels.assign(pitch * height, 0);
+	}
+
+	uint8_t& at(int x, int y, int c)
+	{
+		return pixels[y * pitch + x * 4 + c];
+	}
+};
+
+static test_image noise_image(int width, int height, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	test_image image(width, height);
+	for (uint8_t& channel : image.pixels)
+	{
+		channel = static_cast<uint8_t>(random());
+	}
+	return image;
+}
+
+// smooth content, where a good filter is close to the ideal one. Box filter takes whole source pixels,
+// so its result can be off by the change of content over about one source pixel
+static test_image gradient_image(int width, int height)
+{
+	test_image image(width, height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			image.at(x, y, 0) = static_cast<uint8_t>(255 * x / (width - 1));
+			image.at(x, y, 1) = static_cast<uint8_t>(255 * y / (height - 1));
+			image.at(x, y, 2) = static_cast<uint8_t>(127.5 + 127.5 * sin(x * 0.01) * cos(y * 0.013));
+			image.at(x, y, 3) = 255;
+		}
+	}
+	return image;
+}
+
+static test_image scale(const test_image& src, int width, int height)
+{
+	overlay_resampler resampler;
+	test_image dst(width, height);
+	resampler.scale(dst.pixels.data(), width, height, dst.pitch, src.pixels.data(), src.width, src.height, src.pitch);
+	return dst;
+}
+
+// bilinear with pixel centers matched and edge pixels repeated, in double precision
+static double reference_bilinear(test_image& src, double x, double y, int c)
+{
+	x = x < 0 ? 0 : x > src.width - 1 ? src.width - 1 : x;
+	y = y < 0 ? 0 : y > src.height - 1 ? src.height - 1 : y;
+	const int x0 = static_cast<int>(x);
+	const int y0 = static_cast<int>(y);
+	const int x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+	const int y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+	const double fx = x - x0;
+	const double fy = y - y0;
+	const double top = src.at(x0, y0, c) * (1 - fx) + src.at(x1, y0, c) * fx;
+	const double bottom = src.at(x0, y1, c) * (1 - fx) + src.at(x1, y1, c) * fx;
+	return top * (1 - fy) + bottom * fy;
+}
+
+// average of source area under destination pixel, partly covered pixels count by covered part
+static double reference_area(test_image& src, int dst_width, int dst_height, int x, int y, int c)
+{
+	const double scale_x = static_cast<double>(src.width) / dst_width;
+	const double scale_y = static_cast<double>(src.height) / dst_height;
+	const double left = x * scale_x;
+	const double right = (x + 1) * scale_x;
+	const double top = y * scale_y;
+	const double bottom = (y + 1) * scale_y;
+
+	double sum = 0;
+	for (int sy = static_cast<int>(top); sy < bottom && sy < src.height; sy++)
+	{
+		const double cover_y = fmin(bottom, sy + 1.0) - fmax(top, static_cast<double>(sy));
+		for (int sx = static_cast<int>(left); sx < right && sx < src.width; sx++)
+		{
+			const double cover_x = fmin(right, sx + 1.0) - fmax(left, static_cast<double>(sx));
+			sum += src.at(sx, sy, c) * cover_x * cover_y;
+		}
+	}
+	return sum / (scale_x * scale_y);
+}
+
+struct scale_error
+{
+	double max = 0;
+	double mean = 0;
+};
+
+static scale_error bilinear_error(test_image& src, int width, int height)
+{
+	test_image dst = scale(src, width, height);
+	scale_error error;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			const double sx = (x + 0.5) * src.width / width - 0.5;
+			const double sy = (y + 0.5) * src.height / height - 0.5;
+			for (int c = 0; c < 4; c++)
+			{
+				const double difference = fabs(dst.at(x, y, c) - reference_bilinear(src, sx, sy, c));
+				error.max = fmax(error.max, difference);
+				error.mean += difference;
+			}
+		}
+	}
+	error.mean /= width * height * 4.0;
+	return error;
+}
+
+static scale_error area_error(test_image& src, int width, int height)
+{
+	test_image dst = scale(src, width, height);
+	scale_error error;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				const double difference = fabs(dst.at(x, y, c) - reference_area(src, width, height, x, y, c));
+				error.max = fmax(error.max, difference);
+				error.mean += difference;
+			}
+		}
+	}
+	error.mean /= width * height * 4.0;
+	return error;
+}
+
+OVERLAY_TEST(resampler, same_size_is_exact)
+{
+	test_image src = noise_image(37, 23, 1);
+	test_image dst = scale(src, 37, 23);
+	CHECK(dst.pixels == src.pixels);
+}
+
+OVERLAY_TEST(resampler, flat_color_stays_flat)
+{
+	test_image src(50, 40);
+	for (size_t i = 0; i < src.pixels.size(); i += 4)
+	{
+		src.pixels[i] = 10;
+		src.pixels[i + 1] = 200;
+		src.pixels[i + 2] = 255;
+		src.pixels[i + 3] = 128;
+	}
+
+	for (int size : {1, 7, 24, 49, 51, 99, 200})
+	{
+		test_image dst = scale(src, size, size);
+		bool flat = true;
+		for (size_t i = 0; i < dst.pixels.size(); i += 4)
+		{
+			flat = flat && dst.pixels[i] == 10 && dst.pixels[i + 1] == 200 && dst.pixels[i + 2] == 255 && dst.pixels[i + 3] == 128;
+		}
+		CHECK(flat);
+	}
+}
+
+// 8 bit weights cost at most a couple of levels against exact bilinear, on noise which is the worst case
+OVERLAY_TEST(resampler, bilinear_is_close_to_reference)
+{
+	test_image src = noise_image(64, 48, 2);
+	const int sizes[][2] = {{100, 80}, {127, 49}, {65, 47}, {40, 30}, {256, 192}};
+	for (const auto& size : sizes)
+	{
+		const scale_error error = bilinear_error(src, size[0], size[1]);
+		CHECK(error.max <= 2.0);
+		CHECK(error.mean <= 0.6);
+	}
+}
+
+OVERLAY_TEST(resampler, box_is_exact_average_on_whole_ratios)
+{
+	test_image src = noise_image(120, 60, 3);
+	for (int ratio : {2, 3, 4, 5})
+	{
+		const scale_error error = area_error(src, 120 / ratio, 60 / ratio);
+		CHECK(error.max <= 0.5 + 1e-9);
+	}
+}
+
+OVERLAY_TEST(resampler, box_is_close_to_area_average)
+{
+	test_image src = gradient_image(1000, 700);
+	const int sizes[][2] = {{333, 233}, {480, 270}, {101, 77}};
+	for (const auto& size : sizes)
+	{
+		const scale_error error = area_error(src, size[0], size[1]);
+		CHECK(error.max <= 3.0);
+		CHECK(error.mean <= 1.0);
+	}
+}
+
+OVERLAY_TEST(resampler, tiny_sources_and_padding)
+{
+	test_image column = noise_image(1, 9, 4);
+	test_image wide = scale(column, 5, 9);
+	CHECK_EQ(wide.at(4, 8, 2), column.at(0, 8, 2));
+
+	// padding of destination rows is not written
+	test_image src = noise_image(30, 30, 5);
+	test_image dst(20, 20, 12);
+	for (uint8_t& channel : dst.pixels)
+	{
+		channel = 0xEE;
+	}
+	overlay_resampler resampler;
+	resampler.scale(dst.pixels.data(), 20, 20, dst.pitch, src.pixels.data(), 30, 30, src.pitch);
+	bool padding_kept = true;
+	for (int y = 0; y < 20; y++)
+	{
+		for (size_t i = 80; i < dst.pitch; i++)
+		{
+			padding_kept = padding_kept && dst.pixels[y * dst.pitch + i] == 0xEE;
+		}
+	}
+	CHECK(padding_kept);
+
+	// nothing to do for empty sizes
+	resampler.scale(dst.pixels.data(), 0, 20, dst.pitch, src.pixels.data(), 30, 30, src.pitch);
+	resampler.scale(dst.pixels.data(), 20, 20, dst.pitch, src.pixels.data(), 0, 30, src.pitch);
+}
+
+// one resampler used for several sizes rebuilds its tables
+OVERLAY_TEST(resampler, tables_follow_size_changes)
+{
+	test_image src = noise_image(80, 60, 6);
+	overlay_resampler resampler;
+	for (int size : {40, 100, 20, 100})
+	{
+		test_image dst(size, size);
+		resampler.scale(dst.pixels.data(), size, size, dst.pitch, src.pixels.data(), src.width, src.height, src.pitch);
+		CHECK(dst.pixels == scale(src, size, size).pixels);
+	}
+}
@@ -0,0 +1,278 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_shared_frames.h"
+#include "overlay_test.h"
+
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static std::string make_ring_name(const char* test_name)
+{
+	return std::string("overlay_test_") + test_name + "_" + std::to_string(overlay_test_now_ns());
+}
+
+// every pixel of a frame holds its tag and size comes from the tag, so a torn frame can be told from a whole one
+struct tagged_frame
+{
+	uint32_t tag;
+	int width;
+	int height;
+	std::vector<uint32_t> pixels;
+
+	tagged_frame(uint32_t writer, uint32_t counter)
+	{
+		tag = (writer << 24) | (counter & 0xFFFFFF);
+		width = width_of(tag);
+		height = height_of(tag);
+		pixels.assign(static_cast<size_t>(width) * height, tag);
+	}
+
+	static int width_of(uint32_t tag)
+	{
+		return 8 + static_cast<int>(tag % 57);
+	}
+	static int height_of(uint32_t tag)
+	{
+		return 8 + static_cast<int>((tag * 7) % 57);
+	}
+
+	bool write(overlay_shared_frames& frames) const
+	{
+		const shared_frame_rect rect = {0, 0, width, height};
+		return frames.write_frame(reinterpret_cast<const uint8_t*>(pixels.data()), static_cast<size_t>(width) * 4, width, height, &rect, 1);
+	}
+};
+
+static bool is_whole_tagged_frame(const shared_frame_view& frame)
+{
+	const uint32_t* pixels = reinterpret_cast<const uint32_t*>(frame.pixels);
+	const uint32_t tag = pixels[0];
+	if (frame.width != tagged_frame::width_of(tag) || frame.height != tagged_frame::height_of(tag))
+	{
+		return false;
+	}
+	if (frame.rect_count != 1 || frame.rects[0].right != frame.width || frame.rects[0].bottom != frame.height)
+	{
+		return false;
+	}
+
+	const size_t pixel_count = static_cast<size_t>(frame.width) * frame.height;
+	for (size_t i = 1; i < pixel_count; i++)
+	{
+		if (pixels[i] != tag)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+OVERLAY_TEST(shared_frames, create_and_open)
+{
+	const std::string name = make_ring_name("open");
+	overlay_shared_frames writer;
+	overlay_shared_frames reader;
+	CHECK(!reader.open(name));
+
+	CHECK(writer.create(name, 64, 64));
+	CHECK(writer.is_open());
+	CHECK(reader.open(name));
+
+	// name is taken while creator has it open
+	overlay_shared_frames other;
+	CHECK(!other.create(name, 64, 64));
+
+	reader.close();
+	writer.close();
+	CHECK(!reader.open(name));
+}
+
+OVERLAY_TEST(shared_frames, frame_goes_to_reader)
+{
+	const std::string name = make_ring_name("read");
+	overlay_shared_frames writer;
+	overlay_shared_frames reader;
+	CHECK(writer.create(name, 64, 64));
+	CHECK(reader.open(name));
+
+	shared_frame_view frame;
+	CHECK(!reader.read_begin(frame));
+
+	const tagged_frame first(1, 10);
+	CHECK(first.write(writer));
+	CHECK(reader.read_begin(frame));
+	CHECK(frame.whole);
+	CHECK(is_whole_tagged_frame(frame));
+	CHECK_EQ(reinterpret_cast<const uint32_t*>(frame.pixels)[0], first.tag);
+	CHECK(reader.read_end(frame));
+	CHECK(!reader.read_begin(frame));
+
+	// next frame in order keeps its rects
+	const tagged_frame second(1, 11);
+	CHECK(second.write(writer));
+	CHECK(reader.read_begin(frame));
+	CHECK(!frame.whole);
+	CHECK_EQ(reinterpret_cast<const uint32_t*>(frame.pixels)[0], second.tag);
+	CHECK(reader.read_end(frame));
+
+	// only newest of skipped frames is read and it is whole
+	const tagged_frame third(1, 12);
+	const tagged_frame fourth(1, 13);
+	CHECK(third.write(writer));
+	CHECK(fourth.write(writer));
+	CHECK(reader.read_begin(frame));
+	CHECK(frame.whole);
+	CHECK_EQ(reinterpret_cast<const uint32_t*>(frame.pixels)[0], fourth.tag);
+	CHECK(reader.read_end(frame));
+
+	reader.request_full_frame();
+	CHECK(reader.read_begin(frame));
+	CHECK(frame.whole);
+	CHECK_EQ(reinterpret_cast<const uint32_t*>(frame.pixels)[0], fourth.tag);
+	CHECK(reader.read_end(frame));
+}
+
+OVERLAY_TEST(shared_frames, rewritten_slot_fails_read_end)
+{
+	const std::string name = make_ring_name("rewrite");
+	overlay_shared_frames writer;
+	overlay_shared_frames reader;
+	CHECK(writer.create(name, 64, 64, 2));
+	CHECK(reader.open(name));
+
+	CHECK(tagged_frame(1, 1).write(writer));
+	shared_frame_view frame;
+	CHECK(reader.read_begin(frame));
+
+	// two more frames in a ring of two reuse the slot being read
+	CHECK(tagged_frame(1, 2).write(writer));
+	CHECK(tagged_frame(1, 3).write(writer));
+	CHECK(!reader.read_end(frame));
+
+	CHECK(reader.read_begin(frame));
+	CHECK(frame.whole);
+	CHECK(reader.read_end(frame));
+}
+
+OVERLAY_TEST(shared_frames, too_big_frame_is_rejected)
+{
+	const std::string name = make_ring_name("big");
+	overlay_shared_frames writer;
+	CHECK(writer.create(name, 16, 16));
+
+	std::vector<uint8_t> pixels(17 * 17 * 4);
+	CHECK(!writer.write_frame(pixels.data(), 17 * 4, 17, 16, nullptr, 0));
+	CHECK(!writer.write_frame(pixels.data(), 17 * 4, 16, 17, nullptr, 0));
+	CHECK(!writer.write_frame(pixels.data(), 15 * 4, 16, 16, nullptr, 0));
+	CHECK(writer.write_frame(pixels.data(), 17 * 4, 16, 16, nullptr, 0));
+}
+
+#ifndef _WIN32
+// Writers in other processes fill the ring as fast as they can while this process reads it.
+// Reader may lose any number of frames, but a frame accepted by read_end must never be torn.
+OVERLAY_TEST(shared_frames, torn_frames_are_never_accepted_across_processes)
+{
+	const int writer_count = 3;
+	const uint64_t write_time_ns = 400000000;
+	const std::string name = make_ring_name("stress");
+
+	overlay_shared_frames reader;
+	CHECK(reader.create(name, 64, 64));
+
+	fflush(stdout);
+	fflush(stderr);
+	std::vector<pid_t> writers;
+	for (int writer = 1; writer <= writer_count; writer++)
+	{
+		const pid_t pid = fork();
+		if (pid == 0)
+		{
+			overlay_shared_frames frames;
+			if (!frames.open(name))
+			{
+				_exit(2);
+			}
+			const uint64_t end = overlay_test_now_ns() + write_time_ns;
+			for (uint32_t counter = 0; overlay_test_now_ns() < end; counter++)
+			{
+				// all slots can be busy with other writers for a moment
+				while (!tagged_frame(writer, counter).write(frames))
+				{
+				}
+			}
+			_exit(0);
+		}
+		CHECK(pid > 0);
+		if (pid > 0)
+		{
+			writers.push_back(pid);
+		}
+	}
+
+	int accepted = 0;
+	int rejected = 0;
+	int torn_accepted = 0;
+	uint64_t last_frame_number = 0;
+	size_t running = writers.size();
+	while (running > 0)
+	{
+		shared_frame_view frame;
+		if (reader.read_begin(frame))
+		{
+			const bool whole = is_whole_tagged_frame(frame);
+			if (reader.read_end(frame))
+			{
+				accepted++;
+				torn_accepted += whole ? 0 : 1;
+				CHECK(frame.frame_number > last_frame_number);
+				last_frame_number = frame.frame_number;
+			} else
+			{
+				rejected++;
+			}
+		}
+
+		running = 0;
+		for (pid_t& pid : writers)
+		{
+			int status = 0;
+			if (pid != 0 && waitpid(pid, &status, WNOHANG) == pid)
+			{
+				CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+				pid = 0;
+			}
+			running += pid != 0 ? 1 : 0;
+		}
+	}
+
+	CHECK_EQ(torn_accepted, 0);
+	CHECK(accepted > 0);
+
+	// last frame is still there after writers are gone
+	shared_frame_view frame;
+	if (reader.read_begin(frame))
+	{
+		CHECK(is_whole_tagged_frame(frame));
+		CHECK(reader.read_end(frame));
+	}
+	printf("    %d frames accepted, %d rejected\n", accepted, rejected);
+}
+#endif
@@ -0,0 +1,108 @@
+/******************************************************************************
+    Copyright (C) 2016-2019 by Streamlabs (General Workings Inc)
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "overlay_stats.h"
+#include "overlay_test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+OVERLAY_TEST(stats, counters_start_at_zero)
+{
+	overlay_stats stats;
+	CHECK_EQ(overlay_stats::get(stats.frames_received), 0u);
+	CHECK_EQ(overlay_stats::get(stats.frames_applied), 0u);
+	CHECK_EQ(overlay_stats::get(stats.frames_dropped_hidden), 0u);
+	CHECK_EQ(overlay_stats::get(stats.frames_dropped_size), 0u);
+	CHECK_EQ(overlay_stats::get(stats.bytes_fitted), 0u);
+	CHECK_EQ(overlay_stats::get(stats.bytes_copied), 0u);
+	CHECK_EQ(overlay_stats::get(stats.bytes_uploaded), 0u);
+	CHECK_EQ(overlay_stats::get(stats.paint_calls), 0u);
+	CHECK_EQ(overlay_stats::get(stats.autohide_transitions), 0u);
+	CHECK_EQ(overlay_stats::get(stats.content_buffer_bytes), 0u);
+}
+
+OVERLAY_TEST(stats, add_counts_events_and_bytes)
+{
+	overlay_stats stats;
+	overlay_stats::add(stats.frames_received);
+	overlay_stats::add(stats.frames_received);
+	overlay_stats::add(stats.bytes_copied, 1920u * 1080u * 4u);
+	overlay_stats::add(stats.bytes_copied, 64u);
+
+	CHECK_EQ(overlay_stats::get(stats.frames_received), 2u);
+	CHECK_EQ(overlay_stats::get(stats.bytes_copied), 1920u * 1080u * 4u + 64u);
+	// counters are separate
+	CHECK_EQ(overlay_stats::get(stats.frames_applied), 0u);
+	CHECK_EQ(overlay_stats::get(stats.bytes_uploaded), 0u);
+}
+
+OVERLAY_TEST(stats, byte_counters_do_not_wrap_at_32_bits)
+{
+	overlay_stats stats;
+	const uint64_t frame_bytes = 3840u * 2160u * 4u;
+	for (int i = 0; i < 200; i++)
+	{
+		overlay_stats::add(stats.bytes_uploaded, frame_bytes);
+	}
+	CHECK_EQ(overlay_stats::get(stats.bytes_uploaded), frame_bytes * 200);
+}
+
+// producer, overlay thread and paint update counters at once, no update is lost
+// and a reader meanwhile never sees a counter go back
+OVERLAY_TEST(stats, threads_update_without_losing_counts)
+{
+	overlay_stats stats;
+	const int threads_count = 4;
+	const uint64_t per_thread = 100000;
+	std::atomic<bool> done {false};
+	int went_back = 0;
+
+	std::thread reader([&]() {
+		uint64_t last_received = 0;
+		uint64_t last_bytes = 0;
+		while (!done.load())
+		{
+			const uint64_t received = overlay_stats::get(stats.frames_received);
+			const uint64_t bytes = overlay_stats::get(stats.bytes_copied);
+			went_back += received < last_received || bytes < last_bytes ? 1 : 0;
+			last_received = received;
+			last_bytes = bytes;
+			std::this_thread::yield();
+		}
+	});
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threads_count; t++)
+	{
+		threads.emplace_back([&stats, per_thread]() {
+			for (uint64_t i = 0; i < per_thread; i++)
+			{
+				overlay_stats::add(stats.frames_received);
+				overlay_stats::add(stats.bytes_copied, 16);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	done = true;
+	reader.join();
+
+	CHECK_EQ(went_back, 0);
+	CHECK_EQ(overlay_stats::get(stats.frames_received), per_thread * threads_count);
+	CHECK_EQ(overlay_stats::get(stats.bytes_copied), per_thread * threads_count * 16);
+}